@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Mirror of the bindings xyapi makes, so calls that wouldn't change anything are dropped before they reach the driver.
+// It only holds while every bind goes through here; after code that binds on its own call invalidate().
+// Render thread only, like the context itself.
+namespace gl_state
+{
+	// Never a valid name, so a binding in this state is always issued.
+	static constexpr uint32_t UNKNOWN = UINT32_MAX;
+
+	enum class Call : uint32_t
+	{
+		Program,
+		VertexArray,
+		Buffer,
+		IndexedBuffer,
+		ActiveTexture,
+		Texture,
+		Sampler,
+		Count
+	};
+
+	struct Counter
+	{
+		uint32_t issued{0};
+		uint32_t skipped{0};
+	};
+
+	void use_program(uint32_t program);
+	void bind_vertex_array(uint32_t vertex_array);
+
+	// The element array binding is part of the bound vertex array and is tracked as such.
+	void bind_buffer(uint32_t target, uint32_t buffer);
+	void bind_buffer_base(uint32_t target, uint32_t index, uint32_t buffer);
+	void bind_buffer_range(uint32_t target, uint32_t index, uint32_t buffer, size_t offset, size_t size);
+
+	// Buffer last bound to target through here, UNKNOWN if there is no telling.
+	uint32_t get_buffer(uint32_t target);
+
+	// unit is GL_TEXTURE0 + index, like glActiveTexture; textures bind to the active unit.
+	void active_texture(uint32_t unit);
+	void bind_texture(uint32_t target, uint32_t texture);
+
+	// unit is the index of the texture unit.
+	void bind_sampler(uint32_t unit, uint32_t sampler);
+
+	// Called right before an object is deleted: GL unbinds it and may hand its name out again.
+	void forget_program(uint32_t program);
+	void forget_vertex_array(uint32_t vertex_array);
+	void forget_buffer(uint32_t buffer);
+	void forget_texture(uint32_t texture);
+	void forget_sampler(uint32_t sampler);
+
+	// Treats every binding as unknown, so the next bind of each is issued.
+	void invalidate();
+
+	const Counter& get_counter(Call call);
+	void reset_counters();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Work handed to the driver through xyapi since the last reset(), typically one frame's worth.
+// Render thread only, like the context itself.
+namespace gl_stats
+{
+	struct Stats
+	{
+		// Multi-draws count once per command. Their triangles live in a GPU buffer,
+		// so whoever filled it adds them with add_draw(0, triangles).
+		uint32_t draw_calls{0};
+		uint64_t triangles{0};
+
+		// Bytes copied from client memory into buffers and textures; copies within the GPU don't count.
+		uint32_t uploads{0};
+		uint64_t uploaded_bytes{0};
+	};
+
+	void add_draw(uint32_t draw_calls, uint64_t triangles);
+	void add_upload(size_t bytes);
+
+	// Like add_upload(), but skipped while a pixel unpack buffer is bound: the texels then come from GPU memory.
+	void add_texture_upload(size_t bytes);
+
+	// Bytes of an uncompressed image with the given pixel format and type.
+	size_t get_image_size(uint32_t width, uint32_t height, uint32_t format, uint32_t type);
+
+	const Stats& get();
+	void reset();
+}
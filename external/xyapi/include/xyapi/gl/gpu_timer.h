@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Measures GPU time of a frame and of named passes within it without ever waiting on the GPU. Queries of a
+// frame are read back FRAME_LATENCY frames later; if the GPU hasn't finished them by then, that frame's
+// results are dropped and the previous ones stay. Passes may nest. Without GL 3.3 or ARB_timer_query every call does nothing.
+class GpuTimer
+{
+public:
+	static constexpr uint32_t FRAME_LATENCY = 2;
+
+	struct Pass
+	{
+		// Must outlive the timer, in practice a string literal.
+		const char* name;
+
+		// Since the start of the frame, in milliseconds.
+		float start_ms;
+		float duration_ms;
+
+		uint32_t depth;
+	};
+
+	static bool is_supported();
+
+	GpuTimer() = default;
+	~GpuTimer();
+
+	// Everything between the two calls counts towards get_frame_ms().
+	void begin_frame();
+	void end_frame();
+
+	void begin(const char* name);
+	void end();
+
+	// Results of the latest frame the GPU has finished.
+	float get_frame_ms() const;
+	const std::vector<Pass>& get_passes() const;
+
+	// Frames whose results weren't ready in time.
+	uint32_t get_dropped_count() const;
+
+	class Scope
+	{
+	public:
+		Scope(GpuTimer& timer, const char* name) : timer{timer} { timer.begin(name); }
+		~Scope() { timer.end(); }
+
+	private:
+		GpuTimer& timer;
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+private:
+	struct PassQueries
+	{
+		const char* name;
+		uint32_t begin;
+		uint32_t end;
+		uint32_t depth;
+	};
+
+	struct Frame
+	{
+		// GL_TIME_ELAPSED over the frame and a timestamp at its start, which pass timestamps are relative to.
+		uint32_t elapsed{0};
+		uint32_t start{0};
+
+		std::vector<PassQueries> passes;
+		bool pending{false};
+	};
+
+	uint32_t acquire_query();
+	void read_back(Frame& frame);
+
+	Frame frames[FRAME_LATENCY];
+	uint32_t current{0};
+
+	std::vector<uint32_t> free_queries;
+	std::vector<uint32_t> all_queries;
+	std::vector<uint32_t> open_passes;
+
+	float frame_ms{0.0f};
+	std::vector<Pass> passes;
+	uint32_t dropped_count{0};
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Linked programs saved through glGetProgramBinary, so later runs skip compiling and linking their sources.
+// Binaries are keyed by the sources and the driver's vendor, renderer and version strings; a driver update or
+// another GPU misses the cache instead of loading what it can't use. Render thread only.
+namespace program_cache
+{
+	// Binaries go into this directory, created when the first one is stored. Empty (the default) disables the cache.
+	void set_directory(const std::string& directory);
+
+	// A directory is set and the driver has at least one binary format.
+	bool is_enabled();
+
+	uint64_t get_key(const std::vector<const std::string*>& sources);
+
+	// Loads the binary stored for key into program; false when there is none or the driver rejects it,
+	// in which case the program has to be built from source.
+	bool load(uint32_t program, uint64_t key);
+
+	// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+	void store(uint32_t program, uint64_t key);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gl_object.h"
+#include "texture.h"
+
+// Sampling state kept apart from the textures it is used with (glBindSampler), so one object
+// can be shared by every texture that samples the same way.
+class Sampler : public GLObject
+{
+public:
+	enum class Wrap
+	{
+		Repeat,
+		MirroredRepeat,
+		ClampToEdge
+	};
+
+	struct Description
+	{
+		Interpolation interpolation{ Interpolation::Linear };
+
+		// Blend between mip levels as well (trilinear with Linear interpolation).
+		bool mipmaps{ true };
+
+		Wrap wrap{ Wrap::Repeat };
+
+		// 1 disables anisotropic filtering; clamped to what the driver supports.
+		float anisotropy{ 1.0f };
+	};
+
+	Sampler(const Description& description);
+	~Sampler() override;
+
+	// Binds to texture unit 0.
+	void bind() override;
+	void unbind() override;
+
+	// unit is the index of the texture unit, not GL_TEXTURE0 + index.
+	void bind(uint32_t unit);
+	void unbind(uint32_t unit);
+
+	const Description& get_description() const;
+
+private:
+	Description description;
+
+	Sampler(const Sampler&) = delete;
+	Sampler& operator=(const Sampler&) = delete;
+};
@@ -1,30 +1,74 @@
 #pragma once
 
 #include <string>
+#include <stdint.h>
 #include <vector>
-#include <map>
+#include <utility>
 
 #include "gl_object.h"
 
+// Programs come from the program_cache when it has them and are built from source otherwise. With
+// GL_KHR_parallel_shader_compile the driver compiles on its own threads: construct shaders up front and only
+// the first bind() (or uniform) waits for the result, so several of them compile at once.
+// Uniforms are set through handles looked up once, setting one is a plain glUniform* call.
 class Shader : public GLObject
 {
 public:
-	Shader(const std::string& vs_code, const std::string& fs_code, const std::vector<std::string>& uniform_variables = {});
+	// Location of a uniform of one program, -1 if it isn't active there (setting it is then a no-op).
+	struct Uniform
+	{
+		int32_t location{-1};
+	};
+
+	Shader(const std::string& vs_code, const std::string& fs_code);
+
+	// Compute program, requires GL 4.3.
+	explicit Shader(const std::string& cs_code);
 	~Shader() override;
 
+	static bool is_compute_supported();
+	static bool is_parallel_compile_supported();
+
+	// Compiling and linking have finished, so using the program won't block. Always true without parallel compiles.
+	bool is_ready() const;
+
+	// Blocks until the program is ready. False if it failed to compile or link, the log went to error_callback.
+	bool is_linked();
+
+	// Exchanges the programs of two shaders, e.g. to put a rebuilt one in place of one that others point to.
+	// Uniform handles of either have to be resolved again.
+	void swap(Shader& other);
+
+	// Runs the bound compute program over a grid of work groups.
+	void dispatch(uint32_t groups_x, uint32_t groups_y = 1, uint32_t groups_z = 1) const;
+
 	void bind() override;
 	void unbind() override;
 
-	void set_uniform_vec2(const std::string& name, float* data);
-	void set_uniform_mat4(const std::string& name, float* data, uint32_t count = 1);
+	// Waits for the program like bind(), so resolve handles once after creating the shader rather than per use.
+	Uniform get_uniform(const std::string& name);
+
+	// The program has to be bound.
+	void set_uniform_int(Uniform uniform, int32_t value) const;
+	void set_uniform_vec2(Uniform uniform, const float* data) const;
+	void set_uniform_vec3(Uniform uniform, const float* data) const;
+	void set_uniform_mat4(Uniform uniform, const float* data, uint32_t count = 1) const;
 
 private:
-	uint32_t create_shader(const std::string code, uint32_t shader_type);
+	void build(const std::vector<std::pair<const std::string*, uint32_t>>& stages);
+	uint32_t create_shader(const std::string& code, uint32_t shader_type);
 	void link() const;
-	void create_uniforms(const std::vector<std::string>& uniform_variables);
 
-	uint32_t vs_handle;
-	uint32_t fs_handle;
+	// Checks the outcome of the build and stores the binary; runs once, on first use.
+	void finish();
+	bool check_stage(uint32_t stage) const;
+
+	uint32_t vs_handle{0};
+	uint32_t fs_handle{0};
+	uint32_t cs_handle{0};
 
-	std::map<std::string, int32_t> uniforms;
+	uint64_t cache_key{0};
+	bool cached{false};
+	bool finished{false};
+	bool linked{false};
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.h"
+
+// Permutations of one program, selected by a mask of feature bits. Bit i turns into #define defines[i] right after
+// the #version line of every stage, e.g. "BONE_INFLUENCES 2" or "BAKED_PALETTES", so the sources pick their code
+// paths with #if. Variants are built the first time they're asked for and kept, keyed by the mask; each has its
+// own sources, so the program_cache stores them separately. Bits that exclude each other are up to the caller.
+class ShaderVariants
+{
+public:
+	ShaderVariants(const std::string& vs_code, const std::string& fs_code, const std::vector<std::string>& defines);
+
+	// Stays valid as long as this object does. Building doesn't wait for the compile, see Shader.
+	Shader& get(uint32_t features);
+
+	uint32_t get_count() const;
+
+	// Rebuilds every variant from new sources. The current programs stay in use until all new ones are ready, then
+	// update() swaps them in, or drops them if any failed, so a broken edit leaves the working shaders running.
+	// Variants asked for from here on are built from the new sources.
+	void reload(const std::string& vs_code, const std::string& fs_code);
+
+	// Once per frame. True when it swapped in reloaded programs.
+	bool update();
+
+	// code with the defines of features inserted after its #version line; a #line keeps compiler messages pointing
+	// at the lines of the original source.
+	static std::string get_source(const std::string& code, const std::vector<std::string>& defines, uint32_t features);
+
+private:
+	std::string vs_code;
+	std::string fs_code;
+
+	const std::vector<std::string> defines;
+
+	std::unordered_map<uint32_t, std::unique_ptr<Shader>> variants;
+	std::unordered_map<uint32_t, std::unique_ptr<Shader>> reloaded;
+
+	ShaderVariants(const ShaderVariants&) = delete;
+	ShaderVariants& operator=(const ShaderVariants&) = delete;
+};
@@ -20,13 +20,42 @@ public:
 	using Parameter_t = std::function<void()>;
 	using Parameters_t = std::vector<Parameter_t>;
 
+	// Immutable storage for all mip levels at once (glTexStorage2D), filled afterwards level by level.
+	// format and type describe uncompressed uploads and are ignored for compressed internal formats.
+	struct Storage
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t levels;
+
+		int32_t internal_format;
+		uint32_t format;
+		uint32_t type;
+	};
+
 	Texture(uint32_t width, uint32_t height, Pixels_t data, int32_t internalFormat, uint32_t format, uint32_t type, Parameters_t params = {});
+	explicit Texture(const Storage& storage);
 	~Texture() override;
 
 	static Parameter_t set_interpolation(Interpolation interpolation);
 
+	// Levels of a full mip chain down to 1x1.
+	static uint32_t get_mip_count(uint32_t width, uint32_t height);
+
+	static bool is_compressed_format(int32_t internal_format);
+	static bool is_compressed_format_supported(int32_t internal_format);
+
+	// Not available for immutable storage.
 	void resize(uint32_t width, uint32_t height);
 
+	// Replace a region of a level; the texture has to be bound. With a pixel unpack buffer bound, data is an offset into it.
+	void update(uint32_t x, uint32_t y, uint32_t width, uint32_t height, Pixels_t data);
+	void update(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, Pixels_t data);
+	void update_compressed(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, size_t size, Pixels_t data);
+
+	// Fills levels 1 and up from level 0 on the GPU.
+	void generate_mipmaps();
+
 	void bind() override;
 	void bind(uint32_t unit);
 	void unbind() override;
@@ -34,6 +63,8 @@ public:
 
 	uint32_t get_width() const;
 	uint32_t get_height() const;
+	uint32_t get_levels() const;
+	int32_t get_internal_format() const;
 
 	
 protected:
@@ -43,6 +74,8 @@ protected:
 	uint32_t format;
 	uint32_t type;
 
+	uint32_t levels{1};
+
 private:
 	Texture(const Texture&) = delete;
 	Texture operator=(const Texture&) = delete;
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gl_object.h"
+#include "texture.h"
+
+// Layers of equally sized images in one GL_TEXTURE_2D_ARRAY with immutable storage,
+// so draws can pick an image per instance by layer instead of rebinding textures.
+class TextureArray : public GLObject
+{
+public:
+	struct Storage
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t layers;
+		uint32_t levels;
+
+		int32_t internal_format;
+		uint32_t format;
+		uint32_t type;
+	};
+
+	explicit TextureArray(const Storage& storage);
+	~TextureArray() override;
+
+	// Replace a whole level of one layer; the array has to be bound.
+	void update(uint32_t level, uint32_t layer, Texture::Pixels_t data);
+	void update_compressed(uint32_t level, uint32_t layer, size_t size, Texture::Pixels_t data);
+
+	// Copies every level of texture into layer on the GPU; size, format and level count have to match.
+	void copy(const Texture& texture, uint32_t layer);
+
+	void generate_mipmaps();
+
+	void bind() override;
+	void bind(uint32_t unit);
+	void unbind() override;
+	void unbind(uint32_t unit);
+
+	const Storage& get_storage() const;
+
+private:
+	Storage storage;
+
+	uint32_t get_level_width(uint32_t level) const;
+	uint32_t get_level_height(uint32_t level) const;
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+};
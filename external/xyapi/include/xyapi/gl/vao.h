@@ -16,6 +16,15 @@ public:
 
 	uint32_t get_vertex_count() const;
 
+	// Indexed draws of the whole index buffer; the VAO has to be bound. Indices are 16-bit when the index buffer's
+	// elements are two bytes, 32-bit otherwise.
+	void draw() const;
+	// base_instance offsets per-instance attributes (not gl_InstanceID), e.g. into the current copy of a persistent buffer.
+	void draw_instanced(uint32_t instance_count, uint32_t base_instance = 0) const;
+
+	// Multi-draw of draw_count DrawElementsIndirectCommand records, read from the bound DrawIndirect buffer at offset bytes.
+	void draw_indirect(uint32_t draw_count, size_t offset = 0) const;
+
 	template <typename... Args>
 	inline std::shared_ptr<VBO> add_vbo(Args... args)
 	{
@@ -1,14 +1,35 @@
+#pragma once
+
 #include "gl_object.h"
 
 #include <vector>
 #include <stdint.h>
 
+struct __GLsync;
+
 struct VertexBufferLayout 
 {
+	enum class ComponentType
+	{
+		Float,
+		HalfFloat,
+		Int8,
+		UInt8,
+		Int16,
+		UInt16,
+		Int32,
+		UInt32
+	};
+
 	size_t size   { 0 };
 	size_t stride { 0 };
 	size_t offset { 0 };
 	int divisor 	{ 0 };
+
+	// Integer components that are not normalized reach the shader as ints (glVertexAttribIPointer),
+	// normalized ones as floats mapped to [0, 1] or [-1, 1].
+	ComponentType type { ComponentType::Float };
+	bool normalized { false };
 };
 
 class VBO : public GLObject
@@ -18,22 +39,36 @@ public:
 	{
 		Static,
 		Dynamic,
-		Stream
+		Stream,
+
+		// Written by the CPU every frame through a persistent, coherent mapping (glBufferStorage). The buffer holds
+		// PERSISTENT_FRAME_COUNT copies of amount elements, so the CPU fills one while the GPU still reads the others.
+		Persistent
 	};
 
+	static constexpr uint32_t PERSISTENT_FRAME_COUNT = 3;
+
 	enum class Type
 	{
 		Array,
-		Indices
+		Indices,
+		Uniform,
+		ShaderStorage,
+		PixelUnpack,
+		DrawIndirect
 	};
 
 	VBO(uint32_t attribute, Type type, Usage usage, size_t amount = 0, size_t size = 0, const void *data = nullptr, std::vector<VertexBufferLayout> layouts = {});
 	~VBO() override;
 
+	// Usage::Persistent requires GL 4.4 or ARB_buffer_storage.
+	static bool is_persistent_supported();
+
 	void bind() override;
 	void unbind() override;
 
-	void store(void* data, int amount) const;
+	// Reallocates the buffer; not available for persistent buffers.
+	void store(const void* data, int amount) const;
 
 	template <typename T>
 	void store(const std::vector<T>& vec) const
@@ -41,7 +76,7 @@ public:
 		VBO::store(vec.data(), vec.size());
 	}
 
-	void update(void* data, int amount, int pos = 0) const;
+	void update(const void* data, int amount, int pos = 0) const;
 
 	template <typename T>
 	void update(const std::vector<T>& vec, int pos = 0) const
@@ -52,6 +87,22 @@ public:
 	void* map() const;
 	bool unmap() const;
 
+	// Persistent buffers only. begin_frame moves on to the next copy, waiting for the GPU to release it if it is still
+	// being read, and returns where to write its elements; no binding needed. end_frame fences that copy and goes after
+	// the last command that reads it. update(), bind_base() and bind_range() work on the current copy.
+	void* begin_frame();
+	void end_frame();
+
+	// First element of the current copy, e.g. the base instance selecting it for per-instance attributes.
+	uint32_t get_frame_element() const;
+
+	// Attaches the buffer (or amount elements of it starting at pos) to an indexed binding point. Uniform and ShaderStorage only.
+	void bind_base(uint32_t index) const;
+	void bind_range(uint32_t index, int amount, int pos = 0) const;
+
+	// Exposes a buffer of any type to shaders as a storage block, e.g. a vertex buffer read by a compute pass.
+	void bind_storage(uint32_t index) const;
+
 	uint32_t get_usage() const;
 	uint32_t get_type() const;
 	const std::vector<uint32_t> &get_used_attributes() const;
@@ -66,8 +117,18 @@ private:
 	uint32_t usage;
 	size_t size;
 
+	// Persistent buffers only; region_size is the byte size of one copy.
+	uint8_t* mapping{nullptr};
+	size_t region_size{0};
+	uint32_t frame{0};
+	std::vector<__GLsync*> fences;
+
+	size_t get_frame_offset() const;
+
 	static uint32_t vbo_usage_to_gl_usage(VBO::Usage vbo_usage);
 	static uint32_t vbo_type_to_gl_type(VBO::Type vbo_type);
+	static uint32_t component_type_to_gl_type(VertexBufferLayout::ComponentType component_type);
+	static bool is_integer_component(VertexBufferLayout::ComponentType component_type);
 
 	VBO(const VBO &) = delete;
 	VBO &operator=(const VBO &) = delete;
@@ -0,0 +1,208 @@
+#include "gl/gl_state.h"
+
+#include <GL/glew.h>
+
+#include <unordered_map>
+
+namespace gl_state
+{
+	struct IndexedBinding
+	{
+		uint32_t buffer{UNKNOWN};
+		size_t offset{0};
+		size_t size{0};
+	};
+
+	static uint64_t make_key(uint32_t a, uint32_t b)
+	{
+		return static_cast<uint64_t>(a) << 32 | b;
+	}
+
+	static uint32_t program{UNKNOWN};
+	static uint32_t vertex_array{UNKNOWN};
+	static uint32_t active_unit{UNKNOWN};
+
+	static std::unordered_map<uint32_t, uint32_t> buffers;
+	static std::unordered_map<uint64_t, IndexedBinding> indexed_buffers;
+	static std::unordered_map<uint64_t, uint32_t> textures;
+	static std::unordered_map<uint32_t, uint32_t> samplers;
+
+	static Counter counters[static_cast<uint32_t>(Call::Count)];
+
+	// Records value into binding; returns whether the GL call is needed.
+	static bool update(Call call, uint32_t& binding, uint32_t value)
+	{
+		Counter& counter = counters[static_cast<uint32_t>(call)];
+
+		if (binding == value)
+		{
+			counter.skipped++;
+			return false;
+		}
+
+		binding = value;
+		counter.issued++;
+		return true;
+	}
+
+	static uint32_t& find(std::unordered_map<uint32_t, uint32_t>& bindings, uint32_t key)
+	{
+		return bindings.try_emplace(key, UNKNOWN).first->second;
+	}
+
+	static uint32_t& find(std::unordered_map<uint64_t, uint32_t>& bindings, uint64_t key)
+	{
+		return bindings.try_emplace(key, UNKNOWN).first->second;
+	}
+
+	template <typename Map_t>
+	static void forget(Map_t& bindings, uint32_t name)
+	{
+		for (auto& [key, value] : bindings)
+			if (value == name)
+				value = 0;
+	}
+
+	void use_program(uint32_t value)
+	{
+		if (update(Call::Program, program, value))
+			glUseProgram(value);
+	}
+
+	void bind_vertex_array(uint32_t value)
+	{
+		if (update(Call::VertexArray, vertex_array, value))
+		{
+			glBindVertexArray(value);
+			find(buffers, GL_ELEMENT_ARRAY_BUFFER) = UNKNOWN;
+		}
+	}
+
+	void bind_buffer(uint32_t target, uint32_t buffer)
+	{
+		if (update(Call::Buffer, find(buffers, target), buffer))
+			glBindBuffer(target, buffer);
+	}
+
+	void bind_buffer_base(uint32_t target, uint32_t index, uint32_t buffer)
+	{
+		IndexedBinding& binding = indexed_buffers[make_key(target, index)];
+		Counter& counter = counters[static_cast<uint32_t>(Call::IndexedBuffer)];
+
+		if (binding.buffer == buffer && binding.size == 0)
+		{
+			counter.skipped++;
+			return;
+		}
+
+		binding = { buffer, 0, 0 };
+		counter.issued++;
+
+		glBindBufferBase(target, index, buffer);
+
+		// Also binds the generic binding point of target.
+		find(buffers, target) = buffer;
+	}
+
+	void bind_buffer_range(uint32_t target, uint32_t index, uint32_t buffer, size_t offset, size_t size)
+	{
+		IndexedBinding& binding = indexed_buffers[make_key(target, index)];
+		Counter& counter = counters[static_cast<uint32_t>(Call::IndexedBuffer)];
+
+		if (binding.buffer == buffer && binding.offset == offset && binding.size == size)
+		{
+			counter.skipped++;
+			return;
+		}
+
+		binding = { buffer, offset, size };
+		counter.issued++;
+
+		glBindBufferRange(target, index, buffer, offset, size);
+		find(buffers, target) = buffer;
+	}
+
+	uint32_t get_buffer(uint32_t target)
+	{
+		return find(buffers, target);
+	}
+
+	void active_texture(uint32_t unit)
+	{
+		if (update(Call::ActiveTexture, active_unit, unit))
+			glActiveTexture(unit);
+	}
+
+	void bind_texture(uint32_t target, uint32_t texture)
+	{
+		// Nothing is known about the unit until one has been made active through here.
+		if (active_unit == UNKNOWN)
+			active_texture(GL_TEXTURE0);
+
+		if (update(Call::Texture, find(textures, make_key(active_unit, target)), texture))
+			glBindTexture(target, texture);
+	}
+
+	void bind_sampler(uint32_t unit, uint32_t sampler)
+	{
+		if (update(Call::Sampler, find(samplers, unit), sampler))
+			glBindSampler(unit, sampler);
+	}
+
+	void forget_program(uint32_t value)
+	{
+		if (program == value)
+			program = 0;
+	}
+
+	void forget_vertex_array(uint32_t value)
+	{
+		if (vertex_array == value)
+		{
+			vertex_array = 0;
+			find(buffers, GL_ELEMENT_ARRAY_BUFFER) = UNKNOWN;
+		}
+	}
+
+	void forget_buffer(uint32_t buffer)
+	{
+		forget(buffers, buffer);
+
+		for (auto& [key, binding] : indexed_buffers)
+			if (binding.buffer == buffer)
+				binding = { 0, 0, 0 };
+	}
+
+	void forget_texture(uint32_t texture)
+	{
+		forget(textures, texture);
+	}
+
+	void forget_sampler(uint32_t sampler)
+	{
+		forget(samplers, sampler);
+	}
+
+	void invalidate()
+	{
+		program = UNKNOWN;
+		vertex_array = UNKNOWN;
+		active_unit = UNKNOWN;
+
+		buffers.clear();
+		indexed_buffers.clear();
+		textures.clear();
+		samplers.clear();
+	}
+
+	const Counter& get_counter(Call call)
+	{
+		return counters[static_cast<uint32_t>(call)];
+	}
+
+	void reset_counters()
+	{
+		for (Counter& counter : counters)
+			counter = {};
+	}
+}
@@ -0,0 +1,80 @@
+#include "gl/gl_stats.h"
+
+#include "gl/gl_state.h"
+
+#include <GL/glew.h>
+
+namespace gl_stats
+{
+	static Stats stats;
+
+	void add_draw(uint32_t draw_calls, uint64_t triangles)
+	{
+		stats.draw_calls += draw_calls;
+		stats.triangles += triangles;
+	}
+
+	void add_upload(size_t bytes)
+	{
+		stats.uploads++;
+		stats.uploaded_bytes += bytes;
+	}
+
+	void add_texture_upload(size_t bytes)
+	{
+		const uint32_t unpack_buffer = gl_state::get_buffer(GL_PIXEL_UNPACK_BUFFER);
+
+		if (unpack_buffer == 0 || unpack_buffer == gl_state::UNKNOWN)
+			add_upload(bytes);
+	}
+
+	static uint32_t get_component_count(uint32_t format)
+	{
+		switch (format)
+		{
+		case GL_RED:
+		case GL_RED_INTEGER:
+		case GL_DEPTH_COMPONENT:
+			return 1;
+		case GL_RG:
+		case GL_RG_INTEGER:
+			return 2;
+		case GL_RGB:
+		case GL_BGR:
+			return 3;
+		default:
+			return 4;
+		}
+	}
+
+	static uint32_t get_component_size(uint32_t type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE:
+		case GL_BYTE:
+			return 1;
+		case GL_UNSIGNED_SHORT:
+		case GL_SHORT:
+		case GL_HALF_FLOAT:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	size_t get_image_size(uint32_t width, uint32_t height, uint32_t format, uint32_t type)
+	{
+		return static_cast<size_t>(width) * height * get_component_count(format) * get_component_size(type);
+	}
+
+	const Stats& get()
+	{
+		return stats;
+	}
+
+	void reset()
+	{
+		stats = Stats();
+	}
+}
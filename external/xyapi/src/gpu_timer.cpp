@@ -0,0 +1,147 @@
+#include "gl/gpu_timer.h"
+
+#include <GL/glew.h>
+
+bool GpuTimer::is_supported()
+{
+	return GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+}
+
+GpuTimer::~GpuTimer()
+{
+	if (!all_queries.empty())
+		glDeleteQueries(static_cast<GLsizei>(all_queries.size()), all_queries.data());
+}
+
+uint32_t GpuTimer::acquire_query()
+{
+	if (free_queries.empty())
+	{
+		uint32_t query;
+		glGenQueries(1, &query);
+		all_queries.push_back(query);
+
+		return query;
+	}
+
+	const uint32_t query = free_queries.back();
+	free_queries.pop_back();
+
+	return query;
+}
+
+void GpuTimer::read_back(Frame& frame)
+{
+	// Queries complete in order, so the frame is done once the elapsed query, which ends last, is.
+	GLint available = 0;
+	glGetQueryObjectiv(frame.elapsed, GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (!available)
+	{
+		dropped_count++;
+		return;
+	}
+
+	GLuint64 elapsed, start;
+	glGetQueryObjectui64v(frame.elapsed, GL_QUERY_RESULT, &elapsed);
+	glGetQueryObjectui64v(frame.start, GL_QUERY_RESULT, &start);
+
+	frame_ms = elapsed / 1e6f;
+	passes.clear();
+
+	for (const PassQueries& queries : frame.passes)
+	{
+		GLuint64 begin, end;
+		glGetQueryObjectui64v(queries.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(queries.end, GL_QUERY_RESULT, &end);
+
+		passes.push_back({ queries.name, (begin - start) / 1e6f, (end - begin) / 1e6f, queries.depth });
+	}
+}
+
+void GpuTimer::begin_frame()
+{
+	if (!is_supported())
+		return;
+
+	current = (current + 1) % FRAME_LATENCY;
+	Frame& frame = frames[current];
+
+	if (frame.pending)
+	{
+		read_back(frame);
+
+		for (const PassQueries& queries : frame.passes)
+		{
+			free_queries.push_back(queries.begin);
+			free_queries.push_back(queries.end);
+		}
+
+		frame.passes.clear();
+		frame.pending = false;
+	}
+
+	if (!frame.elapsed)
+	{
+		frame.elapsed = acquire_query();
+		frame.start = acquire_query();
+	}
+
+	glQueryCounter(frame.start, GL_TIMESTAMP);
+	glBeginQuery(GL_TIME_ELAPSED, frame.elapsed);
+}
+
+void GpuTimer::end_frame()
+{
+	if (!is_supported())
+		return;
+
+	// Passes left open are closed here so their queries are complete.
+	while (!open_passes.empty())
+		end();
+
+	glEndQuery(GL_TIME_ELAPSED);
+	frames[current].pending = true;
+}
+
+void GpuTimer::begin(const char* name)
+{
+	if (!is_supported())
+		return;
+
+	Frame& frame = frames[current];
+
+	// Unlike GL_TIME_ELAPSED, timestamps can nest and overlap the frame query.
+	PassQueries& queries = frame.passes.emplace_back();
+	queries.name = name;
+	queries.begin = acquire_query();
+	queries.end = acquire_query();
+	queries.depth = open_passes.size();
+
+	glQueryCounter(queries.begin, GL_TIMESTAMP);
+	open_passes.push_back(frame.passes.size() - 1);
+}
+
+void GpuTimer::end()
+{
+	if (!is_supported() || open_passes.empty())
+		return;
+
+	glQueryCounter(frames[current].passes[open_passes.back()].end, GL_TIMESTAMP);
+	open_passes.pop_back();
+}
+
+float GpuTimer::get_frame_ms() const
+{
+	return frame_ms;
+}
+
+const std::vector<GpuTimer::Pass>& GpuTimer::get_passes() const
+{
+	return passes;
+}
+
+uint32_t GpuTimer::get_dropped_count() const
+{
+	return dropped_count;
+}
@@ -0,0 +1,152 @@
+#include "gl/program_cache.h"
+#include "common.h"
+
+#include <GL/glew.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace program_cache
+{
+	static constexpr uint32_t MAGIC = 0x42505958; // "XYPB"
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t format;
+		uint64_t key;
+	};
+
+	static std::string cache_directory;
+
+	static uint64_t hash(uint64_t seed, const std::string& data)
+	{
+		// FNV-1a.
+		for (const char c : data)
+			seed = (seed ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+
+		// Separates consecutive strings, so "ab" + "c" and "a" + "bc" differ.
+		return (seed ^ 0xff) * 1099511628211ull;
+	}
+
+	static const std::string& get_driver()
+	{
+		static const std::string driver = []()
+		{
+			std::string result;
+
+			for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+			{
+				const GLubyte* value = glGetString(name);
+				result += value ? reinterpret_cast<const char*>(value) : "";
+				result += '\n';
+			}
+
+			return result;
+		}();
+
+		return driver;
+	}
+
+	static std::string get_path(uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+
+		return (std::filesystem::path(cache_directory) / name).string();
+	}
+
+	void set_directory(const std::string& directory)
+	{
+		cache_directory = directory;
+	}
+
+	bool is_enabled()
+	{
+		if (cache_directory.empty() || !(GLEW_ARB_get_program_binary || GLEW_VERSION_4_1))
+			return false;
+
+		GLint format_count = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+		return format_count > 0;
+	}
+
+	uint64_t get_key(const std::vector<const std::string*>& sources)
+	{
+		uint64_t key = hash(14695981039346656037ull, get_driver());
+
+		for (const std::string* source : sources)
+			key = hash(key, *source);
+
+		return key;
+	}
+
+	bool load(uint32_t program, uint64_t key)
+	{
+		if (!is_enabled())
+			return false;
+
+		std::ifstream file(get_path(key), std::ios::binary | std::ios::ate);
+
+		if (!file.is_open())
+			return false;
+
+		const std::streamoff size = file.tellg();
+
+		if (size <= static_cast<std::streamoff>(sizeof(FileHeader)))
+			return false;
+
+		FileHeader header;
+		std::vector<char> binary(size - sizeof(FileHeader));
+
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		file.read(binary.data(), binary.size());
+
+		if (!file || header.magic != MAGIC || header.key != key)
+			return false;
+
+		glProgramBinary(program, header.format, binary.data(), binary.size());
+
+		// Drivers reject binaries of other versions or after internal changes, at which point the program is just unlinked.
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+		return status == GL_TRUE;
+	}
+
+	void store(uint32_t program, uint64_t key)
+	{
+		if (!is_enabled())
+			return;
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0)
+			return;
+
+		FileHeader header{ MAGIC, 0, key };
+		std::vector<char> binary(length);
+
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		header.format = format;
+
+		std::error_code error;
+		std::filesystem::create_directories(cache_directory, error);
+
+		std::ofstream file(get_path(key), std::ios::binary);
+
+		if (!file.is_open())
+		{
+			warning_callback("Failed to write program binary " + get_path(key));
+			return;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), length);
+	}
+}
@@ -0,0 +1,80 @@
+#include "gl/sampler.h"
+
+#include "gl/gl_state.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+
+static GLint wrap_to_gl_wrap(Sampler::Wrap wrap)
+{
+	switch (wrap)
+	{
+	case Sampler::Wrap::Repeat:
+		return GL_REPEAT;
+	case Sampler::Wrap::MirroredRepeat:
+		return GL_MIRRORED_REPEAT;
+	case Sampler::Wrap::ClampToEdge:
+		return GL_CLAMP_TO_EDGE;
+	}
+
+	return GL_REPEAT;
+}
+
+Sampler::Sampler(const Description& description) : description{description}
+{
+	glGenSamplers(1, &handle);
+
+	const bool linear = description.interpolation == Interpolation::Linear;
+
+	GLint min_filter = linear ? GL_LINEAR : GL_NEAREST;
+
+	if (description.mipmaps)
+		min_filter = linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST;
+
+	glSamplerParameteri(handle, GL_TEXTURE_MIN_FILTER, min_filter);
+	glSamplerParameteri(handle, GL_TEXTURE_MAG_FILTER, linear ? GL_LINEAR : GL_NEAREST);
+
+	const GLint wrap = wrap_to_gl_wrap(description.wrap);
+	glSamplerParameteri(handle, GL_TEXTURE_WRAP_S, wrap);
+	glSamplerParameteri(handle, GL_TEXTURE_WRAP_T, wrap);
+
+	if (description.anisotropy > 1.0f && GLEW_EXT_texture_filter_anisotropic)
+	{
+		GLfloat max_anisotropy = 1.0f;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+
+		glSamplerParameterf(handle, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(description.anisotropy, max_anisotropy));
+	}
+}
+
+Sampler::~Sampler()
+{
+	gl_state::forget_sampler(handle);
+	glDeleteSamplers(1, &handle);
+}
+
+void Sampler::bind()
+{
+	bind(0);
+}
+
+void Sampler::unbind()
+{
+	unbind(0);
+}
+
+void Sampler::bind(uint32_t unit)
+{
+	gl_state::bind_sampler(unit, handle);
+}
+
+void Sampler::unbind(uint32_t unit)
+{
+	gl_state::bind_sampler(unit, 0);
+}
+
+const Sampler::Description& Sampler::get_description() const
+{
+	return description;
+}
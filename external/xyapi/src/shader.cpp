@@ -1,39 +1,129 @@
 #include "gl/shader.h"
 #include "common.h"
 
+#include "gl/gl_state.h"
+#include "gl/program_cache.h"
+
 #include <GL/glew.h>
 
-Shader::Shader(const std::string& vs_code, const std::string& fs_code, const std::vector<std::string>& uniform_variables)
+Shader::Shader(const std::string& vs_code, const std::string& fs_code)
 {
-	handle = glCreateProgram();
+	build({ { &vs_code, GL_VERTEX_SHADER }, { &fs_code, GL_FRAGMENT_SHADER } });
+}
 
-	vs_handle = create_shader(vs_code, GL_VERTEX_SHADER);
-	fs_handle = create_shader(fs_code, GL_FRAGMENT_SHADER);
-	link();
-	create_uniforms(uniform_variables);
+Shader::Shader(const std::string& cs_code)
+{
+	build({ { &cs_code, GL_COMPUTE_SHADER } });
 }
 
 Shader::~Shader()
 {
 	unbind();
-	glDetachShader(handle, vs_handle);
-	glDetachShader(handle, fs_handle);
+	// Stages are detached once the build is checked, unused programs still have them attached; deleting a 0 handle is a no-op.
 	glDeleteShader(vs_handle);
 	glDeleteShader(fs_handle);
+	glDeleteShader(cs_handle);
+	gl_state::forget_program(handle);
 	glDeleteProgram(handle);
 }
 
+bool Shader::is_compute_supported()
+{
+	return GLEW_VERSION_4_3;
+}
+
+bool Shader::is_parallel_compile_supported()
+{
+	return GLEW_KHR_parallel_shader_compile;
+}
+
+bool Shader::is_ready() const
+{
+	if (finished || !is_parallel_compile_supported())
+		return true;
+
+	GLint done = GL_TRUE;
+	glGetProgramiv(handle, GL_COMPLETION_STATUS_KHR, &done);
+
+	return done == GL_TRUE;
+}
+
+bool Shader::is_linked()
+{
+	finish();
+
+	return linked;
+}
+
+void Shader::swap(Shader& other)
+{
+	std::swap(handle, other.handle);
+	std::swap(vs_handle, other.vs_handle);
+	std::swap(fs_handle, other.fs_handle);
+	std::swap(cs_handle, other.cs_handle);
+	std::swap(cache_key, other.cache_key);
+	std::swap(cached, other.cached);
+	std::swap(finished, other.finished);
+	std::swap(linked, other.linked);
+}
+
+void Shader::build(const std::vector<std::pair<const std::string*, uint32_t>>& stages)
+{
+	// Lets the driver pick how many threads it compiles on.
+	static bool threads_set = false;
+
+	if (!threads_set && is_parallel_compile_supported())
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+	threads_set = true;
+
+	handle = glCreateProgram();
+
+	std::vector<const std::string*> sources;
+
+	for (const std::pair<const std::string*, uint32_t>& stage : stages)
+		sources.push_back(stage.first);
+
+	cache_key = program_cache::get_key(sources);
+	cached = program_cache::load(handle, cache_key);
+
+	if (cached)
+		return;
+
+	for (const std::pair<const std::string*, uint32_t>& stage : stages)
+	{
+		const uint32_t shader = create_shader(*stage.first, stage.second);
+
+		switch (stage.second)
+		{
+		case GL_VERTEX_SHADER: vs_handle = shader; break;
+		case GL_FRAGMENT_SHADER: fs_handle = shader; break;
+		case GL_COMPUTE_SHADER: cs_handle = shader; break;
+		}
+	}
+
+	link();
+}
+
+void Shader::dispatch(uint32_t groups_x, uint32_t groups_y, uint32_t groups_z) const
+{
+	glDispatchCompute(groups_x, groups_y, groups_z);
+}
+
 void Shader::bind()
 {
-	glUseProgram(handle);
+	finish();
+
+	gl_state::use_program(handle);
 }
 
 void Shader::unbind()
 {
-	glUseProgram(0);
+	gl_state::use_program(0);
 }
 
-GLuint Shader::create_shader(const std::string code, GLuint shader_type)
+// Statuses aren't queried here, that would wait for the compile and serialize shaders the driver could build in parallel.
+GLuint Shader::create_shader(const std::string& code, GLuint shader_type)
 {
 	const unsigned int shader_id = glCreateShader(shader_type);
 
@@ -42,65 +132,113 @@ GLuint Shader::create_shader(const std::string code, GLuint shader_type)
 	glShaderSource(shader_id, 1, &c_str, NULL);
 	glCompileShader(shader_id);
 
+	glAttachShader(handle, shader_id);
+
+	return shader_id;
+}
+
+void Shader::link() const
+{
+	if (program_cache::is_enabled())
+		glProgramParameteri(handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	glLinkProgram(handle);
+}
+
+bool Shader::check_stage(GLuint stage) const
+{
+	if (stage == 0)
+		return true;
+
 	int status;
-	glGetShaderiv(shader_id, GL_COMPILE_STATUS, &status);
+	glGetShaderiv(stage, GL_COMPILE_STATUS, &status);
 
 	if (!status)
 	{
 		int length;
-		glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &length);
+		glGetShaderiv(stage, GL_INFO_LOG_LENGTH, &length);
 		std::string log;
 		log.resize(length);
-		glGetShaderInfoLog(shader_id, length, &length, &log[0]);
-
-		std::string errorFunctionName = "--------[ " __FUNCTION__ " ]--------";
-		std::string separator; for (size_t i = 0; i < errorFunctionName.size(); i++) separator += "-";
-
-		info_callback(log);
+		glGetShaderInfoLog(stage, length, &length, &log[0]);
 
-		return -1;
+		error_callback(log);
 	}
 
-	glAttachShader(handle, shader_id);
-
-	return shader_id;
+	return status;
 }
 
-void Shader::link() const
+void Shader::finish()
 {
-	glLinkProgram(handle);
+	if (finished)
+		return;
 
-	if (vs_handle != 0)
-	{
-		glDetachShader(handle, vs_handle);
-	}
+	finished = true;
 
-	if (fs_handle != 0)
+	if (cached)
 	{
-		glDetachShader(handle, fs_handle);
+		linked = true;
 	}
+	else
+	{
+		const bool compiled = check_stage(vs_handle) & check_stage(fs_handle) & check_stage(cs_handle);
 
-	glValidateProgram(handle);
-}
+		int status;
+		glGetProgramiv(handle, GL_LINK_STATUS, &status);
+		linked = status;
 
-void Shader::create_uniforms(const std::vector<std::string>& uniform_variables)
-{
-	for (int i = 0; i < uniform_variables.size(); i++)
-	{
-		int32_t location = glGetUniformLocation(handle, uniform_variables[i].c_str());
-		if (location != -1)
+		// Stage errors already explain a failed link.
+		if (compiled && !linked)
 		{
-			uniforms[uniform_variables[i]] = location;
+			int length;
+			glGetProgramiv(handle, GL_INFO_LOG_LENGTH, &length);
+			std::string log;
+			log.resize(length);
+			glGetProgramInfoLog(handle, length, &length, &log[0]);
+
+			error_callback(log);
 		}
+
+		for (const GLuint stage : { vs_handle, fs_handle, cs_handle })
+			if (stage != 0)
+				glDetachShader(handle, stage);
+
+		if (linked)
+			program_cache::store(handle, cache_key);
 	}
 }
 
-void Shader::set_uniform_vec2(const std::string& name, float* data)
+Shader::Uniform Shader::get_uniform(const std::string& name)
+{
+	finish();
+
+	Uniform uniform;
+
+	if (linked)
+		uniform.location = glGetUniformLocation(handle, name.c_str());
+
+	// Also the case for uniforms the compiler dropped because nothing reads them.
+	if (linked && uniform.location == -1)
+		warning_callback("Uniform " + name + " is not active in program " + std::to_string(handle));
+
+	return uniform;
+}
+
+void Shader::set_uniform_int(Uniform uniform, int32_t value) const
+{
+	glUniform1i(uniform.location, value);
+}
+
+void Shader::set_uniform_vec2(Uniform uniform, const float* data) const
+{
+	glUniform2f(uniform.location, data[0], data[1]);
+}
+
+void Shader::set_uniform_vec3(Uniform uniform, const float* data) const
 {
-	glUniform2f(uniforms[name], data[0], data[1]);
+	glUniform3f(uniform.location, data[0], data[1], data[2]);
 }
 
-void Shader::set_uniform_mat4(const std::string& name, float* data, uint32_t count)
+void Shader::set_uniform_mat4(Uniform uniform, const float* data, uint32_t count) const
 {
-	glUniformMatrix4fv(uniforms[name], count, GL_FALSE, data);
+	glUniformMatrix4fv(uniform.location, count, GL_FALSE, data);
 }
\ No newline at end of file
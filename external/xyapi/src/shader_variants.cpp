@@ -0,0 +1,101 @@
+#include "gl/shader_variants.h"
+#include "common.h"
+
+#include <algorithm>
+
+ShaderVariants::ShaderVariants(const std::string& vs_code, const std::string& fs_code, const std::vector<std::string>& defines) : vs_code{vs_code}, fs_code{fs_code}, defines{defines}
+{
+}
+
+Shader& ShaderVariants::get(uint32_t features)
+{
+	std::unique_ptr<Shader>& variant = variants[features];
+
+	if (!variant)
+		variant = std::make_unique<Shader>(get_source(vs_code, defines, features), get_source(fs_code, defines, features));
+
+	return *variant;
+}
+
+uint32_t ShaderVariants::get_count() const
+{
+	return variants.size();
+}
+
+void ShaderVariants::reload(const std::string& p_vs_code, const std::string& p_fs_code)
+{
+	vs_code = p_vs_code;
+	fs_code = p_fs_code;
+
+	// Replaces a reload still compiling.
+	reloaded.clear();
+
+	for (const std::pair<const uint32_t, std::unique_ptr<Shader>>& variant : variants)
+		reloaded[variant.first] = std::make_unique<Shader>(get_source(vs_code, defines, variant.first), get_source(fs_code, defines, variant.first));
+}
+
+bool ShaderVariants::update()
+{
+	if (reloaded.empty())
+		return false;
+
+	for (const std::pair<const uint32_t, std::unique_ptr<Shader>>& variant : reloaded)
+		if (!variant.second->is_ready())
+			return false;
+
+	bool linked = true;
+
+	for (const std::pair<const uint32_t, std::unique_ptr<Shader>>& variant : reloaded)
+		linked &= variant.second->is_linked();
+
+	if (!linked)
+	{
+		warning_callback("Reloaded shader variants failed to build, keeping the previous ones");
+		reloaded.clear();
+		return false;
+	}
+
+	// The objects stay, so whatever points to them draws with the new programs from now on.
+	for (const std::pair<const uint32_t, std::unique_ptr<Shader>>& variant : reloaded)
+		variants[variant.first]->swap(*variant.second);
+
+	reloaded.clear();
+
+	return true;
+}
+
+std::string ShaderVariants::get_source(const std::string& code, const std::vector<std::string>& defines, uint32_t features)
+{
+	// #version has to stay the first directive, the defines follow its line.
+	const size_t version = code.find_first_not_of(" \t\r\n");
+	size_t body = 0;
+
+	if (version != std::string::npos && code.compare(version, 8, "#version") == 0)
+	{
+		body = code.find('\n', version);
+		body = body == std::string::npos ? code.size() : body + 1;
+	}
+
+	const uint32_t body_line = 1 + std::count(code.begin(), code.begin() + body, '\n');
+
+	std::string preamble;
+
+	for (uint32_t i = 0; i < defines.size(); i++)
+		if (features & (1u << i))
+			preamble += "#define " + defines[i] + "\n";
+
+	if (preamble.empty())
+		return code;
+
+	std::string source = code.substr(0, body);
+
+	// A #version without a line break after it.
+	if (!source.empty() && source.back() != '\n')
+		source += '\n';
+
+	source += preamble;
+	source += "#line " + std::to_string(body_line) + "\n";
+	source += code.substr(body);
+
+	return source;
+}
@@ -1,24 +1,38 @@
 #include "gl/texture.h"
 
+#include "gl/gl_state.h"
+#include "gl/gl_stats.h"
+
 #include <GL/glew.h>
 
 Texture::Texture(uint32_t width, uint32_t height, Pixels_t data, GLint internalFormat, GLuint format, GLuint type, Parameters_t params) : width{width}, height{height}, internalFormat{internalFormat}, format{format}, type{type}
 {
 	glGenTextures(1, &handle);
-	glBindTexture(GL_TEXTURE_2D, handle);
+	gl_state::bind_texture(GL_TEXTURE_2D, handle);
 	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
 
+	if (data)
+		gl_stats::add_texture_upload(gl_stats::get_image_size(width, height, format, type));
+
 	for (int i = 0; i < params.size(); i++)
 	{
 		params[i]();
 	}
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	gl_state::bind_texture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(const Storage& storage) : width{storage.width}, height{storage.height}, internalFormat{storage.internal_format}, format{storage.format}, type{storage.type}, levels{storage.levels}
+{
+	glGenTextures(1, &handle);
+	gl_state::bind_texture(GL_TEXTURE_2D, handle);
+	glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+	gl_state::bind_texture(GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture()
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	gl_state::forget_texture(handle);
 	glDeleteTextures(1, &handle);
 }
 
@@ -32,32 +46,144 @@ uint32_t Texture::get_height() const
 	return height;
 }
 
+uint32_t Texture::get_levels() const
+{
+	return levels;
+}
+
+int32_t Texture::get_internal_format() const
+{
+	return internalFormat;
+}
+
+uint32_t Texture::get_mip_count(uint32_t width, uint32_t height)
+{
+	uint32_t count = 1;
+
+	for (uint32_t size = width > height ? width : height; size > 1; size >>= 1)
+		count++;
+
+	return count;
+}
+
+bool Texture::is_compressed_format(int32_t internal_format)
+{
+	switch (internal_format)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+		return true;
+	}
+
+	// ETC2/EAC and the ASTC block sizes are contiguous ranges.
+	if (internal_format >= GL_COMPRESSED_R11_EAC && internal_format <= GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC)
+		return true;
+
+	if (internal_format >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && internal_format <= GL_COMPRESSED_RGBA_ASTC_12x12_KHR)
+		return true;
+
+	if (internal_format >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR && internal_format <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR)
+		return true;
+
+	return false;
+}
+
+bool Texture::is_compressed_format_supported(int32_t internal_format)
+{
+	switch (internal_format)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return GLEW_EXT_texture_compression_s3tc;
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+		return true;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+		return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+	}
+
+	if (internal_format >= GL_COMPRESSED_R11_EAC && internal_format <= GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC)
+		return GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility;
+
+	if (is_compressed_format(internal_format))
+		return GLEW_KHR_texture_compression_astc_ldr;
+
+	return false;
+}
+
 void Texture::resize(uint32_t width, uint32_t height)
 {
 	this->width = width; this->height = height;
 	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
 }
 
+void Texture::update(uint32_t x, uint32_t y, uint32_t width, uint32_t height, Pixels_t data)
+{
+	update(0, x, y, width, height, data);
+}
+
+void Texture::update(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, Pixels_t data)
+{
+	glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, format, type, data);
+	gl_stats::add_texture_upload(gl_stats::get_image_size(width, height, format, type));
+}
+
+void Texture::update_compressed(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, size_t size, Pixels_t data)
+{
+	glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, internalFormat, static_cast<GLsizei>(size), data);
+	gl_stats::add_texture_upload(size);
+}
+
+void Texture::generate_mipmaps()
+{
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
 void Texture::bind()
 {
-	glBindTexture(GL_TEXTURE_2D, handle);
+	gl_state::bind_texture(GL_TEXTURE_2D, handle);
 }
 
 void Texture::bind(GLuint unit)
 {
-	glActiveTexture(unit);
+	gl_state::active_texture(unit);
 	bind();
 }
 
 void Texture::unbind(GLuint unit)
 {
-	glActiveTexture(unit);
+	gl_state::active_texture(unit);
 	unbind();
 }
 
 void Texture::unbind()
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	gl_state::bind_texture(GL_TEXTURE_2D, 0);
 }
 
 void LinearInterpolation()
@@ -0,0 +1,82 @@
+#include "gl/texture_array.h"
+
+#include "gl/gl_state.h"
+#include "gl/gl_stats.h"
+
+#include <GL/glew.h>
+
+TextureArray::TextureArray(const Storage& storage) : storage{storage}
+{
+	glGenTextures(1, &handle);
+	gl_state::bind_texture(GL_TEXTURE_2D_ARRAY, handle);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, storage.levels, storage.internal_format, storage.width, storage.height, storage.layers);
+	gl_state::bind_texture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextureArray::~TextureArray()
+{
+	gl_state::forget_texture(handle);
+	glDeleteTextures(1, &handle);
+}
+
+uint32_t TextureArray::get_level_width(uint32_t level) const
+{
+	const uint32_t width = storage.width >> level;
+	return width > 0 ? width : 1;
+}
+
+uint32_t TextureArray::get_level_height(uint32_t level) const
+{
+	const uint32_t height = storage.height >> level;
+	return height > 0 ? height : 1;
+}
+
+void TextureArray::update(uint32_t level, uint32_t layer, Texture::Pixels_t data)
+{
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, get_level_width(level), get_level_height(level), 1, storage.format, storage.type, data);
+	gl_stats::add_texture_upload(gl_stats::get_image_size(get_level_width(level), get_level_height(level), storage.format, storage.type));
+}
+
+void TextureArray::update_compressed(uint32_t level, uint32_t layer, size_t size, Texture::Pixels_t data)
+{
+	glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, get_level_width(level), get_level_height(level), 1, storage.internal_format, static_cast<GLsizei>(size), data);
+	gl_stats::add_texture_upload(size);
+}
+
+void TextureArray::copy(const Texture& texture, uint32_t layer)
+{
+	for (uint32_t level = 0; level < storage.levels; level++)
+		glCopyImageSubData(texture.get_handle(), GL_TEXTURE_2D, level, 0, 0, 0, handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, get_level_width(level), get_level_height(level), 1);
+}
+
+void TextureArray::generate_mipmaps()
+{
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+void TextureArray::bind()
+{
+	gl_state::bind_texture(GL_TEXTURE_2D_ARRAY, handle);
+}
+
+void TextureArray::bind(GLuint unit)
+{
+	gl_state::active_texture(unit);
+	bind();
+}
+
+void TextureArray::unbind()
+{
+	gl_state::bind_texture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::unbind(GLuint unit)
+{
+	gl_state::active_texture(unit);
+	unbind();
+}
+
+const TextureArray::Storage& TextureArray::get_storage() const
+{
+	return storage;
+}
@@ -1,5 +1,8 @@
 #include "gl/vao.h"
 
+#include "gl/gl_state.h"
+#include "gl/gl_stats.h"
+
 #include <GL/glew.h>
 
 VAO::VAO()
@@ -11,34 +14,57 @@ VAO::VAO()
 VAO::~VAO()
 {
 	unbind();
+	gl_state::forget_vertex_array(handle);
 	glDeleteVertexArrays(1, &handle);
 
 	// MW_DEBUG_LOG_OUT("[Call] Vao destructor");
 }
 
+// 16-bit indices when the index buffer holds two byte elements.
+static GLenum get_index_type(const std::shared_ptr<VBO>& index_buffer)
+{
+	return index_buffer && index_buffer->get_size() == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
 uint32_t VAO::get_vertex_count() const
 {
 	return vertex_count;
 }
 
-void VAO::bind()
+void VAO::draw() const
 {
-	glBindVertexArray(handle);
+	glDrawElements(GL_TRIANGLES, vertex_count, get_index_type(index_buffer), nullptr);
+	gl_stats::add_draw(1, vertex_count / 3);
+}
+
+void VAO::draw_instanced(uint32_t instance_count, uint32_t base_instance) const
+{
+	gl_stats::add_draw(1, static_cast<uint64_t>(vertex_count / 3) * instance_count);
 
-	for (const auto &attribute : attributes)
+	if (base_instance > 0)
 	{
-		glEnableVertexAttribArray(attribute);
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, vertex_count, get_index_type(index_buffer), nullptr, instance_count, base_instance);
+		return;
 	}
+
+	glDrawElementsInstanced(GL_TRIANGLES, vertex_count, get_index_type(index_buffer), nullptr, instance_count);
 }
 
-void VAO::unbind()
+void VAO::draw_indirect(uint32_t draw_count, size_t offset) const
 {
-	for (int i = attributes.size() - 1; i >= 0; --i)
-	{
-		glDisableVertexAttribArray(attributes[i]);
-	}
+	glMultiDrawElementsIndirect(GL_TRIANGLES, get_index_type(index_buffer), reinterpret_cast<const void*>(offset), draw_count, 0);
+	gl_stats::add_draw(draw_count, 0);
+}
 
-	glBindVertexArray(0);
+void VAO::bind()
+{
+	// Enabled arrays and the index buffer are part of the vertex array, nothing else needs to be set.
+	gl_state::bind_vertex_array(handle);
+}
+
+void VAO::unbind()
+{
+	gl_state::bind_vertex_array(0);
 }
 
 uint32_t VAO::get_last_attribute() const
@@ -1,7 +1,12 @@
 #include "gl/vbo.h"
 
+#include "gl/gl_state.h"
+#include "gl/gl_stats.h"
+
 #include <GL/glew.h>
 
+#include <cstring>
+
 VBO::VBO(uint32_t attribute, Type type, Usage usage, size_t amount, size_t size, const void *data, std::vector<VertexBufferLayout> layouts)
 {
     this->usage = vbo_usage_to_gl_usage(usage);
@@ -12,24 +17,63 @@ VBO::VBO(uint32_t attribute, Type type, Usage usage, size_t amount, size_t size,
     attributes.resize(layouts.size());
 
     glGenBuffers(1, &handle);
-    glBindBuffer(this->type, handle);
+    gl_state::bind_buffer(this->type, handle);
 
+    // Enabled arrays are state of the bound vertex array, so this happens once here rather than on every bind.
     if (attribute != -1)
     {
-        glEnableVertexAttribArray(attribute);
         for (int i = 0; i < attributes.size(); i++)
         {
             int attrib = startAttribute + i;
-            glVertexAttribPointer(attrib, layouts[i].size, GL_FLOAT, GL_FALSE, layouts[i].stride, reinterpret_cast<void *>(layouts[i].offset));
-            glVertexAttribDivisor(attrib, layouts[i].divisor);
+            const VertexBufferLayout& layout = layouts[i];
+            const uint32_t gl_type = component_type_to_gl_type(layout.type);
+
+            if (is_integer_component(layout.type) && !layout.normalized)
+                glVertexAttribIPointer(attrib, layout.size, gl_type, layout.stride, reinterpret_cast<void *>(layout.offset));
+            else
+                glVertexAttribPointer(attrib, layout.size, gl_type, layout.normalized ? GL_TRUE : GL_FALSE, layout.stride, reinterpret_cast<void *>(layout.offset));
+
+            glVertexAttribDivisor(attrib, layout.divisor);
+            glEnableVertexAttribArray(attrib);
 
             attributes[i] = attrib;
         }
-        glDisableVertexAttribArray(attribute);
     }
 
-    glBufferData(this->type, size * amount, data, this->usage);
-    glBindBuffer(this->type, 0);
+    if (usage == Usage::Persistent)
+    {
+        region_size = size * amount;
+
+        // Every copy has to start where it can be bound as a block.
+        GLint alignment = 1;
+
+        if (type == Type::Uniform)
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        else if (type == Type::ShaderStorage)
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+        region_size = (region_size + alignment - 1) / alignment * alignment;
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(this->type, region_size * PERSISTENT_FRAME_COUNT, nullptr, flags);
+        mapping = static_cast<uint8_t*>(glMapBufferRange(this->type, 0, region_size * PERSISTENT_FRAME_COUNT, flags));
+        fences.resize(PERSISTENT_FRAME_COUNT, nullptr);
+
+        if (data)
+            for (uint32_t i = 0; i < PERSISTENT_FRAME_COUNT; i++)
+                memcpy(mapping + region_size * i, data, size * amount);
+    }
+    else
+    {
+        glBufferData(this->type, size * amount, data, this->usage);
+    }
+
+    if (data)
+        gl_stats::add_upload(size * amount);
+
+    // An index buffer stays attached to the vertex array bound while it is created.
+    if (type != VBO::Type::Indices)
+        gl_state::bind_buffer(this->type, 0);
 
     if (type == VBO::Type::Indices)
     {
@@ -39,12 +83,56 @@ VBO::VBO(uint32_t attribute, Type type, Usage usage, size_t amount, size_t size,
 
 VBO::~VBO()
 {
-    glBindBuffer(this->type, 0);
+    // The mapping goes away with the buffer.
+    for (GLsync fence : fences)
+        if (fence)
+            glDeleteSync(fence);
+
+    gl_state::forget_buffer(handle);
     glDeleteBuffers(1, &handle);
 
     // MW_DEBUG_LOG_OUT("[Call] VBO destructor");
 }
 
+bool VBO::is_persistent_supported()
+{
+	return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+void* VBO::begin_frame()
+{
+	frame = (frame + 1) % PERSISTENT_FRAME_COUNT;
+
+	if (GLsync fence = fences[frame])
+	{
+		// Only blocks when the CPU is a whole ring ahead of the GPU.
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+
+		glDeleteSync(fence);
+		fences[frame] = nullptr;
+	}
+
+	return mapping + get_frame_offset();
+}
+
+void VBO::end_frame()
+{
+	if (fences[frame])
+		glDeleteSync(fences[frame]);
+
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+uint32_t VBO::get_frame_element() const
+{
+	return static_cast<uint32_t>(get_frame_offset() / size);
+}
+
+size_t VBO::get_frame_offset() const
+{
+	return region_size * frame;
+}
+
 void* VBO::map() const
 {
 	return glMapBuffer(type, GL_WRITE_ONLY);
@@ -52,12 +140,12 @@ void* VBO::map() const
 
 void VBO::bind()
 {
-    glBindBuffer(type, handle);
+    gl_state::bind_buffer(type, handle);
 }
 
 void VBO::unbind()
 {
-    glBindBuffer(type, 0);
+    gl_state::bind_buffer(type, 0);
 }
 
 bool VBO::unmap() const
@@ -80,16 +168,54 @@ const std::vector<uint32_t>& VBO::get_used_attributes() const
     return attributes;
 }
 
-void VBO::store(void* data, int amount) const
+void VBO::store(const void* data, int amount) const
 {
 	glBufferData(type, amount * size, data, usage);
+
+	if (data)
+		gl_stats::add_upload(amount * size);
 }
 
-void VBO::update(void* data, int amount, int pos) const
+void VBO::update(const void* data, int amount, int pos) const
 {
+	gl_stats::add_upload(size * amount);
+
+	if (mapping)
+	{
+		memcpy(mapping + get_frame_offset() + size * pos, data, size * amount);
+		return;
+	}
+
 	glBufferSubData(type, size * pos, size * amount, data);
 }
 
+void VBO::bind_base(uint32_t index) const
+{
+    if (mapping)
+    {
+        gl_state::bind_buffer_range(type, index, handle, get_frame_offset(), region_size);
+        return;
+    }
+
+    gl_state::bind_buffer_base(type, index, handle);
+}
+
+void VBO::bind_range(uint32_t index, int amount, int pos) const
+{
+    gl_state::bind_buffer_range(type, index, handle, get_frame_offset() + size * pos, size * amount);
+}
+
+void VBO::bind_storage(uint32_t index) const
+{
+    if (mapping)
+    {
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, index, handle, get_frame_offset(), region_size);
+        return;
+    }
+
+    gl_state::bind_buffer_base(GL_SHADER_STORAGE_BUFFER, index, handle);
+}
+
 uint32_t VBO::get_index_count() const
 {
     return index_count;
@@ -110,6 +236,8 @@ uint32_t VBO::vbo_usage_to_gl_usage(VBO::Usage vbo_usage)
         return GL_DYNAMIC_DRAW;
     case VBO::Usage::Stream:
         return GL_STREAM_DRAW;
+    case VBO::Usage::Persistent:
+        return GL_DYNAMIC_DRAW;
     }
 
     return GL_STATIC_DRAW;
@@ -123,7 +251,45 @@ uint32_t VBO::vbo_type_to_gl_type(VBO::Type vbo_type)
         return GL_ARRAY_BUFFER;
     case VBO::Type::Indices:
         return GL_ELEMENT_ARRAY_BUFFER;
+    case VBO::Type::Uniform:
+        return GL_UNIFORM_BUFFER;
+    case VBO::Type::ShaderStorage:
+        return GL_SHADER_STORAGE_BUFFER;
+    case VBO::Type::PixelUnpack:
+        return GL_PIXEL_UNPACK_BUFFER;
+    case VBO::Type::DrawIndirect:
+        return GL_DRAW_INDIRECT_BUFFER;
     }
 
     return GL_ARRAY_BUFFER;
+}
+
+uint32_t VBO::component_type_to_gl_type(VertexBufferLayout::ComponentType component_type)
+{
+    switch (component_type)
+    {
+    case VertexBufferLayout::ComponentType::Float:
+        return GL_FLOAT;
+    case VertexBufferLayout::ComponentType::HalfFloat:
+        return GL_HALF_FLOAT;
+    case VertexBufferLayout::ComponentType::Int8:
+        return GL_BYTE;
+    case VertexBufferLayout::ComponentType::UInt8:
+        return GL_UNSIGNED_BYTE;
+    case VertexBufferLayout::ComponentType::Int16:
+        return GL_SHORT;
+    case VertexBufferLayout::ComponentType::UInt16:
+        return GL_UNSIGNED_SHORT;
+    case VertexBufferLayout::ComponentType::Int32:
+        return GL_INT;
+    case VertexBufferLayout::ComponentType::UInt32:
+        return GL_UNSIGNED_INT;
+    }
+
+    return GL_FLOAT;
+}
+
+bool VBO::is_integer_component(VertexBufferLayout::ComponentType component_type)
+{
+    return component_type != VertexBufferLayout::ComponentType::Float && component_type != VertexBufferLayout::ComponentType::HalfFloat;
 }
\ No newline at end of file
@@ -1,10 +1,11 @@
 #include "animation.h"
+#include "pose_kernel.h"
+
+#include "../core/profiler/profiler.h"
 
 #include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <assimp/Importer.hpp>
 
-#include <spdlog/spdlog.h>
+#include <algorithm>
 
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -12,48 +13,105 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/compatibility.hpp>
 
-void Avatar::init(const OffsetPerNameVec_t& offset_per_name_vec, const Bone& p_skeleton)
+// Intermediate results of a pose evaluation. They don't outlive a calculate_pose call,
+// so they're kept per thread instead of per avatar.
+struct PoseScratch
 {
-	for (int i = 0; i < offset_per_name_vec.size(); i++)
-	{
-		const std::string& bone_name = offset_per_name_vec[i].first;
+	std::vector<Transform> local_pose;
+	std::vector<glm::mat4> local_matrices;
+	std::vector<glm::mat4> global_transforms;
+};
 
-		if (bones_map.find(bone_name) == bones_map.end())
-		{
-			offset_matrices.push_back(offset_per_name_vec[i].second);
-			current_transforms.push_back(glm::mat4(1));
-			bones_map[bone_name] = i;
-		}
+static thread_local PoseScratch scratch;
+
+void Avatar::init(RigPtr_t p_rig)
+{
+	rig = std::move(p_rig);
+	cache = HierarchyCache();
+
+	current_transforms.assign(rig->get_amount_of_bones(), glm::mat4(1));
+	palette = current_transforms.data();
+}
+
+void Avatar::set_palette(glm::mat4* p_palette)
+{
+	if (p_palette)
+	{
+		// The avatar's own storage isn't needed while it writes somewhere else.
+		std::vector<glm::mat4>().swap(current_transforms);
+		palette = p_palette;
 	}
+	else
+	{
+		current_transforms.assign(get_amount_of_bones(), glm::mat4(1));
+		palette = current_transforms.data();
+	}
+}
 
-	skeleton = p_skeleton;
-	global_inverse_transform = glm::inverse(skeleton.transformation);
+const glm::mat4* Avatar::get_palette() const
+{
+	return palette;
 }
 
-static const BoneAnimation* find_bone_animation(const Animation& animation, const std::string& bone_name)
+const Rig& Avatar::get_rig() const
 {
-	for (int i = 0; i < animation.channels.size(); i++)
-		if (animation.channels[i].name == bone_name)
-			return &animation.channels[i];
+	return *rig;
+}
 
-	return nullptr;
+const RigPtr_t& Avatar::get_rig_ptr() const
+{
+	return rig;
 }
 
+// How far the cursor walks from its previous key before falling back to a binary search.
+static constexpr uint32_t MAX_CURSOR_STEPS = 4;
+
 template <typename T>
-static unsigned int get_frame_index(float time, const std::vector<KeyFrame<T>>& keys)
+static uint32_t search_frame_index(float time, const KeyTrack_t<T>& keys)
 {
-	for (int i = 0; i < keys.size() - 1; i++)
-		if (time < keys[i + 1].time)
-			return i;
+	const auto next = std::upper_bound(keys.begin() + 1, keys.end() - 1, time, [](float t, const KeyFrame<T>& key) { return t < key.time; });
 
-	return 0;
+	return static_cast<uint32_t>(next - keys.begin()) - 1;
 }
 
+// Returns i so that keys[i].time <= time < keys[i + 1].time (clamped to the first/last pair),
+// starting from the key the cursor stopped at during the previous sample.
 template <typename T>
-static KeyFrames<T> get_key_frames(float animation_time, const std::vector<KeyFrame<T>>& current)
+static uint32_t get_frame_index(float time, const KeyTrack_t<T>& keys, uint32_t& cursor)
 {
-	const uint32_t current_index = get_frame_index<T>(animation_time, current);
-	const uint32_t next_index = current_index + 1;
+	if (keys.size() < 2)
+		return 0;
+
+	const uint32_t last_index = static_cast<uint32_t>(keys.size()) - 2;
+
+	uint32_t index = std::min(cursor, last_index);
+
+	for (uint32_t step = 0; step < MAX_CURSOR_STEPS; step++)
+	{
+		if (index < last_index && time >= keys[index + 1].time)
+			index++;
+		else if (index > 0 && time < keys[index].time)
+			index--;
+		else
+			break;
+	}
+
+	const bool after_begin = index == 0 || time >= keys[index].time;
+	const bool before_end = index == last_index || time < keys[index + 1].time;
+
+	if (!after_begin || !before_end)
+		index = search_frame_index<T>(time, keys);
+
+	cursor = index;
+
+	return index;
+}
+
+template <typename T>
+static KeyFrames<T> get_key_frames(float animation_time, const KeyTrack_t<T>& current, uint32_t& cursor)
+{
+	const uint32_t current_index = get_frame_index<T>(animation_time, current, cursor);
+	const uint32_t next_index = std::min<uint32_t>(current_index + 1, current.size() - 1);
 
 	const KeyFrame<T>& current_key_frame = current[current_index];
 	const KeyFrame<T>& next_key_frame = current[next_index];
@@ -65,126 +123,293 @@ template <typename T>
 float KeyFrames<T>::get_blend_factor(float animation_time) const
 {
 	const float deltaTime = next_key_frame.time - current_key_frame.time;
+
+	if (deltaTime <= 0.0f)
+		return 0.0f;
+
 	const float blend = (animation_time - current_key_frame.time) / deltaTime;
 
-	return blend;
+	return glm::clamp(blend, 0.0f, 1.0f);
 }
 
-void Avatar::process_node_hierarchy(float animation_time, const Animation& animation, Bone& bone, const glm::mat4& parent_transform)
+Transform sample_channel(float animation_time, const BoneAnimation& bone_animation, ChannelCursor& cursor)
 {
-	glm::mat4 bone_transform = bone.transformation;
+	const KeyFrames<glm::vec3>& scaling_key_frames = get_key_frames<glm::vec3>(animation_time, bone_animation.scale_keys, cursor.scale_key);
+	const KeyFrames<glm::quat>& rotation_key_frames = get_key_frames<glm::quat>(animation_time, bone_animation.rotation_keys, cursor.rotation_key);
+	const KeyFrames<glm::vec3>& translation_key_frames = get_key_frames<glm::vec3>(animation_time, bone_animation.position_keys, cursor.position_key);
+
+	const glm::vec3 scaling_vec = glm::lerp(
+		scaling_key_frames.current_key_frame.value,
+		scaling_key_frames.next_key_frame.value,
+		scaling_key_frames.get_blend_factor(animation_time)
+	);
+
+	const glm::quat rotation_quat = nlerp_shortest(
+		rotation_key_frames.current_key_frame.value,
+		rotation_key_frames.next_key_frame.value,
+		rotation_key_frames.get_blend_factor(animation_time)
+	);
+
+	const glm::vec3 translation_vec = glm::lerp(
+		translation_key_frames.current_key_frame.value,
+		translation_key_frames.next_key_frame.value,
+		translation_key_frames.get_blend_factor(animation_time)
+	);
+
+	return { translation_vec, rotation_quat, scaling_vec };
+}
 
-	const BoneAnimation* bone_animation = find_bone_animation(animation, bone.name);
+bool Avatar::reuse_pose(const void* clip, float time, const AnimationBinding& binding, uint32_t skipped_height)
+{
+	// E.g. a paused avatar, or one between key updates of an animation LOD that doesn't move.
+	if (cache.valid && cache.clip == clip && cache.time == time && cache.binding == binding.get_id() && cache.skipped_height == skipped_height)
+	{
+		write_palette();
+		return true;
+	}
 
-	if (bone_animation)
-	{		
-		const KeyFrames<glm::vec3>& scaling_key_frames = get_key_frames<glm::vec3>(animation_time, bone_animation->scale_keys);
-		const KeyFrames<glm::quat>& rotation_key_frames = get_key_frames<glm::quat>(animation_time, bone_animation->rotation_keys);
-		const KeyFrames<glm::vec3>& translation_key_frames = get_key_frames<glm::vec3>(animation_time, bone_animation->position_keys);
+	cache.clip = clip;
+	cache.time = time;
 
-		const glm::vec3 scaling_vec = glm::lerp(
-			scaling_key_frames.current_key_frame.value,
-			scaling_key_frames.next_key_frame.value,
-			scaling_key_frames.get_blend_factor(animation_time)
-		);
+	return false;
+}
 
-		const glm::quat rotation_quat = glm::lerp(
-			rotation_key_frames.current_key_frame.value,
-			rotation_key_frames.next_key_frame.value,
-			rotation_key_frames.get_blend_factor(animation_time)
-		);
+void Avatar::write_palette()
+{
+	const Skeleton& skeleton = rig->skeleton;
 
-		const glm::vec3 translation_vec = glm::lerp(
-			translation_key_frames.current_key_frame.value,
-			translation_key_frames.next_key_frame.value,
-			translation_key_frames.get_blend_factor(animation_time)
-		);
+	for (uint32_t i = 0, amount_of_nodes = skeleton.get_amount_of_nodes(); i < amount_of_nodes; i++)
+	{
+		const int32_t bone_index = skeleton.nodes[i].bone_index;
 
-		const glm::mat4 scaling = glm::scale(glm::mat4(1), scaling_vec);
-		const glm::mat4 rotation = glm::toMat4(rotation_quat);
-		const glm::mat4 translation = glm::translate(glm::mat4(1), translation_vec);
+		if (bone_index < 0)
+			continue;
 
-		bone_transform = translation * rotation * scaling;
+		if (skeleton.heights[i] < cache.skipped_height && skeleton.parent_bones[i] >= 0)
+			palette[bone_index] = palette[skeleton.parent_bones[i]];
+		else
+			palette[bone_index] = cache.globals[i] * rig->offset_matrices[bone_index];
 	}
+}
 
-	const glm::mat4 global_transform = parent_transform * bone_transform;
+void Avatar::process_node_hierarchy(const AnimationBinding& binding, uint32_t skipped_height)
+{
+	const Skeleton& skeleton = rig->skeleton;
+	const uint32_t amount_of_nodes = skeleton.get_amount_of_nodes();
+
+	const std::vector<glm::mat4>& local_matrices = scratch.local_matrices;
 
-	if (bones_map.find(bone.name) != bones_map.end())
+	// Results for other skipped nodes or another clip's channels don't carry over.
+	const bool rebuild = !cache.valid || cache.binding != binding.get_id() || cache.skipped_height != skipped_height;
+
+	if (rebuild)
 	{
-		const uint32_t bone_index = bones_map[bone.name];
-		current_transforms[bone_index] = global_inverse_transform * global_transform * offset_matrices[bone_index];
+		cache.globals.resize(amount_of_nodes);
+		cache.animated.resize(amount_of_nodes);
+
+		for (uint32_t i = 0; i < amount_of_nodes; i++)
+		{
+			const int32_t parent = skeleton.nodes[i].parent;
+			cache.animated[i] = binding.node_channels[i] >= 0 || (parent >= 0 && cache.animated[parent]);
+		}
+
+		cache.binding = binding.get_id();
+		cache.skipped_height = skipped_height;
 	}
 
-	for (int i = 0; i < bone.children.size(); i++)
-		process_node_hierarchy(animation_time, animation, bone.children[i], global_transform);
+	// Parents always precede their children, so a parent's global transform is up to date by the time we get to a node.
+	for (uint32_t i = 0; i < amount_of_nodes; i++)
+	{
+		const SkeletonNode& node = skeleton.nodes[i];
+
+		// A bone at its bind pose relative to the bone above it ends up with the same palette matrix.
+		// Heights shrink towards the leaves, so the whole subtree below a skipped node is skipped as well.
+		if (skeleton.heights[i] < skipped_height && skeleton.parent_bones[i] >= 0)
+		{
+			if (node.bone_index >= 0)
+				palette[node.bone_index] = palette[skeleton.parent_bones[i]];
+
+			continue;
+		}
+
+		if (rebuild || cache.animated[i])
+		{
+			const int32_t channel = binding.node_channels[i];
+			const glm::mat4& node_transform = channel >= 0 ? local_matrices[channel] : node.transformation;
+
+			cache.globals[i] = node.parent < 0 ? rig->global_inverse_transform * node_transform : cache.globals[node.parent] * node_transform;
+		}
+
+		if (node.bone_index >= 0)
+			palette[node.bone_index] = cache.globals[i] * rig->offset_matrices[node.bone_index];
+	}
+
+	cache.valid = true;
+}
+
+void Avatar::calculate_pose(float time, const AnimationBinding& binding)
+{
+	const Animation& animation = binding.get_animation();
+
+	if (cursor_clip != &animation)
+	{
+		cursors.assign(animation.channels.size(), ChannelCursor());
+		cursor_clip = &animation;
+	}
+
+	const float time_in_ticks = time * animation.ticks_per_second;
+	const float current_time = fmod(time_in_ticks, animation.duration);
+
+	if (reuse_pose(&animation, current_time, binding, 0))
+		return;
+
+	scratch.local_pose.resize(animation.channels.size());
+	scratch.local_matrices.resize(animation.channels.size());
+
+	for (int i = 0; i < animation.channels.size(); i++)
+	{
+		scratch.local_pose[i] = sample_channel(current_time, animation.channels[i], cursors[i]);
+		scratch.local_matrices[i] = scratch.local_pose[i].to_matrix();
+	}
+
+	process_node_hierarchy(binding);
+}
+
+void Avatar::calculate_pose(float time, const BakedAnimation& animation, const AnimationBinding& binding, uint32_t skipped_height)
+{
+	const float time_in_ticks = time * animation.ticks_per_second;
+
+	calculate_pose_ticks(fmod(time_in_ticks, animation.duration), animation, binding, skipped_height);
+}
+
+void Avatar::calculate_pose_ticks(float animation_time, const BakedAnimation& animation, const AnimationBinding& binding, uint32_t skipped_height)
+{
+	PROFILE_ZONE("calculate_pose");
+
+	if (reuse_pose(&animation, animation_time, binding, skipped_height))
+		return;
+
+	scratch.local_matrices.resize(animation.channel_stride);
+	pose_kernel::sample_local_matrices(animation, animation_time, scratch.local_matrices.data());
+
+	process_node_hierarchy(binding, skipped_height);
 }
 
-void Avatar::calculate_pose(float time, const Animation& animation)
+void Avatar::calculate_pose(float time, const CompressedAnimation& animation, const AnimationBinding& binding)
 {
+	if (cursor_clip != &animation)
+	{
+		cursors.assign(animation.channels.size(), ChannelCursor());
+		cursor_clip = &animation;
+	}
+
 	const float time_in_ticks = time * animation.ticks_per_second;
 	const float current_time = fmod(time_in_ticks, animation.duration);
 
-	process_node_hierarchy(current_time, animation, skeleton);
+	if (reuse_pose(&animation, current_time, binding, 0))
+		return;
+
+	scratch.local_pose.resize(animation.channels.size());
+	scratch.local_matrices.resize(animation.channels.size());
+
+	animation.sample(current_time, scratch.local_pose.data(), cursors.data());
+
+	for (int i = 0; i < animation.channels.size(); i++)
+		scratch.local_matrices[i] = scratch.local_pose[i].to_matrix();
+
+	process_node_hierarchy(binding);
 }
 
-Animation::Animation(const std::string& path)
+void Avatar::calculate_pose(const Pose_t& pose)
 {
-	Assimp::Importer importer;
+	const Skeleton& skeleton = rig->skeleton;
+
+	// Blended poses aren't tracked, the next clip evaluation starts over.
+	cache.valid = false;
+
+	std::vector<glm::mat4>& global_transforms = scratch.global_transforms;
+	global_transforms.resize(skeleton.get_amount_of_nodes());
 
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+	for (uint32_t i = 0, amount_of_nodes = skeleton.get_amount_of_nodes(); i < amount_of_nodes; i++)
+	{
+		const SkeletonNode& node = skeleton.nodes[i];
 
-	if (!scene)
-		spdlog::error("Failed to load animation: {0}", path);
+		const glm::mat4 node_transform = pose[i].to_matrix();
 
-	const aiAnimation* assimp_animation = scene->mAnimations[0];
+		global_transforms[i] = node.parent < 0 ? node_transform : global_transforms[node.parent] * node_transform;
 
-	name = std::string(assimp_animation->mName.data);
-	duration = static_cast<float>(assimp_animation->mDuration);
+		if (node.bone_index >= 0)
+			palette[node.bone_index] = rig->global_inverse_transform * global_transforms[i] * rig->offset_matrices[node.bone_index];
+	}
+}
 
-	if (assimp_animation->mTicksPerSecond != 0.0)
-		ticks_per_second = static_cast<float>(assimp_animation->mTicksPerSecond);
+Animation::Animation(const aiAnimation& assimp_animation)
+{
+	name = std::string(assimp_animation.mName.data);
+	duration = static_cast<float>(assimp_animation.mDuration);
+
+	if (assimp_animation.mTicksPerSecond != 0.0)
+		ticks_per_second = static_cast<float>(assimp_animation.mTicksPerSecond);
 	else
 		ticks_per_second = 25.0f;
 
-	for (int i = 0, channels_count = assimp_animation->mNumChannels; i < channels_count; i++)
+	// One arena sized for every key of the clip.
+	size_t key_bytes = 0;
+
+	for (uint32_t i = 0; i < assimp_animation.mNumChannels; i++)
+	{
+		const aiNodeAnim& assimp_bone_animation = *assimp_animation.mChannels[i];
+
+		key_bytes += (assimp_bone_animation.mNumPositionKeys + assimp_bone_animation.mNumScalingKeys) * sizeof(KeyFrame<glm::vec3>);
+		key_bytes += assimp_bone_animation.mNumRotationKeys * sizeof(KeyFrame<glm::quat>) + 3 * alignof(std::max_align_t);
+	}
+
+	arena = std::make_shared<Arena>(std::max<size_t>(key_bytes, 1));
+
+	channels.resize(assimp_animation.mNumChannels);
+
+	for (int i = 0, channels_count = assimp_animation.mNumChannels; i < channels_count; i++)
 	{
-		const aiNodeAnim& assimp_bone_animation = *assimp_animation->mChannels[i];
-		BoneAnimation bone_animation;
+		const aiNodeAnim& assimp_bone_animation = *assimp_animation.mChannels[i];
+		BoneAnimation& bone_animation = channels[i];
 
 		bone_animation.name = std::string(assimp_bone_animation.mNodeName.data);
 
+		bone_animation.position_keys = KeyTrack_t<glm::vec3>(*arena);
+		bone_animation.rotation_keys = KeyTrack_t<glm::quat>(*arena);
+		bone_animation.scale_keys = KeyTrack_t<glm::vec3>(*arena);
+
+		bone_animation.position_keys.resize(assimp_bone_animation.mNumPositionKeys);
 		for (int j = 0, amount_of_pos_keys = assimp_bone_animation.mNumPositionKeys; j < amount_of_pos_keys; j++)
 		{
 			const aiVectorKey& assimp_pos_key = assimp_bone_animation.mPositionKeys[j];
-			KeyFrame<glm::vec3>& pos_key = bone_animation.position_keys.emplace_back();
 
-			pos_key.time = static_cast<float>(assimp_pos_key.mTime);
-			memcpy(&pos_key.value.x, &assimp_pos_key.mValue.x, sizeof(glm::vec3));
+			bone_animation.position_keys[j].time = static_cast<float>(assimp_pos_key.mTime);
+			bone_animation.position_keys[j].value = glm::vec3(assimp_pos_key.mValue.x, assimp_pos_key.mValue.y, assimp_pos_key.mValue.z);
 		}
 
+		// aiQuaternion is stored w, x, y, z; glm::quat's memory order differs, so components are passed by name.
+		bone_animation.rotation_keys.resize(assimp_bone_animation.mNumRotationKeys);
 		for (int j = 0, amount_of_rot_keys = assimp_bone_animation.mNumRotationKeys; j < amount_of_rot_keys; j++)
 		{
 			const aiQuatKey& assimp_rot_key = assimp_bone_animation.mRotationKeys[j];
-			KeyFrame<glm::quat>& rot_key = bone_animation.rotation_keys.emplace_back();
 
-			rot_key.time = static_cast<float>(assimp_rot_key.mTime);
-			memcpy(&rot_key.value[0], &assimp_rot_key.mValue.w, sizeof(float) * 4);
+			bone_animation.rotation_keys[j].time = static_cast<float>(assimp_rot_key.mTime);
+			bone_animation.rotation_keys[j].value = glm::quat(assimp_rot_key.mValue.w, assimp_rot_key.mValue.x, assimp_rot_key.mValue.y, assimp_rot_key.mValue.z);
 		}
 
+		bone_animation.scale_keys.resize(assimp_bone_animation.mNumScalingKeys);
 		for (int j = 0, amount_of_scale_keys = assimp_bone_animation.mNumScalingKeys; j < amount_of_scale_keys; j++)
 		{
 			const aiVectorKey& assimp_scale_key = assimp_bone_animation.mScalingKeys[j];
-			KeyFrame<glm::vec3>& scale_key = bone_animation.scale_keys.emplace_back();
 
-			scale_key.time = static_cast<float>(assimp_scale_key.mTime);
-			memcpy(&scale_key.value.x, &assimp_scale_key.mValue.x, sizeof(glm::vec3));
+			bone_animation.scale_keys[j].time = static_cast<float>(assimp_scale_key.mTime);
+			bone_animation.scale_keys[j].value = glm::vec3(assimp_scale_key.mValue.x, assimp_scale_key.mValue.y, assimp_scale_key.mValue.z);
 		}
-
-		channels.push_back(bone_animation);
 	}
 }
 
 uint32_t Avatar::get_amount_of_bones() const
 {
-	return current_transforms.size();
+	return rig ? rig->get_amount_of_bones() : 0;
 }
\ No newline at end of file
@@ -5,12 +5,17 @@
 #include <string>
 #include <map>
 
-struct Bone
-{
-	std::string name;
-	glm::mat4 transformation;
-	std::vector<Bone> children;
-};
+#include "skeleton.h"
+#include "rig.h"
+#include "binding.h"
+#include "transform.h"
+#include "baked_animation.h"
+#include "compressed_animation.h"
+#include "blending.h"
+
+#include "../core/memory/arena.h"
+
+struct aiAnimation;
 
 template <typename T>
 struct KeyFrame
@@ -28,52 +33,120 @@ struct KeyFrames
 	float get_blend_factor(float animation_time) const;
 };
 
+template <typename T>
+using KeyTrack_t = ArenaVector_t<KeyFrame<T>>;
+
 struct BoneAnimation
 {
 	std::string name;
 
-	std::vector<KeyFrame<glm::vec3>> position_keys;
-	std::vector<KeyFrame<glm::quat>> rotation_keys;
-	std::vector<KeyFrame<glm::vec3>> scale_keys;
+	KeyTrack_t<glm::vec3> position_keys;
+	KeyTrack_t<glm::quat> rotation_keys;
+	KeyTrack_t<glm::vec3> scale_keys;
+};
+
+// Key indices the previous sample of a channel stopped at. Playback moves forward
+// (or backward after a loop) by a key or two per frame, so starting from here avoids searching the track.
+struct ChannelCursor
+{
+	uint32_t position_key{0};
+	uint32_t rotation_key{0};
+	uint32_t scale_key{0};
 };
 
 class Animation
 {
 public:
-	Animation(const std::string& path);
+	// Use Model to load animations, it reads everything from one import.
+	Animation(const aiAnimation& animation);
 
 	std::string name;
 
 	float duration;
 	float ticks_per_second;
 
+	// The key tracks of all channels, allocated back to back while importing and released together with the
+	// last copy of the animation instead of three heap blocks per channel. Declared before channels so it's
+	// destroyed after the tracks pointing into it.
+	std::shared_ptr<Arena> arena;
+
 	std::vector<BoneAnimation> channels;
 };
 
-using Skeleton_t = Bone;
-using OffsetPerName_t = std::pair<std::string, glm::mat4>;
-using OffsetPerNameVec_t = std::vector<OffsetPerName_t>;
+Transform sample_channel(float animation_time, const BoneAnimation& channel, ChannelCursor& cursor);
 
 class Avatar
 {
 public:
 	Avatar() = default;
 
-	void init(const OffsetPerNameVec_t& bones, const Bone& skeleton);
-	void calculate_pose(float time, const Animation& animation);
+	void init(RigPtr_t rig);
+	void calculate_pose(float time, const AnimationBinding& binding);
+
+	// The binding must have been created for the Animation the clip was baked from.
+	// Bones with a Skeleton::heights value below skipped_height are held at their bind pose relative to their parent,
+	// e.g. 1 drops leaves like finger tips; they reuse the palette matrix of the closest bone above them.
+	void calculate_pose(float time, const BakedAnimation& animation, const AnimationBinding& binding, uint32_t skipped_height = 0);
+
+	// Same for a time in ticks, which isn't wrapped: the clip's duration is its last frame, not its first again,
+	// e.g. for going through every baked frame with frame * ticks_per_frame.
+	void calculate_pose_ticks(float animation_time, const BakedAnimation& animation, const AnimationBinding& binding, uint32_t skipped_height = 0);
+
+	// The binding must have been created for the Animation the clip was compressed from.
+	void calculate_pose(float time, const CompressedAnimation& animation, const AnimationBinding& binding);
+
+	// Poses the avatar from a local transform per skeleton node, e.g. the output of a PoseBlender.
+	void calculate_pose(const Pose_t& pose);
 	
-	std::vector<glm::mat4> current_transforms;
-	std::vector<glm::mat4> offset_matrices;
-	glm::mat4 global_inverse_transform;
+	// Redirects the palette into external storage of get_amount_of_bones() matrices, e.g. a slot of a buffer shared by many avatars.
+	// current_transforms is released meanwhile; nullptr allocates it again and writes there.
+	void set_palette(glm::mat4* palette);
+	const glm::mat4* get_palette() const;
 
-	Bone skeleton;
+	std::vector<glm::mat4> current_transforms;
 
-	std::map<std::string, uint32_t> bones_map;
+	const Rig& get_rig() const;
+	const RigPtr_t& get_rig_ptr() const;
 
 	uint32_t get_amount_of_bones() const;
 
 private:
-	void process_node_hierarchy(float animation_time, const Animation& animation, Bone& bone, const glm::mat4& parent_transform = glm::mat4(1));
+	// The node globals of the last evaluation. Nodes without a channel whose ancestors have none either keep theirs as
+	// long as the binding does, and asking for the same pose again rebuilds the palette without sampling or the hierarchy.
+	struct HierarchyCache
+	{
+		// What it was evaluated from. Bindings by id, their address may be reused by another one.
+		const void* clip{nullptr};
+		uint64_t binding{0};
+		float time{0.0f};
+		uint32_t skipped_height{0};
+
+		bool valid{false};
+
+		// Per node, in model space: global_inverse_transform is already applied, so a bone's palette matrix is the
+		// product with its offset matrix. Skipped nodes have none.
+		std::vector<glm::mat4> globals;
+
+		// Nodes with a channel or below one, recomputed on every evaluation.
+		std::vector<uint8_t> animated;
+	};
+
+	// True when the clip was last evaluated at the same time with the same settings, the palette is written then.
+	bool reuse_pose(const void* clip, float time, const AnimationBinding& binding, uint32_t skipped_height);
+
+	// Palette from the cached globals.
+	void write_palette();
+
+	void process_node_hierarchy(const AnimationBinding& binding, uint32_t skipped_height = 0);
+
+	// Everything below is per-instance state; the rig is shared.
+	RigPtr_t rig;
+	glm::mat4* palette{nullptr};
+
+	std::vector<ChannelCursor> cursors;
+	const void* cursor_clip{nullptr};
+
+	HierarchyCache cache;
 
 	Avatar(const Avatar&) = delete;
 	Avatar& operator=(const Avatar&) = delete;
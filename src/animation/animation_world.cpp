@@ -0,0 +1,197 @@
+#include "animation_world.h"
+#include "transform.h"
+
+#include "../core/jobs/job_system.h"
+#include "../core/profiler/profiler.h"
+
+AnimationWorld::AnimationWorld(JobSystem& job_system) : job_system{job_system}
+{
+}
+
+uint32_t AnimationWorld::add_instance(RigPtr_t rig, BakedAnimationPtr_t clip, AnimationBindingPtr_t binding, float time, float speed)
+{
+	Instance& instance = instances.emplace_back();
+
+	instance.avatar = avatars.create();
+	instance.avatar->init(std::move(rig));
+	instance.clip = std::move(clip);
+	instance.binding = std::move(binding);
+	instance.time = time;
+	instance.speed = speed;
+	instance.palette_offset = palettes.size();
+
+	palettes.resize(palettes.size() + instance.avatar->get_amount_of_bones(), glm::mat4(1));
+
+	// Storage handed over before was sized for fewer instances.
+	set_palette_storage(nullptr);
+
+	return instances.size() - 1;
+}
+
+void AnimationWorld::set_palette_storage(glm::mat4* storage)
+{
+	// Avatars are pointed at their slot when they are animated, interpolated ones pose somewhere else first.
+	palette_storage = storage;
+}
+
+void AnimationWorld::update(float delta_time)
+{
+	PROFILE_ZONE("AnimationWorld::update");
+
+	glm::mat4* base = palette_storage ? palette_storage : palettes.data();
+
+	job_system.parallel_for(instances.size(), batch_size, [this, base, delta_time](uint32_t begin, uint32_t end)
+	{
+		PROFILE_ZONE("Animate batch");
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Instance& instance = instances[i];
+
+			instance.time += delta_time * instance.speed;
+			instance.posed = false;
+
+			if (instance.visible)
+			{
+				animate(instance, i, base + instance.palette_offset, delta_time);
+			}
+			else
+			{
+				instance.key_palettes[0].clear();
+				instance.key_palettes[1].clear();
+			}
+		}
+	});
+
+	update_count++;
+	posed_count = 0;
+
+	for (const Instance& instance : instances)
+		posed_count += instance.posed;
+}
+
+void AnimationWorld::animate(Instance& instance, uint32_t index, glm::mat4* output, float delta_time)
+{
+	Avatar& avatar = *instance.avatar;
+	const AnimationLod& lod = lods[instance.lod];
+
+	if (lod.update_interval <= 1)
+	{
+		avatar.set_palette(output);
+		avatar.calculate_pose(instance.time, *instance.clip, *instance.binding, lod.skipped_height);
+		instance.posed = true;
+		return;
+	}
+
+	std::vector<glm::mat4>& from = instance.key_palettes[0];
+	std::vector<glm::mat4>& to = instance.key_palettes[1];
+
+	// Offsetting by the index spreads the instances of a level evenly over its interval.
+	const bool due = (update_count + index) % lod.update_interval == 0 || update_count - instance.key_update >= lod.update_interval;
+
+	if (to.empty() || due)
+	{
+		// Nothing to blend from yet, e.g. the instance just came into view.
+		if (to.empty())
+		{
+			to.resize(avatar.get_amount_of_bones());
+			avatar.set_palette(to.data());
+			avatar.calculate_pose(instance.time, *instance.clip, *instance.binding, lod.skipped_height);
+		}
+
+		// The previous target was posed for about now; the new one is where the clip will be at the next key update.
+		from.swap(to);
+		to.resize(from.size());
+		avatar.set_palette(to.data());
+		avatar.calculate_pose(instance.time + delta_time * instance.speed * lod.update_interval, *instance.clip, *instance.binding, lod.skipped_height);
+
+		instance.key_update = update_count;
+		instance.posed = true;
+	}
+
+	const float blend = static_cast<float>(update_count - instance.key_update) / static_cast<float>(lod.update_interval);
+
+	// Blended as transforms, a component-wise lerp would shrink bones rotating between the key poses.
+	for (uint32_t i = 0; i < to.size(); i++)
+		output[i] = blend_matrices(from[i], to[i], blend);
+}
+
+void AnimationWorld::set_lods(std::vector<AnimationLod> p_lods)
+{
+	lods = std::move(p_lods);
+
+	for (Instance& instance : instances)
+	{
+		instance.key_palettes[0].clear();
+		instance.key_palettes[1].clear();
+		instance.lod = 0;
+	}
+}
+
+const std::vector<AnimationLod>& AnimationWorld::get_lods() const
+{
+	return lods;
+}
+
+void AnimationWorld::set_camera_distance(uint32_t index, float distance)
+{
+	Instance& instance = instances[index];
+
+	uint32_t lod = 0;
+
+	while (lod + 1 < lods.size() && distance >= lods[lod + 1].distance)
+		lod++;
+
+	if (lod != instance.lod)
+	{
+		// Key poses of another level don't line up with this one's interval.
+		instance.key_palettes[0].clear();
+		instance.key_palettes[1].clear();
+		instance.lod = lod;
+	}
+}
+
+uint32_t AnimationWorld::get_lod(uint32_t instance) const
+{
+	return instances[instance].lod;
+}
+
+void AnimationWorld::set_visible(uint32_t instance, bool visible)
+{
+	instances[instance].visible = visible;
+}
+
+bool AnimationWorld::is_visible(uint32_t instance) const
+{
+	return instances[instance].visible;
+}
+
+uint32_t AnimationWorld::get_posed_count() const
+{
+	return posed_count;
+}
+
+uint32_t AnimationWorld::get_instance_count() const
+{
+	return instances.size();
+}
+
+const Avatar& AnimationWorld::get_avatar(uint32_t instance) const
+{
+	return *instances[instance].avatar;
+}
+
+const std::vector<glm::mat4>& AnimationWorld::get_palettes() const
+{
+	return palettes;
+}
+
+uint32_t AnimationWorld::get_palette_offset(uint32_t instance) const
+{
+	return instances[instance].palette_offset;
+}
+
+uint32_t AnimationWorld::get_palette_count() const
+{
+	return palettes.size();
+}
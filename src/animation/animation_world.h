@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "animation.h"
+
+#include "../core/memory/pool.h"
+
+class JobSystem;
+
+// How far an instance's animation is simplified, chosen per instance by camera distance.
+struct AnimationLod
+{
+	// Camera distance from which the level applies.
+	float distance;
+
+	// Instances are posed every update_interval-th update, their palettes are interpolated in between.
+	uint32_t update_interval;
+
+	// Passed to Avatar::calculate_pose(), 0 evaluates the whole skeleton.
+	uint32_t skipped_height;
+};
+
+// Owns many avatar instances and updates their poses in parallel. Rigs, clips and bindings are shared;
+// each instance only keeps its playback state. Palettes of all instances are written into one contiguous buffer.
+class AnimationWorld
+{
+public:
+	explicit AnimationWorld(JobSystem& job_system);
+
+	// The binding must resolve the clip (or the Animation it was baked from) against rig->skeleton.
+	uint32_t add_instance(RigPtr_t rig, BakedAnimationPtr_t clip, AnimationBindingPtr_t binding, float time = 0.0f, float speed = 1.0f);
+
+	// Advances every instance; only visible ones are posed, the others just keep their clock running.
+	void update(float delta_time);
+
+	// Culled instances skip calculate_pose() and leave their palette as it was until they are visible again.
+	void set_visible(uint32_t instance, bool visible);
+	bool is_visible(uint32_t instance) const;
+
+	// Levels sorted by distance, the first one applies to everything closer than the second.
+	// Instances start at level 0; the default table is a single full-rate level.
+	void set_lods(std::vector<AnimationLod> lods);
+	const std::vector<AnimationLod>& get_lods() const;
+
+	// Picks the instance's level from its distance to the camera.
+	void set_camera_distance(uint32_t instance, float distance);
+	uint32_t get_lod(uint32_t instance) const;
+
+	// Instances posed by the last update(); interpolated ones don't count.
+	uint32_t get_posed_count() const;
+
+	uint32_t get_instance_count() const;
+	const Avatar& get_avatar(uint32_t instance) const;
+
+	// Palettes of all instances back to back, instance i starts at get_palette_offset(i).
+	const std::vector<glm::mat4>& get_palettes() const;
+	uint32_t get_palette_offset(uint32_t instance) const;
+	uint32_t get_palette_count() const;
+
+	// Makes update() write the palettes into storage of get_palette_count() matrices instead of get_palettes(),
+	// e.g. straight into the mapped copy of a persistent buffer for this frame; nullptr goes back to get_palettes().
+	// Adding an instance resets it. The storage is only ever written to, every visible instance writes its slot each update.
+	void set_palette_storage(glm::mat4* storage);
+
+	// Instances handed to a single job.
+	uint32_t batch_size{16};
+
+private:
+	struct Instance
+	{
+		Pool<Avatar>::Ptr_t avatar;
+
+		BakedAnimationPtr_t clip;
+		AnimationBindingPtr_t binding;
+
+		float time;
+		float speed;
+
+		bool visible{true};
+		bool posed{false};
+
+		uint32_t lod{0};
+		uint32_t palette_offset;
+
+		// Interpolated instances blend from the pose at the last key update to the one update_interval updates after it.
+		// Both are empty while the instance runs at full rate or is culled.
+		std::vector<glm::mat4> key_palettes[2];
+		uint32_t key_update{0};
+	};
+
+	// Writes the instance's palette for this update into output, posing it only when it is due.
+	void animate(Instance& instance, uint32_t index, glm::mat4* output, float delta_time);
+
+	JobSystem& job_system;
+
+	// Avatars come out of chunks instead of a heap block each. Declared before instances, which give theirs back when destroyed.
+	Pool<Avatar> avatars;
+
+	std::vector<Instance> instances;
+	std::vector<glm::mat4> palettes;
+	glm::mat4* palette_storage{nullptr};
+
+	std::vector<AnimationLod> lods{ { 0.0f, 1, 0 } };
+
+	uint32_t update_count{0};
+	uint32_t posed_count{0};
+
+	AnimationWorld(const AnimationWorld&) = delete;
+	AnimationWorld& operator=(const AnimationWorld&) = delete;
+};
@@ -0,0 +1,182 @@
+#include "baked_animation.h"
+
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+BakedAnimation::BakedAnimation(const Animation& animation, float samples_per_second) : name{animation.name}, duration{animation.duration}, ticks_per_second{animation.ticks_per_second}
+{
+	ticks_per_frame = ticks_per_second / samples_per_second;
+	frame_count = static_cast<uint32_t>(std::ceil(duration / ticks_per_frame)) + 1;
+	channel_count = static_cast<uint32_t>(animation.channels.size());
+	channel_stride = (channel_count + CHANNEL_ALIGNMENT - 1) / CHANNEL_ALIGNMENT * CHANNEL_ALIGNMENT;
+
+	storage.resize(get_sample_count(), 0.0f);
+	samples = storage.data();
+
+	channel_names.resize(channel_count);
+	for (uint32_t i = 0; i < channel_count; i++)
+		channel_names[i] = animation.channels[i].name;
+
+	std::vector<ChannelCursor> cursors(channel_count);
+	std::vector<glm::quat> previous_rotations(channel_count);
+
+	for (uint32_t frame = 0; frame < frame_count; frame++)
+	{
+		const float time = std::min(frame * ticks_per_frame, duration);
+
+		float* translation[3] = { get_component(Component::TranslationX, frame), get_component(Component::TranslationY, frame), get_component(Component::TranslationZ, frame) };
+		float* rotation[4] = { get_component(Component::RotationX, frame), get_component(Component::RotationY, frame), get_component(Component::RotationZ, frame), get_component(Component::RotationW, frame) };
+		float* scale[3] = { get_component(Component::ScaleX, frame), get_component(Component::ScaleY, frame), get_component(Component::ScaleZ, frame) };
+
+		for (uint32_t i = 0; i < channel_count; i++)
+		{
+			Transform transform = sample_channel(time, animation.channels[i], cursors[i]);
+
+			// Keep neighbouring frames in the same hemisphere, so sampling can nlerp without a sign check.
+			transform.rotation = glm::normalize(transform.rotation);
+			if (frame > 0 && glm::dot(previous_rotations[i], transform.rotation) < 0.0f)
+				transform.rotation = -transform.rotation;
+
+			previous_rotations[i] = transform.rotation;
+
+			for (int j = 0; j < 3; j++)
+			{
+				translation[j][i] = transform.translation[j];
+				scale[j][i] = transform.scale[j];
+			}
+
+			rotation[0][i] = transform.rotation.x;
+			rotation[1][i] = transform.rotation.y;
+			rotation[2][i] = transform.rotation.z;
+			rotation[3][i] = transform.rotation.w;
+		}
+
+		// Padding lanes hold the identity transform.
+		for (uint32_t i = channel_count; i < channel_stride; i++)
+		{
+			rotation[3][i] = 1.0f;
+
+			for (int j = 0; j < 3; j++)
+				scale[j][i] = 1.0f;
+		}
+	}
+}
+
+BakedAnimation::BakedAnimation(std::string name, const Header& header, std::vector<std::string> channel_names, const float* samples, std::shared_ptr<const void> backing) :
+	name{std::move(name)},
+	duration{header.duration},
+	ticks_per_second{header.ticks_per_second},
+	ticks_per_frame{header.ticks_per_frame},
+	frame_count{header.frame_count},
+	channel_count{header.channel_count},
+	channel_stride{header.channel_stride},
+	channel_names{std::move(channel_names)},
+	backing{std::move(backing)},
+	samples{samples}
+{
+}
+
+BakedAnimation::Header BakedAnimation::get_header() const
+{
+	return { duration, ticks_per_second, ticks_per_frame, frame_count, channel_count, channel_stride };
+}
+
+const float* BakedAnimation::get_samples() const
+{
+	return samples;
+}
+
+size_t BakedAnimation::get_sample_count() const
+{
+	return static_cast<size_t>(Component::Count) * frame_count * channel_stride;
+}
+
+const float* BakedAnimation::get_component(Component component, uint32_t frame) const
+{
+	return &samples[(static_cast<size_t>(component) * frame_count + frame) * channel_stride];
+}
+
+float* BakedAnimation::get_component(Component component, uint32_t frame)
+{
+	return &storage[(static_cast<size_t>(component) * frame_count + frame) * channel_stride];
+}
+
+void BakedAnimation::get_frames(float animation_time, uint32_t& frame, uint32_t& next_frame, float& alpha) const
+{
+	const float frame_time = std::max(animation_time, 0.0f) / ticks_per_frame;
+	const float whole_frames = std::floor(frame_time);
+
+	frame = std::min(static_cast<uint32_t>(whole_frames), frame_count - 1);
+	next_frame = std::min(frame + 1, frame_count - 1);
+	alpha = frame == next_frame ? 0.0f : frame_time - whole_frames;
+}
+
+void BakedAnimation::sample(float animation_time, Transform* out) const
+{
+	uint32_t frame, next_frame;
+	float alpha;
+
+	get_frames(animation_time, frame, next_frame, alpha);
+
+	const float* a[static_cast<uint32_t>(Component::Count)];
+	const float* b[static_cast<uint32_t>(Component::Count)];
+
+	for (uint32_t c = 0; c < static_cast<uint32_t>(Component::Count); c++)
+	{
+		a[c] = get_component(static_cast<Component>(c), frame);
+		b[c] = get_component(static_cast<Component>(c), next_frame);
+	}
+
+	for (uint32_t i = 0; i < channel_count; i++)
+	{
+		Transform& transform = out[i];
+
+		for (int j = 0; j < 3; j++)
+		{
+			const uint32_t t = static_cast<uint32_t>(Component::TranslationX) + j;
+			const uint32_t s = static_cast<uint32_t>(Component::ScaleX) + j;
+
+			transform.translation[j] = a[t][i] + (b[t][i] - a[t][i]) * alpha;
+			transform.scale[j] = a[s][i] + (b[s][i] - a[s][i]) * alpha;
+		}
+
+		for (int j = 0; j < 4; j++)
+		{
+			const uint32_t r = static_cast<uint32_t>(Component::RotationX) + j;
+
+			transform.rotation[j] = a[r][i] + (b[r][i] - a[r][i]) * alpha;
+		}
+
+		transform.rotation = glm::normalize(transform.rotation);
+	}
+}
+
+Transform BakedAnimation::sample(uint32_t frame, uint32_t next_frame, float alpha, uint32_t channel) const
+{
+	float values[static_cast<uint32_t>(Component::Count)];
+
+	for (uint32_t c = 0; c < static_cast<uint32_t>(Component::Count); c++)
+	{
+		const float a = get_component(static_cast<Component>(c), frame)[channel];
+		const float b = get_component(static_cast<Component>(c), next_frame)[channel];
+
+		values[c] = a + (b - a) * alpha;
+	}
+
+	Transform transform;
+
+	for (int j = 0; j < 3; j++)
+	{
+		transform.translation[j] = values[static_cast<uint32_t>(Component::TranslationX) + j];
+		transform.scale[j] = values[static_cast<uint32_t>(Component::ScaleX) + j];
+	}
+
+	for (int j = 0; j < 4; j++)
+		transform.rotation[j] = values[static_cast<uint32_t>(Component::RotationX) + j];
+
+	transform.rotation = glm::normalize(transform.rotation);
+
+	return transform;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <string>
+
+#include "transform.h"
+
+class Animation;
+
+// Animation resampled at a fixed rate, with every component stored as its own block.
+// Within a block, one frame of all channels is contiguous: component c of channel i at frame f lives at
+// samples[(c * frame_count + f) * channel_stride + i]. Sampling is direct index math and the inner loop runs across channels.
+// Channels keep the order of the source Animation, so an AnimationBinding built for it applies to the baked clip as well.
+class BakedAnimation
+{
+public:
+	enum class Component : uint32_t
+	{
+		TranslationX, TranslationY, TranslationZ,
+		RotationX, RotationY, RotationZ, RotationW,
+		ScaleX, ScaleY, ScaleZ,
+		Count
+	};
+
+	// Channel rows are padded to a multiple of this, so kernels can process whole SIMD lanes.
+	static constexpr uint32_t CHANNEL_ALIGNMENT = 8;
+
+	// Everything but the samples and names, stored as is in baked asset files.
+	struct Header
+	{
+		float duration;
+		float ticks_per_second;
+		float ticks_per_frame;
+
+		uint32_t frame_count;
+		uint32_t channel_count;
+		uint32_t channel_stride;
+	};
+
+	BakedAnimation(const Animation& animation, float samples_per_second = 30.0f);
+
+	// Wraps samples that already have the layout above, e.g. a memory-mapped asset. Nothing is copied;
+	// backing keeps the memory alive for as long as the clip exists.
+	BakedAnimation(std::string name, const Header& header, std::vector<std::string> channel_names, const float* samples, std::shared_ptr<const void> backing);
+
+	std::string name;
+
+	float duration;
+	float ticks_per_second;
+	float ticks_per_frame;
+
+	uint32_t frame_count;
+	uint32_t channel_count;
+	uint32_t channel_stride;
+
+	// Name of the node every channel animates, used to bind the clip without its source Animation.
+	std::vector<std::string> channel_names;
+
+	Header get_header() const;
+
+	const float* get_samples() const;
+	size_t get_sample_count() const;
+
+	const float* get_component(Component component, uint32_t frame) const;
+
+	// Splits a time in ticks into the pair of frames around it and the blend factor between them.
+	void get_frames(float animation_time, uint32_t& frame, uint32_t& next_frame, float& alpha) const;
+
+	void sample(float animation_time, Transform* out) const;
+
+	// One channel between a pair of frames from get_frames, for callers that only need a few of them.
+	Transform sample(uint32_t frame, uint32_t next_frame, float alpha, uint32_t channel) const;
+
+private:
+	float* get_component(Component component, uint32_t frame);
+
+	// Owned samples of a clip baked at runtime; empty when they live in backing.
+	std::vector<float> storage;
+	std::shared_ptr<const void> backing;
+
+	const float* samples{nullptr};
+
+	BakedAnimation(const BakedAnimation&) = delete;
+	BakedAnimation& operator=(const BakedAnimation&) = delete;
+};
+
+using BakedAnimationPtr_t = std::shared_ptr<const BakedAnimation>;
@@ -0,0 +1,71 @@
+#include "binding.h"
+
+#include "animation.h"
+
+#include <atomic>
+
+// Bindings are created on loader and worker threads alike.
+static std::atomic<uint64_t> next_binding_id{1};
+
+AnimationBinding::AnimationBinding(const Skeleton& skeleton, const Animation& animation) : animation{&animation}, id{next_binding_id++}
+{
+	std::vector<std::string> channel_names(animation.channels.size());
+
+	for (int i = 0; i < animation.channels.size(); i++)
+		channel_names[i] = animation.channels[i].name;
+
+	bind(skeleton, channel_names);
+}
+
+AnimationBinding::AnimationBinding(const Skeleton& skeleton, const BakedAnimation& animation) : id{next_binding_id++}
+{
+	bind(skeleton, animation.channel_names);
+}
+
+void AnimationBinding::bind(const Skeleton& skeleton, const std::vector<std::string>& channel_names)
+{
+	node_channels.resize(skeleton.get_amount_of_nodes(), -1);
+
+	for (int i = 0; i < channel_names.size(); i++)
+	{
+		const int32_t node_index = skeleton.find_node(channel_names[i]);
+
+		if (node_index >= 0)
+			node_channels[node_index] = i;
+	}
+}
+
+const Animation& AnimationBinding::get_animation() const
+{
+	return *animation;
+}
+
+uint64_t AnimationBinding::get_id() const
+{
+	return id;
+}
+
+AnimationBindingPtr_t BindingCache::get(const Skeleton& skeleton, const Animation& animation)
+{
+	AnimationBindingPtr_t& binding = bindings[{ &skeleton, &animation }];
+
+	if (!binding)
+		binding = std::make_shared<AnimationBinding>(skeleton, animation);
+
+	return binding;
+}
+
+AnimationBindingPtr_t BindingCache::get(const Skeleton& skeleton, const BakedAnimation& animation)
+{
+	AnimationBindingPtr_t& binding = bindings[{ &skeleton, &animation }];
+
+	if (!binding)
+		binding = std::make_shared<AnimationBinding>(skeleton, animation);
+
+	return binding;
+}
+
+void BindingCache::clear()
+{
+	bindings.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include <string>
+#include <map>
+
+class Skeleton;
+class Animation;
+class BakedAnimation;
+
+// Resolves the channels of an Animation to the nodes of a Skeleton once,
+// so sampling can go straight from a node index to its channel.
+class AnimationBinding
+{
+public:
+	AnimationBinding(const Skeleton& skeleton, const Animation& animation);
+
+	// Binds a baked clip through its channel names; get_animation() is not available then.
+	AnimationBinding(const Skeleton& skeleton, const BakedAnimation& animation);
+
+	const Animation& get_animation() const;
+
+	// Unique among all bindings ever created, unlike the address, which a new binding may reuse after one is freed.
+	uint64_t get_id() const;
+
+	// Index into Animation::channels for every skeleton node, -1 if the node isn't animated.
+	std::vector<int32_t> node_channels;
+
+private:
+	void bind(const Skeleton& skeleton, const std::vector<std::string>& channel_names);
+
+	const Animation* animation{nullptr};
+
+	uint64_t id;
+};
+
+using AnimationBindingPtr_t = std::shared_ptr<const AnimationBinding>;
+
+// Bindings only depend on the rig topology and the clip, so avatars sharing
+// a skeleton can share them too.
+class BindingCache
+{
+public:
+	BindingCache() = default;
+
+	AnimationBindingPtr_t get(const Skeleton& skeleton, const Animation& animation);
+	AnimationBindingPtr_t get(const Skeleton& skeleton, const BakedAnimation& animation);
+
+	void clear();
+
+private:
+	// Keyed by the clip's address, either an Animation or a BakedAnimation.
+	std::map<std::pair<const Skeleton*, const void*>, AnimationBindingPtr_t> bindings;
+
+	BindingCache(const BindingCache&) = delete;
+	BindingCache& operator=(const BindingCache&) = delete;
+};
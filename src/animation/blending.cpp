@@ -0,0 +1,163 @@
+#include "blending.h"
+
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+BoneMask::BoneMask(const Skeleton& skeleton, float weight) : weights(skeleton.get_amount_of_nodes(), weight)
+{
+}
+
+void BoneMask::set_subtree(const Skeleton& skeleton, int32_t node, float weight)
+{
+	if (node < 0)
+		return;
+
+	// Descendants follow their ancestors, so a single pass from the subtree root finds all of them.
+	std::vector<bool> in_subtree(skeleton.get_amount_of_nodes(), false);
+	in_subtree[node] = true;
+	weights[node] = weight;
+
+	for (uint32_t i = node + 1; i < skeleton.get_amount_of_nodes(); i++)
+	{
+		const int32_t parent = skeleton.nodes[i].parent;
+
+		if (parent >= 0 && in_subtree[parent])
+		{
+			in_subtree[i] = true;
+			weights[i] = weight;
+		}
+	}
+}
+
+static float get_animation_time(const Animation& animation, float time)
+{
+	return fmod(time * animation.ticks_per_second, animation.duration);
+}
+
+void AnimationLayer::set_binding(AnimationBindingPtr_t p_binding, Mode p_mode, float reference_time)
+{
+	binding = std::move(p_binding);
+	mode = p_mode;
+
+	const Animation& animation = binding->get_animation();
+
+	cursors.assign(animation.channels.size(), ChannelCursor());
+	reference_pose.clear();
+
+	if (mode == Mode::Additive)
+	{
+		std::vector<ChannelCursor> reference_cursors(animation.channels.size());
+		const float animation_time = get_animation_time(animation, reference_time);
+
+		for (int i = 0; i < animation.channels.size(); i++)
+			reference_pose.push_back(sample_channel(animation_time, animation.channels[i], reference_cursors[i]));
+	}
+}
+
+void CrossFade::start(float fade_duration)
+{
+	duration = fade_duration;
+	elapsed = 0.0f;
+}
+
+void CrossFade::advance(float delta_time)
+{
+	elapsed = std::min(elapsed + delta_time, duration);
+}
+
+bool CrossFade::is_done() const
+{
+	return elapsed >= duration;
+}
+
+float CrossFade::get_weight() const
+{
+	if (duration <= 0.0f)
+		return 1.0f;
+
+	const float t = elapsed / duration;
+
+	return t * t * (3.0f - 2.0f * t);
+}
+
+void blend_poses(const Pose_t& a, const Pose_t& b, float weight, const BoneMask* mask, Pose_t& out)
+{
+	for (int i = 0; i < out.size(); i++)
+	{
+		const float node_weight = mask ? weight * mask->weights[i] : weight;
+
+		out[i] = blend(a[i], b[i], node_weight);
+	}
+}
+
+PoseBlender::PoseBlender(const Skeleton& skeleton) : skeleton{skeleton}, layer_pose(skeleton.get_amount_of_nodes())
+{
+}
+
+void PoseBlender::sample_layer(AnimationLayer& layer, const Pose_t& base, Pose_t& out) const
+{
+	const Animation& animation = layer.binding->get_animation();
+	const std::vector<int32_t>& node_channels = layer.binding->node_channels;
+
+	const float animation_time = get_animation_time(animation, layer.time);
+
+	for (uint32_t i = 0; i < skeleton.get_amount_of_nodes(); i++)
+	{
+		const int32_t channel = node_channels[i];
+
+		if (channel < 0)
+		{
+			// Nodes the clip doesn't animate keep the result of the layers below (or add nothing).
+			out[i] = layer.mode == AnimationLayer::Mode::Override ? base[i] : Transform();
+			continue;
+		}
+
+		const Transform sample = sample_channel(animation_time, animation.channels[channel], layer.cursors[channel]);
+
+		if (layer.mode == AnimationLayer::Mode::Override)
+		{
+			out[i] = sample;
+		}
+		else
+		{
+			const Transform& reference = layer.reference_pose[channel];
+
+			out[i].translation = sample.translation - reference.translation;
+			out[i].rotation = glm::normalize(glm::inverse(reference.rotation) * sample.rotation);
+			out[i].scale = sample.scale / reference.scale;
+		}
+	}
+}
+
+void PoseBlender::evaluate(AnimationLayer* layers, uint32_t layer_count, Pose_t& out)
+{
+	out.assign(skeleton.bind_pose.begin(), skeleton.bind_pose.end());
+
+	for (uint32_t l = 0; l < layer_count; l++)
+	{
+		AnimationLayer& layer = layers[l];
+
+		if (!layer.binding || layer.weight <= 0.0f)
+			continue;
+
+		sample_layer(layer, out, layer_pose);
+
+		if (layer.mode == AnimationLayer::Mode::Override)
+		{
+			blend_poses(out, layer_pose, layer.weight, layer.mask, out);
+			continue;
+		}
+
+		for (uint32_t i = 0; i < skeleton.get_amount_of_nodes(); i++)
+		{
+			const float weight = layer.mask ? layer.weight * layer.mask->weights[i] : layer.weight;
+			const Transform& delta = layer_pose[i];
+
+			out[i].translation += delta.translation * weight;
+			out[i].rotation = glm::normalize(out[i].rotation * nlerp_shortest(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), delta.rotation, weight));
+			out[i].scale *= glm::vec3(1.0f) + (delta.scale - glm::vec3(1.0f)) * weight;
+		}
+	}
+}
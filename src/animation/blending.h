@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "transform.h"
+#include "binding.h"
+
+struct ChannelCursor;
+class Skeleton;
+
+// Local transform of every skeleton node, indexed like Skeleton::nodes.
+using Pose_t = std::vector<Transform>;
+
+// Per-node layer weights in [0, 1].
+class BoneMask
+{
+public:
+	BoneMask(const Skeleton& skeleton, float weight = 0.0f);
+
+	// Sets the weight of a node and everything below it.
+	void set_subtree(const Skeleton& skeleton, int32_t node, float weight);
+
+	std::vector<float> weights;
+};
+
+struct AnimationLayer
+{
+	enum class Mode
+	{
+		// Blends towards the layer's pose by its weight.
+		Override,
+		// Adds the difference between the layer's pose and its reference pose on top of the layers below.
+		Additive
+	};
+
+	AnimationLayer() = default;
+
+	// Allocates the cursors (and the reference pose for additive layers) up front, so evaluation doesn't have to.
+	void set_binding(AnimationBindingPtr_t binding, Mode mode = Mode::Override, float reference_time = 0.0f);
+
+	AnimationBindingPtr_t binding;
+	Mode mode{Mode::Override};
+
+	float time{0.0f};
+	float weight{1.0f};
+
+	// nullptr applies the layer to every node.
+	const BoneMask* mask{nullptr};
+
+	std::vector<ChannelCursor> cursors;
+
+	// Per channel, sampled at reference_time for additive layers.
+	std::vector<Transform> reference_pose;
+};
+
+// Weight ramp for fading from one layer into another over a fixed duration.
+struct CrossFade
+{
+	float duration{0.25f};
+	float elapsed{0.0f};
+
+	void start(float fade_duration);
+	void advance(float delta_time);
+
+	bool is_done() const;
+
+	// Weight of the layer being faded in, eased at both ends.
+	float get_weight() const;
+};
+
+// Evaluates a stack of layers on top of the bind pose. All buffers are sized at construction,
+// so blending any number of clips costs O(bones * layers) and never allocates.
+class PoseBlender
+{
+public:
+	PoseBlender(const Skeleton& skeleton);
+
+	void evaluate(AnimationLayer* layers, uint32_t layer_count, Pose_t& out);
+
+private:
+	void sample_layer(AnimationLayer& layer, const Pose_t& base, Pose_t& out) const;
+
+	const Skeleton& skeleton;
+
+	Pose_t layer_pose;
+};
+
+void blend_poses(const Pose_t& a, const Pose_t& b, float weight, const BoneMask* mask, Pose_t& out);
@@ -0,0 +1,48 @@
+#include "clip_bounds.h"
+
+#include "baked_animation.h"
+#include "animation.h"
+#include "binding.h"
+
+namespace clip_bounds
+{
+	std::vector<Aabb> compute_bone_bounds(const PackedVertex* vertices, uint32_t vertex_count, const QuantizationBounds& bounds, uint32_t bone_count)
+	{
+		std::vector<Aabb> bone_bounds(bone_count);
+
+		for (uint32_t i = 0; i < vertex_count; i++)
+		{
+			const PackedVertex& vertex = vertices[i];
+			const glm::vec3 position = vertex.get_position(bounds);
+
+			for (uint32_t j = 0; j < 4; j++)
+				if (vertex.weights[j] > 0 && vertex.joint_ids[j] < bone_count)
+					bone_bounds[vertex.joint_ids[j]].extend(position);
+		}
+
+		return bone_bounds;
+	}
+
+	Aabb compute_clip_bounds(const RigPtr_t& rig, const BakedAnimation& clip, const AnimationBinding& binding, const std::vector<Aabb>& bone_bounds)
+	{
+		Avatar avatar;
+		avatar.init(rig);
+
+		Aabb clip_box;
+
+		// Frames are the only poses the clip reaches exactly; in between, the lerp keeps bones close to them.
+		// In ticks, so the last frame isn't wrapped around to the first.
+		for (uint32_t frame = 0; frame < clip.frame_count; frame++)
+		{
+			avatar.calculate_pose_ticks(frame * clip.ticks_per_frame, clip, binding);
+
+			const glm::mat4* palette = avatar.get_palette();
+
+			for (uint32_t bone = 0; bone < bone_bounds.size() && bone < avatar.get_amount_of_bones(); bone++)
+				if (!bone_bounds[bone].is_empty())
+					clip_box.extend(bone_bounds[bone].transformed(palette[bone]));
+		}
+
+		return clip_box;
+	}
+}
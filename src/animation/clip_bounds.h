@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "../render/aabb.h"
+#include "../assets/packed_vertex.h"
+
+#include "rig.h"
+
+class BakedAnimation;
+class AnimationBinding;
+
+// Bounds of a skinned mesh over a whole clip, computed once per mesh and clip so that every avatar playing
+// the clip can be culled with a single box, whatever its current frame.
+namespace clip_bounds
+{
+	// Bind-pose box around the vertices each bone influences, indexed by bone.
+	std::vector<Aabb> compute_bone_bounds(const PackedVertex* vertices, uint32_t vertex_count, const QuantizationBounds& bounds, uint32_t bone_count);
+
+	// Union over every frame of the clip of each bone's box moved by its palette matrix. A skinned vertex is a
+	// weighted average of its bones' transforms, so it stays inside the union of the boxes of those bones.
+	Aabb compute_clip_bounds(const RigPtr_t& rig, const BakedAnimation& clip, const AnimationBinding& binding, const std::vector<Aabb>& bone_bounds);
+}
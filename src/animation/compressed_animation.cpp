@@ -0,0 +1,285 @@
+#include "compressed_animation.h"
+
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+// The three smallest components of a unit quaternion lie in [-1/sqrt(2), 1/sqrt(2)].
+static constexpr float COMPONENT_RANGE = 0.70710678f;
+static constexpr float COMPONENT_STEPS = 32767.0f;
+static constexpr float TIME_STEPS = 65535.0f;
+
+PackedQuat PackedQuat::pack(const glm::quat& rotation)
+{
+	const glm::quat normalized = glm::normalize(rotation);
+	const float components[4] = { normalized.x, normalized.y, normalized.z, normalized.w };
+
+	uint32_t largest = 0;
+
+	for (uint32_t i = 1; i < 4; i++)
+		if (std::fabs(components[i]) > std::fabs(components[largest]))
+			largest = i;
+
+	// q and -q are the same rotation, flipping makes the dropped component positive.
+	const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+	PackedQuat packed;
+
+	for (uint32_t i = 0, j = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+
+		const float value = glm::clamp(components[i] * sign / COMPONENT_RANGE, -1.0f, 1.0f);
+		packed.data[j++] = static_cast<uint16_t>(std::lround((value * 0.5f + 0.5f) * COMPONENT_STEPS) << 1);
+	}
+
+	packed.data[0] |= largest & 1;
+	packed.data[1] |= largest >> 1;
+
+	return packed;
+}
+
+glm::quat PackedQuat::unpack() const
+{
+	const uint32_t largest = (data[0] & 1) | ((data[1] & 1) << 1);
+
+	float components[4];
+	float length_squared = 0.0f;
+
+	for (uint32_t i = 0, j = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+
+		components[i] = ((data[j++] >> 1) / COMPONENT_STEPS * 2.0f - 1.0f) * COMPONENT_RANGE;
+		length_squared += components[i] * components[i];
+	}
+
+	components[largest] = std::sqrt(std::max(1.0f - length_squared, 0.0f));
+
+	return glm::quat(components[3], components[0], components[1], components[2]);
+}
+
+static float vector_error(const glm::vec3& a, const glm::vec3& b)
+{
+	return glm::length(a - b);
+}
+
+// Angle between two rotations, through the chord between the quaternions since acos is too coarse near 1.
+static float rotation_error(const glm::quat& a, const glm::quat& b)
+{
+	const glm::quat difference = glm::dot(a, b) < 0.0f ? a + b : a - b;
+	const float chord = std::sqrt(glm::dot(difference, difference));
+
+	return 4.0f * std::asin(std::min(chord * 0.5f, 1.0f));
+}
+
+static glm::vec3 lerp_vector(const glm::vec3& a, const glm::vec3& b, float t)
+{
+	return a + (b - a) * t;
+}
+
+// Picks the keys of a track worth keeping. Keys are dropped greedily from the last kept one for as long as
+// interpolating across them stays within tolerance of every key in between.
+template <typename T, typename Lerp, typename Error>
+static CompressedAnimation::TrackType reduce_keys(const KeyTrack_t<T>& keys, const T& default_value, float tolerance, Lerp lerp, Error error, std::vector<uint32_t>& kept)
+{
+	kept.clear();
+
+	if (keys.empty())
+		return CompressedAnimation::TrackType::Default;
+
+	bool constant = true;
+
+	for (uint32_t i = 1; i < keys.size() && constant; i++)
+		constant = error(keys[i].value, keys[0].value) <= tolerance;
+
+	if (constant)
+	{
+		if (error(keys[0].value, default_value) <= tolerance)
+			return CompressedAnimation::TrackType::Default;
+
+		kept.push_back(0);
+		return CompressedAnimation::TrackType::Constant;
+	}
+
+	kept.push_back(0);
+
+	uint32_t anchor = 0;
+
+	for (uint32_t end = 2; end < keys.size(); end++)
+	{
+		const float span = keys[end].time - keys[anchor].time;
+
+		bool fits = true;
+
+		for (uint32_t i = anchor + 1; i < end && fits; i++)
+		{
+			const float t = span > 0.0f ? (keys[i].time - keys[anchor].time) / span : 0.0f;
+			fits = error(lerp(keys[anchor].value, keys[end].value, t), keys[i].value) <= tolerance;
+		}
+
+		if (!fits)
+		{
+			anchor = end - 1;
+			kept.push_back(anchor);
+		}
+	}
+
+	kept.push_back(keys.size() - 1);
+
+	return CompressedAnimation::TrackType::Animated;
+}
+
+static uint16_t pack_time(float time, float duration)
+{
+	const float fraction = duration > 0.0f ? glm::clamp(time / duration, 0.0f, 1.0f) : 0.0f;
+
+	return static_cast<uint16_t>(std::lround(fraction * TIME_STEPS));
+}
+
+template <typename T, typename Packed, typename Pack>
+static CompressedAnimation::Track add_track(const KeyTrack_t<T>& keys, CompressedAnimation::TrackType type, const std::vector<uint32_t>& kept, float duration, std::vector<uint16_t>& times, std::vector<Packed>& values, Pack pack)
+{
+	CompressedAnimation::Track track;
+	track.type = type;
+	track.first_key = values.size();
+	track.key_count = kept.size();
+
+	for (uint32_t key : kept)
+	{
+		times.push_back(pack_time(keys[key].time, duration));
+		values.push_back(pack(keys[key].value));
+	}
+
+	return track;
+}
+
+CompressedAnimation::CompressedAnimation(const Animation& animation, const CompressionTolerance& tolerance) : name{animation.name}, duration{animation.duration}, ticks_per_second{animation.ticks_per_second}
+{
+	channels.resize(animation.channels.size());
+	channel_names.resize(animation.channels.size());
+
+	const auto keep_vector = [](const glm::vec3& value) { return value; };
+	const auto pack_rotation = [](const glm::quat& value) { return PackedQuat::pack(value); };
+
+	std::vector<uint32_t> kept;
+	KeyTrack_t<glm::quat> rotation_keys;
+
+	for (uint32_t i = 0; i < animation.channels.size(); i++)
+	{
+		const BoneAnimation& source = animation.channels[i];
+		Channel& channel = channels[i];
+
+		channel_names[i] = source.name;
+
+		TrackType type = reduce_keys(source.position_keys, glm::vec3(0.0f), tolerance.translation, lerp_vector, vector_error, kept);
+		channel.translation = add_track(source.position_keys, type, kept, duration, vector_times, vectors, keep_vector);
+
+		type = reduce_keys(source.scale_keys, glm::vec3(1.0f), tolerance.scale, lerp_vector, vector_error, kept);
+		channel.scale = add_track(source.scale_keys, type, kept, duration, vector_times, vectors, keep_vector);
+
+		// Keys are reduced on the quantized rotations the sampler will see. Assigning would take over the
+		// animation's arena as well, so the copy stays on the heap.
+		rotation_keys.assign(source.rotation_keys.begin(), source.rotation_keys.end());
+
+		for (KeyFrame<glm::quat>& key : rotation_keys)
+			key.value = PackedQuat::pack(key.value).unpack();
+
+		type = reduce_keys(rotation_keys, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), tolerance.rotation, nlerp_shortest, rotation_error, kept);
+		channel.rotation = add_track(rotation_keys, type, kept, duration, rotation_times, rotations, pack_rotation);
+	}
+}
+
+// How far the cursor walks from its previous key before falling back to a binary search.
+static constexpr uint32_t MAX_CURSOR_STEPS = 4;
+
+// Returns i so that times[i] <= time < times[i + 1] (clamped to the first/last pair), starting from the cursor.
+static uint32_t find_key(float time, const uint16_t* times, uint32_t count, uint32_t& cursor)
+{
+	const uint32_t last_index = count - 2;
+
+	uint32_t index = std::min(cursor, last_index);
+
+	for (uint32_t step = 0; step < MAX_CURSOR_STEPS; step++)
+	{
+		if (index < last_index && time >= times[index + 1])
+			index++;
+		else if (index > 0 && time < times[index])
+			index--;
+		else
+			break;
+	}
+
+	const bool after_begin = index == 0 || time >= times[index];
+	const bool before_end = index == last_index || time < times[index + 1];
+
+	if (!after_begin || !before_end)
+		index = static_cast<uint32_t>(std::upper_bound(times + 1, times + count - 1, time) - times) - 1;
+
+	cursor = index;
+
+	return index;
+}
+
+static float get_blend(float time, uint16_t current, uint16_t next)
+{
+	return next > current ? glm::clamp((time - current) / static_cast<float>(next - current), 0.0f, 1.0f) : 0.0f;
+}
+
+static glm::vec3 sample_vector(const CompressedAnimation::Track& track, const glm::vec3& default_value, float time, const uint16_t* times, const glm::vec3* values, uint32_t& cursor)
+{
+	if (track.type == CompressedAnimation::TrackType::Default)
+		return default_value;
+
+	if (track.type == CompressedAnimation::TrackType::Constant)
+		return values[track.first_key];
+
+	const uint16_t* track_times = times + track.first_key;
+	const glm::vec3* track_values = values + track.first_key;
+
+	const uint32_t key = find_key(time, track_times, track.key_count, cursor);
+
+	return lerp_vector(track_values[key], track_values[key + 1], get_blend(time, track_times[key], track_times[key + 1]));
+}
+
+static glm::quat sample_rotation(const CompressedAnimation::Track& track, float time, const uint16_t* times, const PackedQuat* values, uint32_t& cursor)
+{
+	if (track.type == CompressedAnimation::TrackType::Default)
+		return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+	if (track.type == CompressedAnimation::TrackType::Constant)
+		return values[track.first_key].unpack();
+
+	const uint16_t* track_times = times + track.first_key;
+	const PackedQuat* track_values = values + track.first_key;
+
+	const uint32_t key = find_key(time, track_times, track.key_count, cursor);
+
+	return nlerp_shortest(track_values[key].unpack(), track_values[key + 1].unpack(), get_blend(time, track_times[key], track_times[key + 1]));
+}
+
+void CompressedAnimation::sample(float animation_time, Transform* out, ChannelCursor* cursors) const
+{
+	// Compared against the 16-bit key times directly.
+	const float time = duration > 0.0f ? glm::clamp(animation_time / duration, 0.0f, 1.0f) * TIME_STEPS : 0.0f;
+
+	for (uint32_t i = 0; i < channels.size(); i++)
+	{
+		const Channel& channel = channels[i];
+		ChannelCursor& cursor = cursors[i];
+
+		out[i].translation = sample_vector(channel.translation, glm::vec3(0.0f), time, vector_times.data(), vectors.data(), cursor.position_key);
+		out[i].rotation = sample_rotation(channel.rotation, time, rotation_times.data(), rotations.data(), cursor.rotation_key);
+		out[i].scale = sample_vector(channel.scale, glm::vec3(1.0f), time, vector_times.data(), vectors.data(), cursor.scale_key);
+	}
+}
+
+size_t CompressedAnimation::get_memory_size() const
+{
+	return channels.size() * sizeof(Channel)
+		+ vector_times.size() * sizeof(uint16_t) + vectors.size() * sizeof(glm::vec3)
+		+ rotation_times.size() * sizeof(uint16_t) + rotations.size() * sizeof(PackedQuat);
+}
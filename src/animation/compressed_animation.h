@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "transform.h"
+
+class Animation;
+struct ChannelCursor;
+
+// Rotation in 48 bits: the three smallest components at 15 bits each plus the index of the largest one,
+// which is rebuilt from the unit length. The sign is chosen so that the largest component is positive.
+struct PackedQuat
+{
+	uint16_t data[3];
+
+	static PackedQuat pack(const glm::quat& rotation);
+	glm::quat unpack() const;
+};
+
+// Largest error a removed key or a collapsed track may introduce, in model units and radians.
+struct CompressionTolerance
+{
+	float translation{0.0005f};
+	float rotation{0.0005f};
+	float scale{0.0005f};
+};
+
+// Animation with its keys reduced within an error tolerance and packed for memory rather than for SIMD.
+// Constant tracks keep a single value, tracks at their default (zero translation, identity rotation, unit scale)
+// keep nothing, rotations are PackedQuat and key times are 16-bit fractions of the duration.
+// Sampling decodes only the two keys around the time, so there is no full decode step.
+// Channels keep the order of the source Animation, so an AnimationBinding built for it applies here as well.
+class CompressedAnimation
+{
+public:
+	enum class TrackType : uint8_t
+	{
+		Default,
+		Constant,
+		Animated
+	};
+
+	// Keys first_key .. first_key + key_count of the pool the track belongs to; Constant tracks have one key.
+	struct Track
+	{
+		TrackType type{TrackType::Default};
+		uint32_t first_key{0};
+		uint32_t key_count{0};
+	};
+
+	struct Channel
+	{
+		Track translation;
+		Track rotation;
+		Track scale;
+	};
+
+	CompressedAnimation(const Animation& animation, const CompressionTolerance& tolerance = {});
+
+	std::string name;
+
+	float duration;
+	float ticks_per_second;
+
+	std::vector<std::string> channel_names;
+	std::vector<Channel> channels;
+
+	// Samples every channel at animation_time (in ticks); cursors holds one entry per channel and speeds up
+	// playback that moves on by a key or two per call, like sample_channel() for the source Animation.
+	void sample(float animation_time, Transform* out, ChannelCursor* cursors) const;
+
+	// Bytes held by the tracks and key pools.
+	size_t get_memory_size() const;
+
+private:
+	// Translation and scale keys share the vector pool, each pool has its times alongside.
+	std::vector<uint16_t> vector_times;
+	std::vector<glm::vec3> vectors;
+
+	std::vector<uint16_t> rotation_times;
+	std::vector<PackedQuat> rotations;
+
+	CompressedAnimation(const CompressedAnimation&) = delete;
+	CompressedAnimation& operator=(const CompressedAnimation&) = delete;
+};
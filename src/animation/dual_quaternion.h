@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "transform.h"
+
+// Rigid transform in 8 floats instead of the 16 of a matrix: the rotation, and half the translation times the
+// rotation. Both parts are stored x, y, z, w, the layout of struct DualQuaternion in dual_quaternion.glsl. Blending
+// a few of them and normalising keeps the result rigid, so skinned joints don't collapse the way blended matrices do.
+struct DualQuaternion
+{
+	glm::vec4 real{0.0f, 0.0f, 0.0f, 1.0f};
+	glm::vec4 dual{0.0f};
+
+	// Scale and shear can't be represented, they're dropped; rigs that scale bones stay on matrix skinning.
+	inline static DualQuaternion from_matrix(const glm::mat4& matrix)
+	{
+		const Transform transform = Transform::from_matrix(matrix);
+
+		const glm::quat& r = transform.rotation;
+		const glm::quat d = glm::quat(0.0f, transform.translation.x, transform.translation.y, transform.translation.z) * r * 0.5f;
+
+		return { glm::vec4(r.x, r.y, r.z, r.w), glm::vec4(d.x, d.y, d.z, d.w) };
+	}
+
+	inline glm::mat4 to_matrix() const
+	{
+		const float length = glm::length(real);
+
+		const glm::quat r(real.w / length, real.x / length, real.y / length, real.z / length);
+		const glm::quat d(dual.w / length, dual.x / length, dual.y / length, dual.z / length);
+
+		// Twice the vector part of dual * conjugate(real).
+		const glm::quat t = d * glm::conjugate(r) * 2.0f;
+
+		glm::mat4 matrix = glm::mat4_cast(r);
+		matrix[3] = glm::vec4(t.x, t.y, t.z, 1.0f);
+
+		return matrix;
+	}
+};
+
+static_assert(sizeof(DualQuaternion) == sizeof(float) * 8, "Palettes are uploaded as is");
@@ -0,0 +1,399 @@
+#include "pose_kernel.h"
+
+#include "baked_animation.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define POSE_KERNEL_X86
+#	include <immintrin.h>
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+#		define POSE_KERNEL_TARGET_AVX
+#	else
+#		define POSE_KERNEL_TARGET_AVX __attribute__((target("avx")))
+#	endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#	define POSE_KERNEL_NEON
+#	include <arm_neon.h>
+#endif
+
+namespace pose_kernel
+{
+	using Component = BakedAnimation::Component;
+
+	// Pointers to the rows of both frames for every component.
+	struct Rows
+	{
+		const float* a[static_cast<uint32_t>(Component::Count)];
+		const float* b[static_cast<uint32_t>(Component::Count)];
+
+		Rows(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame)
+		{
+			for (uint32_t c = 0; c < static_cast<uint32_t>(Component::Count); c++)
+			{
+				a[c] = animation.get_component(static_cast<Component>(c), frame);
+				b[c] = animation.get_component(static_cast<Component>(c), next_frame);
+			}
+		}
+	};
+
+	static constexpr uint32_t c(Component component)
+	{
+		return static_cast<uint32_t>(component);
+	}
+
+	void sample_local_matrices_scalar(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame, float alpha, glm::mat4* out)
+	{
+		const Rows rows(animation, frame, next_frame);
+
+		for (uint32_t i = 0; i < animation.channel_stride; i++)
+		{
+			float v[static_cast<uint32_t>(Component::Count)];
+
+			for (uint32_t j = 0; j < static_cast<uint32_t>(Component::Count); j++)
+				v[j] = rows.a[j][i] + (rows.b[j][i] - rows.a[j][i]) * alpha;
+
+			float x = v[c(Component::RotationX)], y = v[c(Component::RotationY)], z = v[c(Component::RotationZ)], w = v[c(Component::RotationW)];
+
+			const float inv_length = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+			x *= inv_length; y *= inv_length; z *= inv_length; w *= inv_length;
+
+			const float sx = v[c(Component::ScaleX)], sy = v[c(Component::ScaleY)], sz = v[c(Component::ScaleZ)];
+
+			glm::mat4& m = out[i];
+
+			m[0][0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+			m[0][1] = (2.0f * (x * y + w * z)) * sx;
+			m[0][2] = (2.0f * (x * z - w * y)) * sx;
+			m[0][3] = 0.0f;
+
+			m[1][0] = (2.0f * (x * y - w * z)) * sy;
+			m[1][1] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+			m[1][2] = (2.0f * (y * z + w * x)) * sy;
+			m[1][3] = 0.0f;
+
+			m[2][0] = (2.0f * (x * z + w * y)) * sz;
+			m[2][1] = (2.0f * (y * z - w * x)) * sz;
+			m[2][2] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+			m[2][3] = 0.0f;
+
+			m[3][0] = v[c(Component::TranslationX)];
+			m[3][1] = v[c(Component::TranslationY)];
+			m[3][2] = v[c(Component::TranslationZ)];
+			m[3][3] = 1.0f;
+		}
+	}
+
+#ifdef POSE_KERNEL_X86
+	// Transposes four rows of per-channel values into the matching column of four consecutive matrices.
+	static inline void store_columns(glm::mat4* out, int column, __m128 r0, __m128 r1, __m128 r2, __m128 r3)
+	{
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		_mm_storeu_ps(&out[0][column][0], r0);
+		_mm_storeu_ps(&out[1][column][0], r1);
+		_mm_storeu_ps(&out[2][column][0], r2);
+		_mm_storeu_ps(&out[3][column][0], r3);
+	}
+
+	static void sample_local_matrices_sse(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame, float alpha, glm::mat4* out)
+	{
+		const Rows rows(animation, frame, next_frame);
+
+		const __m128 t = _mm_set1_ps(alpha);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (uint32_t i = 0; i < animation.channel_stride; i += 4)
+		{
+			__m128 v[static_cast<uint32_t>(Component::Count)];
+
+			for (uint32_t j = 0; j < static_cast<uint32_t>(Component::Count); j++)
+			{
+				const __m128 a = _mm_loadu_ps(rows.a[j] + i);
+				const __m128 b = _mm_loadu_ps(rows.b[j] + i);
+				v[j] = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+			}
+
+			__m128 x = v[c(Component::RotationX)], y = v[c(Component::RotationY)], z = v[c(Component::RotationZ)], w = v[c(Component::RotationW)];
+
+			const __m128 length_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+			const __m128 inv_length = _mm_div_ps(one, _mm_sqrt_ps(length_sq));
+			x = _mm_mul_ps(x, inv_length); y = _mm_mul_ps(y, inv_length); z = _mm_mul_ps(z, inv_length); w = _mm_mul_ps(w, inv_length);
+
+			const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+			const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+			const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+			const __m128 sx = v[c(Component::ScaleX)], sy = v[c(Component::ScaleY)], sz = v[c(Component::ScaleZ)];
+
+			store_columns(out + i, 0,
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+				zero);
+
+			store_columns(out + i, 1,
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+				zero);
+
+			store_columns(out + i, 2,
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+				zero);
+
+			store_columns(out + i, 3, v[c(Component::TranslationX)], v[c(Component::TranslationY)], v[c(Component::TranslationZ)], one);
+		}
+	}
+
+	POSE_KERNEL_TARGET_AVX static inline void store_columns_avx(glm::mat4* out, int column, __m256 r0, __m256 r1, __m256 r2, __m256 r3)
+	{
+		store_columns(out, column, _mm256_castps256_ps128(r0), _mm256_castps256_ps128(r1), _mm256_castps256_ps128(r2), _mm256_castps256_ps128(r3));
+		store_columns(out + 4, column, _mm256_extractf128_ps(r0, 1), _mm256_extractf128_ps(r1, 1), _mm256_extractf128_ps(r2, 1), _mm256_extractf128_ps(r3, 1));
+	}
+
+	POSE_KERNEL_TARGET_AVX static void sample_local_matrices_avx(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame, float alpha, glm::mat4* out)
+	{
+		const Rows rows(animation, frame, next_frame);
+
+		const __m256 t = _mm256_set1_ps(alpha);
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (uint32_t i = 0; i < animation.channel_stride; i += 8)
+		{
+			__m256 v[static_cast<uint32_t>(Component::Count)];
+
+			for (uint32_t j = 0; j < static_cast<uint32_t>(Component::Count); j++)
+			{
+				const __m256 a = _mm256_loadu_ps(rows.a[j] + i);
+				const __m256 b = _mm256_loadu_ps(rows.b[j] + i);
+				v[j] = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+			}
+
+			__m256 x = v[c(Component::RotationX)], y = v[c(Component::RotationY)], z = v[c(Component::RotationZ)], w = v[c(Component::RotationW)];
+
+			const __m256 length_sq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(w, w)));
+			const __m256 inv_length = _mm256_div_ps(one, _mm256_sqrt_ps(length_sq));
+			x = _mm256_mul_ps(x, inv_length); y = _mm256_mul_ps(y, inv_length); z = _mm256_mul_ps(z, inv_length); w = _mm256_mul_ps(w, inv_length);
+
+			const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+			const __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+			const __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+			const __m256 sx = v[c(Component::ScaleX)], sy = v[c(Component::ScaleY)], sz = v[c(Component::ScaleZ)];
+
+			store_columns_avx(out + i, 0,
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+				zero);
+
+			store_columns_avx(out + i, 1,
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+				zero);
+
+			store_columns_avx(out + i, 2,
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz),
+				zero);
+
+			store_columns_avx(out + i, 3, v[c(Component::TranslationX)], v[c(Component::TranslationY)], v[c(Component::TranslationZ)], one);
+		}
+	}
+
+	static bool cpu_supports_avx()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 1);
+
+		const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+
+		return os_saves_ymm && (info[2] & (1 << 28));
+#else
+		__builtin_cpu_init();
+
+		return __builtin_cpu_supports("avx");
+#endif
+	}
+#endif
+
+#ifdef POSE_KERNEL_NEON
+	static inline void store_columns(glm::mat4* out, int column, float32x4_t r0, float32x4_t r1, float32x4_t r2, float32x4_t r3)
+	{
+		const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+		const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+
+		vst1q_f32(&out[0][column][0], vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+		vst1q_f32(&out[1][column][0], vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])));
+		vst1q_f32(&out[2][column][0], vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+		vst1q_f32(&out[3][column][0], vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+	}
+
+	static void sample_local_matrices_neon(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame, float alpha, glm::mat4* out)
+	{
+		const Rows rows(animation, frame, next_frame);
+
+		const float32x4_t one = vdupq_n_f32(1.0f);
+		const float32x4_t two = vdupq_n_f32(2.0f);
+		const float32x4_t zero = vdupq_n_f32(0.0f);
+
+		for (uint32_t i = 0; i < animation.channel_stride; i += 4)
+		{
+			float32x4_t v[static_cast<uint32_t>(Component::Count)];
+
+			for (uint32_t j = 0; j < static_cast<uint32_t>(Component::Count); j++)
+			{
+				const float32x4_t a = vld1q_f32(rows.a[j] + i);
+				const float32x4_t b = vld1q_f32(rows.b[j] + i);
+				v[j] = vmlaq_n_f32(a, vsubq_f32(b, a), alpha);
+			}
+
+			float32x4_t x = v[c(Component::RotationX)], y = v[c(Component::RotationY)], z = v[c(Component::RotationZ)], w = v[c(Component::RotationW)];
+
+			const float32x4_t length_sq = vaddq_f32(vaddq_f32(vmulq_f32(x, x), vmulq_f32(y, y)), vaddq_f32(vmulq_f32(z, z), vmulq_f32(w, w)));
+
+			// Reciprocal square root estimate refined with two Newton-Raphson steps.
+			float32x4_t inv_length = vrsqrteq_f32(length_sq);
+			inv_length = vmulq_f32(inv_length, vrsqrtsq_f32(vmulq_f32(length_sq, inv_length), inv_length));
+			inv_length = vmulq_f32(inv_length, vrsqrtsq_f32(vmulq_f32(length_sq, inv_length), inv_length));
+
+			x = vmulq_f32(x, inv_length); y = vmulq_f32(y, inv_length); z = vmulq_f32(z, inv_length); w = vmulq_f32(w, inv_length);
+
+			const float32x4_t xx = vmulq_f32(x, x), yy = vmulq_f32(y, y), zz = vmulq_f32(z, z);
+			const float32x4_t xy = vmulq_f32(x, y), xz = vmulq_f32(x, z), yz = vmulq_f32(y, z);
+			const float32x4_t wx = vmulq_f32(w, x), wy = vmulq_f32(w, y), wz = vmulq_f32(w, z);
+
+			const float32x4_t sx = v[c(Component::ScaleX)], sy = v[c(Component::ScaleY)], sz = v[c(Component::ScaleZ)];
+
+			store_columns(out + i, 0,
+				vmulq_f32(vmlsq_f32(one, two, vaddq_f32(yy, zz)), sx),
+				vmulq_f32(vmulq_f32(two, vaddq_f32(xy, wz)), sx),
+				vmulq_f32(vmulq_f32(two, vsubq_f32(xz, wy)), sx),
+				zero);
+
+			store_columns(out + i, 1,
+				vmulq_f32(vmulq_f32(two, vsubq_f32(xy, wz)), sy),
+				vmulq_f32(vmlsq_f32(one, two, vaddq_f32(xx, zz)), sy),
+				vmulq_f32(vmulq_f32(two, vaddq_f32(yz, wx)), sy),
+				zero);
+
+			store_columns(out + i, 2,
+				vmulq_f32(vmulq_f32(two, vaddq_f32(xz, wy)), sz),
+				vmulq_f32(vmulq_f32(two, vsubq_f32(yz, wx)), sz),
+				vmulq_f32(vmlsq_f32(one, two, vaddq_f32(xx, yy)), sz),
+				zero);
+
+			store_columns(out + i, 3, v[c(Component::TranslationX)], v[c(Component::TranslationY)], v[c(Component::TranslationZ)], one);
+		}
+	}
+#endif
+
+	using SampleFn_t = void(*)(const BakedAnimation&, uint32_t, uint32_t, float, glm::mat4*);
+
+	static Implementation implementation = Implementation::Scalar;
+	static SampleFn_t sample_fn = sample_local_matrices_scalar;
+
+	bool is_supported(Implementation implementation)
+	{
+		switch (implementation)
+		{
+		case Implementation::Scalar:
+			return true;
+#ifdef POSE_KERNEL_X86
+		case Implementation::SSE:
+			return true;
+		case Implementation::AVX:
+			return cpu_supports_avx();
+#endif
+#ifdef POSE_KERNEL_NEON
+		case Implementation::NEON:
+			return true;
+#endif
+		default:
+			return false;
+		}
+	}
+
+	bool set_implementation(Implementation new_implementation)
+	{
+		if (!is_supported(new_implementation))
+			return false;
+
+		switch (new_implementation)
+		{
+#ifdef POSE_KERNEL_X86
+		case Implementation::SSE:
+			sample_fn = sample_local_matrices_sse;
+			break;
+		case Implementation::AVX:
+			sample_fn = sample_local_matrices_avx;
+			break;
+#endif
+#ifdef POSE_KERNEL_NEON
+		case Implementation::NEON:
+			sample_fn = sample_local_matrices_neon;
+			break;
+#endif
+		default:
+			sample_fn = sample_local_matrices_scalar;
+			break;
+		}
+
+		implementation = new_implementation;
+
+		return true;
+	}
+
+	static void select_best_implementation()
+	{
+		const Implementation preferred[] = { Implementation::AVX, Implementation::SSE, Implementation::NEON, Implementation::Scalar };
+
+		for (const Implementation candidate : preferred)
+			if (set_implementation(candidate))
+				return;
+	}
+
+	static const bool best_implementation_selected = (select_best_implementation(), true);
+
+	Implementation get_implementation()
+	{
+		return implementation;
+	}
+
+	const char* get_implementation_name(Implementation implementation)
+	{
+		switch (implementation)
+		{
+		case Implementation::SSE: return "SSE";
+		case Implementation::AVX: return "AVX";
+		case Implementation::NEON: return "NEON";
+		default: return "Scalar";
+		}
+	}
+
+	void sample_local_matrices(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame, float alpha, glm::mat4* out)
+	{
+		sample_fn(animation, frame, next_frame, alpha, out);
+	}
+
+	void sample_local_matrices(const BakedAnimation& animation, float animation_time, glm::mat4* out)
+	{
+		uint32_t frame, next_frame;
+		float alpha;
+
+		animation.get_frames(animation_time, frame, next_frame, alpha);
+
+		sample_local_matrices(animation, frame, next_frame, alpha, out);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+class BakedAnimation;
+
+// Batch sampling of baked clips: lerps translation/scale, nlerps rotation and composes
+// the local TRS matrix for 4 (SSE, NEON) or 8 (AVX) channels at a time.
+namespace pose_kernel
+{
+	enum class Implementation
+	{
+		Scalar,
+		SSE,
+		AVX,
+		NEON
+	};
+
+	// Writes the local matrix of every channel between frame and next_frame. out must hold animation.channel_stride matrices.
+	void sample_local_matrices(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame, float alpha, glm::mat4* out);
+	void sample_local_matrices(const BakedAnimation& animation, float animation_time, glm::mat4* out);
+
+	// Reference implementation the vector paths are checked against.
+	void sample_local_matrices_scalar(const BakedAnimation& animation, uint32_t frame, uint32_t next_frame, float alpha, glm::mat4* out);
+
+	bool is_supported(Implementation implementation);
+
+	// The widest supported implementation is selected at startup. Returns false if the requested one isn't supported.
+	bool set_implementation(Implementation implementation);
+	Implementation get_implementation();
+
+	const char* get_implementation_name(Implementation implementation);
+}
@@ -0,0 +1,113 @@
+#include "pose_query.h"
+
+#include "baked_animation.h"
+#include "binding.h"
+#include "root_motion.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Globals of the chain during one evaluation, per thread so a shared query stays const.
+static thread_local std::vector<glm::mat4> chain_globals;
+
+PoseQuery::PoseQuery(RigPtr_t p_rig, const std::vector<std::string>& node_names) : rig{std::move(p_rig)}
+{
+	std::vector<int32_t> nodes(node_names.size());
+
+	for (uint32_t i = 0; i < node_names.size(); i++)
+		nodes[i] = rig->skeleton.find_node(node_names[i]);
+
+	build(nodes);
+}
+
+PoseQuery::PoseQuery(RigPtr_t p_rig, const std::vector<int32_t>& nodes) : rig{std::move(p_rig)}
+{
+	build(nodes);
+}
+
+void PoseQuery::build(const std::vector<int32_t>& nodes)
+{
+	const Skeleton& skeleton = rig->skeleton;
+
+	std::vector<uint8_t> needed(skeleton.get_amount_of_nodes(), 0);
+
+	for (int32_t node : nodes)
+		for (int32_t i = node; i >= 0 && i < needed.size() && !needed[i]; i = skeleton.nodes[i].parent)
+			needed[i] = 1;
+
+	// Walking the marks in node order keeps parents ahead of their children.
+	std::vector<int32_t> chain_positions(skeleton.get_amount_of_nodes(), -1);
+
+	for (uint32_t i = 0; i < needed.size(); i++)
+	{
+		if (!needed[i])
+			continue;
+
+		const int32_t parent = skeleton.nodes[i].parent;
+
+		chain_positions[i] = chain.size();
+		chain.push_back(i);
+		chain_parents.push_back(parent < 0 ? -1 : chain_positions[parent]);
+	}
+
+	outputs.resize(nodes.size());
+
+	for (uint32_t i = 0; i < nodes.size(); i++)
+		outputs[i] = nodes[i] >= 0 && nodes[i] < chain_positions.size() ? chain_positions[nodes[i]] : -1;
+}
+
+void PoseQuery::evaluate(float time, const BakedAnimation& animation, const AnimationBinding& binding, glm::mat4* out, const RootMotion* root_motion) const
+{
+	const float time_in_ticks = time * animation.ticks_per_second;
+	const float current_time = fmod(time_in_ticks, animation.duration);
+
+	evaluate_ticks(current_time, animation, binding, out);
+
+	if (!root_motion)
+		return;
+
+	const glm::mat4 in_place = glm::inverse(root_motion->get_matrix(current_time));
+
+	for (uint32_t i = 0; i < outputs.size(); i++)
+		out[i] = in_place * out[i];
+}
+
+void PoseQuery::evaluate_ticks(float animation_time, const BakedAnimation& animation, const AnimationBinding& binding, glm::mat4* out) const
+{
+	const Skeleton& skeleton = rig->skeleton;
+
+	uint32_t frame, next_frame;
+	float alpha;
+
+	animation.get_frames(animation_time, frame, next_frame, alpha);
+
+	chain_globals.resize(chain.size());
+
+	for (uint32_t i = 0; i < chain.size(); i++)
+	{
+		const int32_t node = chain[i];
+		const int32_t channel = binding.node_channels[node];
+
+		const glm::mat4 node_transform = channel >= 0 ? animation.sample(frame, next_frame, alpha, channel).to_matrix() : skeleton.nodes[node].transformation;
+
+		chain_globals[i] = chain_parents[i] < 0 ? node_transform : chain_globals[chain_parents[i]] * node_transform;
+	}
+
+	for (uint32_t i = 0; i < outputs.size(); i++)
+		out[i] = outputs[i] >= 0 ? rig->global_inverse_transform * chain_globals[outputs[i]] : glm::mat4(1.0f);
+}
+
+uint32_t PoseQuery::get_node_count() const
+{
+	return outputs.size();
+}
+
+uint32_t PoseQuery::get_evaluated_count() const
+{
+	return chain.size();
+}
+
+const Rig& PoseQuery::get_rig() const
+{
+	return *rig;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "rig.h"
+
+class BakedAnimation;
+class AnimationBinding;
+class RootMotion;
+
+// Model-space transforms of a few nodes, e.g. the root, hands and head for hit detection, without posing the whole
+// avatar. Only the requested nodes and their ancestors are sampled and multiplied; everything else in the skeleton is
+// never touched. The chain is worked out once, evaluating doesn't allocate, and nothing is written to an Avatar,
+// so one query can be shared by any number of threads and needs no GL context.
+class PoseQuery
+{
+public:
+	// Names that aren't in the skeleton come out as identity matrices.
+	PoseQuery(RigPtr_t rig, const std::vector<std::string>& node_names);
+	PoseQuery(RigPtr_t rig, const std::vector<int32_t>& nodes);
+
+	// out receives get_node_count() matrices in the order the nodes were requested, in the same space as
+	// Avatar::calculate_pose before the offset matrices. time is in seconds and wraps like calculate_pose.
+	// With root_motion, the clip's root motion up to time is taken out again, so the pose stays in place.
+	void evaluate(float time, const BakedAnimation& animation, const AnimationBinding& binding, glm::mat4* out, const RootMotion* root_motion = nullptr) const;
+
+	// Same for a time in ticks already within the clip.
+	void evaluate_ticks(float animation_time, const BakedAnimation& animation, const AnimationBinding& binding, glm::mat4* out) const;
+
+	uint32_t get_node_count() const;
+
+	// Requested nodes plus their ancestors, the nodes an evaluation visits.
+	uint32_t get_evaluated_count() const;
+
+	const Rig& get_rig() const;
+
+private:
+	void build(const std::vector<int32_t>& nodes);
+
+	RigPtr_t rig;
+
+	// Skeleton nodes to evaluate in parent-before-child order, with the position of each one's parent in chain, -1 for the root.
+	std::vector<int32_t> chain;
+	std::vector<int32_t> chain_parents;
+
+	// Position in chain of every requested node, -1 for the ones that weren't found.
+	std::vector<int32_t> outputs;
+};
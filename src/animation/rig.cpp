@@ -0,0 +1,42 @@
+#include "rig.h"
+
+Rig::Rig(const OffsetPerNameVec_t& bones, const Bone& root)
+{
+	for (int i = 0; i < bones.size(); i++)
+	{
+		const std::string& bone_name = bones[i].first;
+
+		if (bones_map.find(bone_name) == bones_map.end())
+		{
+			bones_map[bone_name] = offset_matrices.size();
+			offset_matrices.push_back(bones[i].second);
+		}
+	}
+
+	skeleton = Skeleton(root, bones_map);
+	global_inverse_transform = glm::inverse(root.transformation);
+}
+
+Rig::Rig(Skeleton skeleton, std::vector<glm::mat4> offset_matrices, const glm::mat4& global_inverse_transform, const std::vector<std::string>& bone_names) :
+	skeleton{std::move(skeleton)},
+	offset_matrices{std::move(offset_matrices)},
+	global_inverse_transform{global_inverse_transform}
+{
+	for (int i = 0; i < bone_names.size(); i++)
+		bones_map[bone_names[i]] = i;
+}
+
+uint32_t Rig::get_amount_of_bones() const
+{
+	return offset_matrices.size();
+}
+
+std::vector<std::string> Rig::get_bone_names() const
+{
+	std::vector<std::string> bone_names(bones_map.size());
+
+	for (const auto& [name, index] : bones_map)
+		bone_names[index] = name;
+
+	return bone_names;
+}
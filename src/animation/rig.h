@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "skeleton.h"
+
+// Immutable description of a skinned character: topology, bone names and bind data.
+// Built once per model and shared by every avatar that uses it.
+class Rig
+{
+public:
+	Rig(const OffsetPerNameVec_t& bones, const Bone& root);
+
+	// bone_names[i] is the bone that uses offset_matrices[i].
+	Rig(Skeleton skeleton, std::vector<glm::mat4> offset_matrices, const glm::mat4& global_inverse_transform, const std::vector<std::string>& bone_names);
+
+	Skeleton skeleton;
+
+	std::vector<glm::mat4> offset_matrices;
+	glm::mat4 global_inverse_transform;
+
+	std::map<std::string, uint32_t> bones_map;
+
+	uint32_t get_amount_of_bones() const;
+
+	// Names in bone index order, the inverse of bones_map.
+	std::vector<std::string> get_bone_names() const;
+
+private:
+	Rig(const Rig&) = delete;
+	Rig& operator=(const Rig&) = delete;
+};
+
+using RigPtr_t = std::shared_ptr<const Rig>;
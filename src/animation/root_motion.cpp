@@ -0,0 +1,158 @@
+#include "root_motion.h"
+
+#include "baked_animation.h"
+#include "binding.h"
+#include "pose_query.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const glm::vec3 UP(0.0f, 1.0f, 0.0f);
+
+static constexpr float TWO_PI = 6.28318530718f;
+
+RootMotion::RootMotion(const RigPtr_t& rig, const BakedAnimation& animation, const AnimationBinding& binding, int32_t root_node) :
+	duration{animation.duration}, ticks_per_second{animation.ticks_per_second}, ticks_per_frame{animation.ticks_per_frame}
+{
+	const uint32_t frame_count = std::max(animation.frame_count, 1u);
+
+	positions.assign(frame_count, glm::vec3(0.0f));
+	yaws.assign(frame_count, 0.0f);
+
+	if (root_node < 0)
+		return;
+
+	const PoseQuery query(rig, std::vector<int32_t>{ root_node });
+
+	glm::quat first_rotation;
+
+	for (uint32_t frame = 0; frame < frame_count; frame++)
+	{
+		glm::mat4 root;
+		query.evaluate_ticks(frame * ticks_per_frame, animation, binding, &root);
+
+		const Transform transform = Transform::from_matrix(root);
+
+		positions[frame] = glm::vec3(transform.translation.x, 0.0f, transform.translation.z);
+
+		if (frame == 0)
+		{
+			first_rotation = transform.rotation;
+			continue;
+		}
+
+		// Twist around the up axis of the rotation since the first frame, kept within half a turn of the frame before.
+		const glm::quat turn = transform.rotation * glm::inverse(first_rotation);
+		float yaw = 2.0f * std::atan2(turn.y, turn.w);
+
+		yaw -= TWO_PI * std::round((yaw - yaws[frame - 1]) / TWO_PI);
+		yaws[frame] = yaw;
+	}
+}
+
+int32_t RootMotion::find_root_node(const Skeleton& skeleton, const AnimationBinding& binding)
+{
+	// Parents come first, so the first animated node has no animated ancestors.
+	for (uint32_t i = 0; i < skeleton.get_amount_of_nodes(); i++)
+		if (binding.node_channels[i] >= 0)
+			return i;
+
+	return -1;
+}
+
+Transform RootMotion::sample(float time) const
+{
+	const float current_time = fmod(time * ticks_per_second, duration);
+
+	return to_transform(get_difference(get_motion(0.0f), get_motion(current_time)));
+}
+
+Transform RootMotion::get_delta(float from, float to) const
+{
+	const float from_ticks = from * ticks_per_second;
+	const float to_ticks = std::max(to, from) * ticks_per_second;
+
+	const float from_loop = std::floor(from_ticks / duration);
+	const float to_loop = std::floor(to_ticks / duration);
+
+	const Motion start = get_motion(from_ticks - from_loop * duration);
+	const Motion end = get_motion(to_ticks - to_loop * duration);
+
+	if (from_loop == to_loop)
+		return to_transform(get_difference(start, end));
+
+	// To the end of the clip, any whole passes through it, then from its start on.
+	const Motion first = get_motion(0.0f);
+	const Motion cycle = get_difference(first, get_motion(duration));
+
+	Motion delta = get_difference(start, get_motion(duration));
+
+	for (float loop = from_loop + 1.0f; loop < to_loop; loop++)
+		delta = combine(delta, cycle);
+
+	return to_transform(combine(delta, get_difference(first, end)));
+}
+
+glm::mat4 RootMotion::get_matrix(float animation_time) const
+{
+	const Motion motion = get_motion(animation_time);
+
+	// Turns around where the root started, then moves it to where it is now.
+	return glm::translate(glm::mat4(1.0f), motion.translation) * glm::mat4_cast(glm::angleAxis(motion.yaw, UP)) * glm::translate(glm::mat4(1.0f), -positions[0]);
+}
+
+Transform RootMotion::get_cycle() const
+{
+	return to_transform(get_difference(get_motion(0.0f), get_motion(duration)));
+}
+
+uint32_t RootMotion::get_frame_count() const
+{
+	return positions.size();
+}
+
+RootMotion::Motion RootMotion::get_motion(float animation_time) const
+{
+	// The same frame split as BakedAnimation::get_frames.
+	const uint32_t frame_count = positions.size();
+
+	const float frame_time = std::max(animation_time, 0.0f) / ticks_per_frame;
+	const float whole_frames = std::floor(frame_time);
+
+	const uint32_t frame = std::min(static_cast<uint32_t>(whole_frames), frame_count - 1);
+	const uint32_t next_frame = std::min(frame + 1, frame_count - 1);
+	const float alpha = frame == next_frame ? 0.0f : frame_time - whole_frames;
+
+	Motion motion;
+	motion.translation = positions[frame] + (positions[next_frame] - positions[frame]) * alpha;
+	motion.yaw = yaws[frame] + (yaws[next_frame] - yaws[frame]) * alpha;
+
+	return motion;
+}
+
+RootMotion::Motion RootMotion::combine(const Motion& a, const Motion& b)
+{
+	Motion motion;
+	motion.translation = a.translation + glm::angleAxis(a.yaw, UP) * b.translation;
+	motion.yaw = a.yaw + b.yaw;
+
+	return motion;
+}
+
+RootMotion::Motion RootMotion::get_difference(const Motion& a, const Motion& b)
+{
+	Motion motion;
+	motion.translation = glm::angleAxis(-a.yaw, UP) * (b.translation - a.translation);
+	motion.yaw = b.yaw - a.yaw;
+
+	return motion;
+}
+
+Transform RootMotion::to_transform(const Motion& motion)
+{
+	Transform transform;
+	transform.translation = motion.translation;
+	transform.rotation = glm::angleAxis(motion.yaw, UP);
+
+	return transform;
+}
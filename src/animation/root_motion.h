@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+#include "rig.h"
+#include "transform.h"
+
+class BakedAnimation;
+class AnimationBinding;
+
+// Movement of a clip's root over the ground, Y up, pulled out as a track of its own at the clip's baked frames: the
+// model-space position of the root node on the ground plane and its heading around Y, relative to the first frame.
+// Gameplay moves the character by get_delta and poses it in place through PoseQuery, while the clip itself stays
+// untouched, so mapped assets work as well. Extracted once per rig and clip; sampling is const and needs no GL context.
+class RootMotion
+{
+public:
+	RootMotion(const RigPtr_t& rig, const BakedAnimation& animation, const AnimationBinding& binding, int32_t root_node);
+
+	// The topmost node the clip animates, usually the hips; -1 when it animates none.
+	static int32_t find_root_node(const Skeleton& skeleton, const AnimationBinding& binding);
+
+	// Motion from the start of the clip up to time, in seconds; wraps like Avatar::calculate_pose.
+	Transform sample(float time) const;
+
+	// Motion between two points of continuous playback, times in seconds with to not before from; loops the clip runs
+	// through in between are included. Expressed relative to the root's position and heading at from.
+	Transform get_delta(float from, float to) const;
+
+	// The motion as a model-space matrix at a time in ticks within the clip, identity at its start.
+	glm::mat4 get_matrix(float animation_time) const;
+
+	// Distance and turn over one pass through the clip.
+	Transform get_cycle() const;
+
+	uint32_t get_frame_count() const;
+
+private:
+	// Ground-plane position and heading of the root, or a change of them.
+	struct Motion
+	{
+		glm::vec3 translation{0.0f};
+		float yaw{0.0f};
+	};
+
+	Motion get_motion(float animation_time) const;
+
+	// b applied after a, b being relative to where a ends.
+	static Motion combine(const Motion& a, const Motion& b);
+
+	// From a to b, relative to a.
+	static Motion get_difference(const Motion& a, const Motion& b);
+
+	static Transform to_transform(const Motion& motion);
+
+	float duration;
+	float ticks_per_second;
+	float ticks_per_frame;
+
+	// Per baked frame; yaws are unwrapped, so they keep growing over a clip turning on the spot.
+	std::vector<glm::vec3> positions;
+	std::vector<float> yaws;
+};
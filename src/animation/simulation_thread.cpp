@@ -0,0 +1,249 @@
+#include "simulation_thread.h"
+
+#include "animation_world.h"
+#include "dual_quaternion.h"
+#include "transform.h"
+
+#include "../core/jobs/job_system.h"
+#include "../core/profiler/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+// Steps the simulation may run back to back to catch up after a stall; further behind, simulated time slows down instead.
+static constexpr uint32_t MAX_CATCH_UP_STEPS = 4;
+
+// Instances blended by a single job.
+static constexpr uint32_t INTERPOLATION_BATCH_SIZE = 32;
+
+static double get_seconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SimulationThread::SimulationThread(AnimationWorld& world, JobSystem& job_system, float time_step) : world{world}, job_system{job_system}, time_step{time_step}
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start()
+{
+	if (running)
+		return;
+
+	const uint32_t instance_count = world.get_instance_count();
+
+	palette_offsets.resize(instance_count + 1);
+
+	for (uint32_t i = 0; i < instance_count; i++)
+		palette_offsets[i] = world.get_palette_offset(i);
+
+	palette_offsets[instance_count] = world.get_palette_count();
+
+	for (Snapshot& snapshot : snapshots)
+	{
+		snapshot.palettes.assign(get_palette_count(), glm::mat4(1));
+		snapshot.visible.assign(instance_count, 0);
+	}
+
+	step_count = 0;
+	clock_start = get_seconds();
+
+	running = true;
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+	running = false;
+
+	if (thread.joinable())
+		thread.join();
+}
+
+void SimulationThread::run()
+{
+	profiler::set_thread_name("Simulation");
+
+	while (running)
+	{
+		step();
+
+		double wake;
+
+		{
+			const std::lock_guard<std::mutex> lock(snapshot_mutex);
+
+			const double now = get_seconds();
+			wake = clock_start + step_count * static_cast<double>(time_step);
+
+			if (now - wake > MAX_CATCH_UP_STEPS * time_step)
+			{
+				clock_start += now - wake;
+				wake = now;
+			}
+		}
+
+		const double now = get_seconds();
+
+		if (wake > now)
+			std::this_thread::sleep_for(std::chrono::duration<double>(wake - now));
+	}
+}
+
+void SimulationThread::step()
+{
+	PROFILE_ZONE("Simulation step");
+
+	{
+		const std::lock_guard<std::mutex> lock(view_mutex);
+
+		if (view_pending)
+		{
+			view.visible.swap(pending_view.visible);
+			view.camera_distances.swap(pending_view.camera_distances);
+			view_pending = false;
+		}
+	}
+
+	const uint32_t instance_count = world.get_instance_count();
+
+	if (view.visible.size() == instance_count && view.camera_distances.size() == instance_count)
+	{
+		for (uint32_t i = 0; i < instance_count; i++)
+		{
+			world.set_visible(i, view.visible[i]);
+			world.set_camera_distance(i, view.camera_distances[i]);
+		}
+	}
+
+	world.set_palette_storage(writing->palettes.data());
+	world.update(time_step);
+
+	for (uint32_t i = 0; i < instance_count; i++)
+		writing->visible[i] = world.is_visible(i);
+
+	writing->posed_count = world.get_posed_count();
+
+	const std::lock_guard<std::mutex> lock(snapshot_mutex);
+
+	step_count++;
+	writing->time = step_count * static_cast<double>(time_step);
+
+	Snapshot* const oldest = previous;
+	previous = latest;
+	latest = writing;
+	writing = oldest;
+}
+
+void SimulationThread::submit_view(const View& p_view)
+{
+	const std::lock_guard<std::mutex> lock(view_mutex);
+
+	// Copied rather than swapped, so the caller can keep updating only what changed; the sizes stay put, so this doesn't allocate.
+	pending_view.visible = p_view.visible;
+	pending_view.camera_distances = p_view.camera_distances;
+	view_pending = true;
+}
+
+bool SimulationThread::has_snapshots() const
+{
+	const std::lock_guard<std::mutex> lock(snapshot_mutex);
+
+	return step_count >= 2;
+}
+
+void SimulationThread::blend_snapshots(glm::mat4* output, DualQuaternion* dual_quaternion_output, uint8_t* posed)
+{
+	const std::lock_guard<std::mutex> lock(snapshot_mutex);
+
+	const Snapshot& from = *previous;
+	const Snapshot& to = *latest;
+
+	// One step behind, so the frame usually falls between the two snapshots; if the simulation is late the latest one holds.
+	render_time = std::clamp(get_seconds() - clock_start - time_step, from.time, to.time);
+
+	const float blend = to.time > from.time ? static_cast<float>((render_time - from.time) / (to.time - from.time)) : 1.0f;
+
+	job_system.parallel_for(get_instance_count(), INTERPOLATION_BATCH_SIZE, [this, &from, &to, blend, output, dual_quaternion_output, posed](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			posed[i] = to.visible[i];
+
+			const uint32_t first = palette_offsets[i];
+			const uint32_t last = palette_offsets[i + 1];
+
+			// Just came into view, the older snapshot has nothing to blend from.
+			const float weight = from.visible[i] ? blend : 1.0f;
+
+			// Outputs may be mapped write-combined memory, so they're only ever written.
+			for (uint32_t j = first; j < last; j++)
+			{
+				// Blended as transforms, which also keeps the dual quaternion conversion fed rigid matrices.
+				const glm::mat4 palette = weight < 1.0f ? blend_matrices(from.palettes[j], to.palettes[j], weight) : to.palettes[j];
+
+				if (output)
+					output[j] = palette;
+
+				if (dual_quaternion_output)
+					dual_quaternion_output[j] = DualQuaternion::from_matrix(palette);
+			}
+		}
+	});
+}
+
+void SimulationThread::interpolate(glm::mat4* output, uint8_t* posed)
+{
+	PROFILE_ZONE("Interpolate poses");
+
+	blend_snapshots(output, nullptr, posed);
+}
+
+void SimulationThread::interpolate(glm::mat4* output, DualQuaternion* dual_quaternion_output, uint8_t* posed)
+{
+	PROFILE_ZONE("Interpolate poses");
+
+	blend_snapshots(output, dual_quaternion_output, posed);
+}
+
+double SimulationThread::get_render_time() const
+{
+	return render_time;
+}
+
+uint32_t SimulationThread::get_posed_count() const
+{
+	const std::lock_guard<std::mutex> lock(snapshot_mutex);
+
+	return latest->posed_count;
+}
+
+float SimulationThread::get_time_step() const
+{
+	return time_step;
+}
+
+uint32_t SimulationThread::get_instance_count() const
+{
+	return palette_offsets.empty() ? 0 : static_cast<uint32_t>(palette_offsets.size()) - 1;
+}
+
+uint32_t SimulationThread::get_palette_offset(uint32_t instance) const
+{
+	return palette_offsets[instance];
+}
+
+uint32_t SimulationThread::get_bone_count(uint32_t instance) const
+{
+	return palette_offsets[instance + 1] - palette_offsets[instance];
+}
+
+uint32_t SimulationThread::get_palette_count() const
+{
+	return palette_offsets.empty() ? 0 : palette_offsets.back();
+}
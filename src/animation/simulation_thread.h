@@ -0,0 +1,116 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AnimationWorld;
+class JobSystem;
+
+struct DualQuaternion;
+
+// Runs an AnimationWorld at a fixed time step on its own thread, so playback speed doesn't depend on the frame rate
+// and a slow update delays the next snapshot instead of the frame. Each step writes every palette into one of three
+// snapshots; the render thread blends the two most recent ones for a time one step behind the simulation.
+// Between start() and stop() the world belongs to this thread, instances can't be added then. Other threads must not
+// call into the world meanwhile, not even its getters; the palette layout they need is copied at start(), see below.
+class SimulationThread
+{
+public:
+	// Culling and LOD input from the render thread, one entry per instance of the world.
+	struct View
+	{
+		std::vector<uint8_t> visible;
+		std::vector<float> camera_distances;
+	};
+
+	SimulationThread(AnimationWorld& world, JobSystem& job_system, float time_step);
+	~SimulationThread();
+
+	void start();
+	void stop();
+
+	// Picked up by the next step.
+	void submit_view(const View& view);
+
+	// Two steps have run, so there is something to interpolate.
+	bool has_snapshots() const;
+
+	// Writes the palettes of all instances for the current render time into output, get_palette_count() matrices
+	// laid out like AnimationWorld::get_palettes(), and per instance into posed whether its palette is current.
+	// Instances culled by the view the latest step ran with aren't; drawing them would show a stale pose.
+	// Only blocks the simulation if it finishes a step meanwhile.
+	void interpolate(glm::mat4* output, uint8_t* posed);
+
+	// Same, and the palettes converted to dual quaternions on the way into dual_quaternion_output as well, for
+	// materials using the DUAL_QUATERNIONS skinning variants. output may be nullptr when no material reads matrices.
+	void interpolate(glm::mat4* output, DualQuaternion* dual_quaternion_output, uint8_t* posed);
+
+	// Simulated seconds the last interpolate() blended for.
+	double get_render_time() const;
+
+	// Of the latest snapshot.
+	uint32_t get_posed_count() const;
+
+	float get_time_step() const;
+
+	// The world's palette layout as of start(), safe to read from any thread while the simulation runs.
+	uint32_t get_instance_count() const;
+	uint32_t get_palette_offset(uint32_t instance) const;
+	uint32_t get_bone_count(uint32_t instance) const;
+	uint32_t get_palette_count() const;
+
+private:
+	struct Snapshot
+	{
+		std::vector<glm::mat4> palettes;
+
+		// Culled instances leave their slot as it was, so only visible ones are worth blending from.
+		std::vector<uint8_t> visible;
+
+		double time{0.0};
+		uint32_t posed_count{0};
+	};
+
+	void run();
+
+	// Both interpolate()s, either output may be nullptr.
+	void blend_snapshots(glm::mat4* output, DualQuaternion* dual_quaternion_output, uint8_t* posed);
+
+	// Applies the latest view and advances the world by one step into the snapshot being written.
+	void step();
+
+	AnimationWorld& world;
+	JobSystem& job_system;
+
+	const float time_step;
+
+	// Where every instance's palette starts, plus the total palette count at the end.
+	std::vector<uint32_t> palette_offsets;
+
+	std::thread thread;
+	std::atomic<bool> running{false};
+
+	// Guards previous and latest (and which snapshots they are) against the swap at the end of a step.
+	mutable std::mutex snapshot_mutex;
+	Snapshot snapshots[3];
+	Snapshot* previous{&snapshots[0]};
+	Snapshot* latest{&snapshots[1]};
+	Snapshot* writing{&snapshots[2]};
+	uint32_t step_count{0};
+
+	// Wall clock seconds at simulated time 0; moved forward when the simulation falls too far behind to catch up.
+	double clock_start{0.0};
+	double render_time{0.0};
+
+	std::mutex view_mutex;
+	View pending_view;
+	View view;
+	bool view_pending{false};
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+};
@@ -0,0 +1,67 @@
+#include "skeleton.h"
+
+#include <algorithm>
+
+Skeleton::Skeleton(const Bone& root, const std::map<std::string, uint32_t>& bones_map)
+{
+	add_node(root, -1, bones_map);
+	link_nodes();
+}
+
+Skeleton::Skeleton(std::vector<SkeletonNode> nodes, std::vector<std::string> names) : nodes{std::move(nodes)}, names{std::move(names)}
+{
+	bind_pose.reserve(this->nodes.size());
+
+	for (const SkeletonNode& node : this->nodes)
+		bind_pose.push_back(Transform::from_matrix(node.transformation));
+
+	link_nodes();
+}
+
+void Skeleton::add_node(const Bone& bone, int32_t parent, const std::map<std::string, uint32_t>& bones_map)
+{
+	const int32_t index = static_cast<int32_t>(nodes.size());
+
+	SkeletonNode& node = nodes.emplace_back();
+	node.parent = parent;
+	node.transformation = bone.transformation;
+
+	const auto bone_it = bones_map.find(bone.name);
+	node.bone_index = bone_it != bones_map.end() ? static_cast<int32_t>(bone_it->second) : -1;
+
+	names.push_back(bone.name);
+	bind_pose.push_back(Transform::from_matrix(bone.transformation));
+
+	for (int i = 0; i < bone.children.size(); i++)
+		add_node(bone.children[i], index, bones_map);
+}
+
+void Skeleton::link_nodes()
+{
+	heights.assign(nodes.size(), 0);
+	parent_bones.assign(nodes.size(), -1);
+
+	for (int32_t i = 1; i < nodes.size(); i++)
+	{
+		const SkeletonNode& parent = nodes[nodes[i].parent];
+		parent_bones[i] = parent.bone_index >= 0 ? parent.bone_index : parent_bones[nodes[i].parent];
+	}
+
+	// Walking backwards finishes a node's height before its parent reads it.
+	for (int32_t i = static_cast<int32_t>(nodes.size()) - 1; i > 0; i--)
+		heights[nodes[i].parent] = std::max(heights[nodes[i].parent], heights[i] + 1);
+}
+
+int32_t Skeleton::find_node(const std::string& name) const
+{
+	for (int i = 0; i < names.size(); i++)
+		if (names[i] == name)
+			return i;
+
+	return -1;
+}
+
+uint32_t Skeleton::get_amount_of_nodes() const
+{
+	return nodes.size();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "transform.h"
+
+struct Bone
+{
+	std::string name;
+	glm::mat4 transformation;
+	std::vector<Bone> children;
+};
+
+using Skeleton_t = Bone;
+using OffsetPerName_t = std::pair<std::string, glm::mat4>;
+using OffsetPerNameVec_t = std::vector<OffsetPerName_t>;
+
+struct SkeletonNode
+{
+	// Index of the parent node, always lower than the node's own index. -1 for the root.
+	int32_t parent;
+
+	// Slot in the offset/palette arrays, -1 if the node doesn't deform any vertices.
+	int32_t bone_index;
+
+	glm::mat4 transformation;
+};
+
+// Flattened copy of the Bone tree. Nodes are stored in parent-before-child order,
+// so the whole hierarchy can be evaluated with a single linear loop.
+class Skeleton
+{
+public:
+	Skeleton() = default;
+	Skeleton(const Bone& root, const std::map<std::string, uint32_t>& bones_map);
+
+	// Nodes that are already flattened, e.g. loaded from a baked asset.
+	Skeleton(std::vector<SkeletonNode> nodes, std::vector<std::string> names);
+
+	std::vector<SkeletonNode> nodes;
+	std::vector<std::string> names;
+
+	// SkeletonNode::transformation split into components, the starting point for blended poses.
+	std::vector<Transform> bind_pose;
+
+	// Derived from nodes, so baked assets don't store them. Per node: generations of descendants below it (0 for leaves
+	// such as finger tips) and the bone index of the closest ancestor that deforms vertices, -1 if there is none.
+	std::vector<uint32_t> heights;
+	std::vector<int32_t> parent_bones;
+
+	int32_t find_node(const std::string& name) const;
+	uint32_t get_amount_of_nodes() const;
+
+private:
+	void add_node(const Bone& bone, int32_t parent, const std::map<std::string, uint32_t>& bones_map);
+	void link_nodes();
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+// Normalised lerp along the shorter arc between a and b.
+inline glm::quat nlerp_shortest(const glm::quat& a, const glm::quat& b, float t)
+{
+	const glm::quat target = glm::dot(a, b) < 0.0f ? -b : b;
+
+	return glm::normalize(a * (1.0f - t) + target * t);
+}
+
+// Constant angular velocity interpolation along the shorter arc; falls back to nlerp for nearly equal rotations.
+inline glm::quat slerp_shortest(const glm::quat& a, const glm::quat& b, float t)
+{
+	float cos_theta = glm::dot(a, b);
+	const glm::quat target = cos_theta < 0.0f ? -b : b;
+	cos_theta = std::fabs(cos_theta);
+
+	if (cos_theta > 0.9995f)
+		return nlerp_shortest(a, target, t);
+
+	const float theta = std::acos(cos_theta);
+	const float sin_theta = std::sin(theta);
+
+	return (a * std::sin((1.0f - t) * theta) + target * std::sin(t * theta)) * (1.0f / sin_theta);
+}
+
+// Local-space translation/rotation/scale of a single node.
+struct Transform
+{
+	glm::vec3 translation{0.0f};
+	glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+	glm::vec3 scale{1.0f};
+
+	inline glm::mat4 to_matrix() const
+	{
+		glm::mat4 matrix = glm::mat4_cast(rotation);
+
+		matrix[0] *= scale.x;
+		matrix[1] *= scale.y;
+		matrix[2] *= scale.z;
+		matrix[3] = glm::vec4(translation, 1.0f);
+
+		return matrix;
+	}
+
+	// Splits an affine matrix without shear into its components.
+	inline static Transform from_matrix(const glm::mat4& matrix)
+	{
+		Transform transform;
+
+		transform.translation = glm::vec3(matrix[3]);
+
+		glm::mat3 rotation = glm::mat3(matrix);
+
+		for (int i = 0; i < 3; i++)
+		{
+			transform.scale[i] = glm::length(rotation[i]);
+
+			// A collapsed axis keeps its zero column rather than turning into NaNs.
+			if (transform.scale[i] > 0.0f)
+				rotation[i] /= transform.scale[i];
+		}
+
+		// A mirrored basis keeps the rotation proper by flipping one axis.
+		if (glm::determinant(rotation) < 0.0f)
+		{
+			transform.scale.x = -transform.scale.x;
+			rotation[0] = -rotation[0];
+		}
+
+		transform.rotation = glm::normalize(glm::quat_cast(rotation));
+
+		return transform;
+	}
+};
+
+inline Transform blend(const Transform& a, const Transform& b, float t)
+{
+	return { a.translation + (b.translation - a.translation) * t, nlerp_shortest(a.rotation, b.rotation, t), a.scale + (b.scale - a.scale) * t };
+}
+
+// Interpolates two skinning matrices as transforms so an in-between rotation stays rigid instead of shrinking.
+// Shear isn't represented and is lost, which final palettes of rigs without non-uniform scale don't have.
+inline glm::mat4 blend_matrices(const glm::mat4& a, const glm::mat4& b, float t)
+{
+	const Transform from = Transform::from_matrix(a);
+	const Transform to = Transform::from_matrix(b);
+
+	return Transform{ from.translation + (to.translation - from.translation) * t, slerp_shortest(from.rotation, to.rotation, t), from.scale + (to.scale - from.scale) * t }.to_matrix();
+}
@@ -0,0 +1,342 @@
+#include "asset_pack.h"
+#include "mesh_optimizer.h"
+
+#include "../files/file_data.h"
+
+#include <spdlog/spdlog.h>
+
+#include <type_traits>
+#include <fstream>
+#include <cstring>
+
+using asset_pack::SectionType;
+
+static_assert(std::is_trivially_copyable_v<PackedVertex>, "Sections are copied byte by byte");
+static_assert(std::is_trivially_copyable_v<QuantizationBounds>, "Sections are copied byte by byte");
+static_assert(std::is_trivially_copyable_v<SkeletonNode>, "Sections are copied byte by byte");
+static_assert(std::is_trivially_copyable_v<BakedAnimation::Header>, "Sections are copied byte by byte");
+
+static uint64_t align(uint64_t value)
+{
+	return (value + asset_pack::ALIGNMENT - 1) / asset_pack::ALIGNMENT * asset_pack::ALIGNMENT;
+}
+
+void AssetPackWriter::add_mesh(const std::vector<PackedVertex>& vertices, const QuantizationBounds& bounds, const std::vector<uint32_t>& indices, uint32_t lod)
+{
+	add_section(SectionType::Vertices, lod, vertices.data(), vertices.size() * sizeof(PackedVertex));
+
+	// Coarser levels have fewer vertices, so the size level 0 needs fits them as well.
+	if (lod == 0 || index_size == 0)
+		index_size = mesh_optimizer::get_index_size(vertices.size());
+
+	const std::vector<uint8_t> packed_indices = mesh_optimizer::pack_indices(indices, index_size);
+	const bool short_indices = index_size == sizeof(uint16_t);
+
+	add_section(short_indices ? SectionType::ShortIndices : SectionType::Indices, lod, packed_indices.data(), packed_indices.size());
+
+	if (lod == 0)
+		add_section(SectionType::VertexBounds, 0, &bounds, sizeof(QuantizationBounds));
+}
+
+void AssetPackWriter::add_rig(const Rig& rig)
+{
+	add_section(SectionType::SkeletonNodes, 0, rig.skeleton.nodes.data(), rig.skeleton.nodes.size() * sizeof(SkeletonNode));
+	add_strings(SectionType::NodeNames, 0, rig.skeleton.names);
+	add_strings(SectionType::BoneNames, 0, rig.get_bone_names());
+	add_section(SectionType::BoneOffsets, 0, rig.offset_matrices.data(), rig.offset_matrices.size() * sizeof(glm::mat4));
+	add_section(SectionType::RigTransform, 0, &rig.global_inverse_transform, sizeof(glm::mat4));
+}
+
+uint32_t AssetPackWriter::add_clip(const BakedAnimation& animation)
+{
+	const uint32_t index = clip_count++;
+	const BakedAnimation::Header header = animation.get_header();
+
+	add_section(SectionType::ClipHeader, index, &header, sizeof(header));
+	add_strings(SectionType::ClipName, index, { animation.name });
+	add_strings(SectionType::ChannelNames, index, animation.channel_names);
+	add_section(SectionType::ClipSamples, index, animation.get_samples(), animation.get_sample_count() * sizeof(float));
+
+	return index;
+}
+
+void AssetPackWriter::add_section(SectionType type, uint32_t index, const void* data, size_t size)
+{
+	PendingSection& section = sections.emplace_back();
+	section.type = type;
+	section.index = index;
+	section.data.resize(size);
+
+	if (size > 0)
+		memcpy(section.data.data(), data, size);
+}
+
+// Strings are stored back to back, each followed by a terminating zero.
+void AssetPackWriter::add_strings(SectionType type, uint32_t index, const std::vector<std::string>& strings)
+{
+	std::vector<uint8_t> data;
+
+	for (const std::string& string : strings)
+	{
+		data.insert(data.end(), string.begin(), string.end());
+		data.push_back(0);
+	}
+
+	add_section(type, index, data.data(), data.size());
+}
+
+bool AssetPackWriter::save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		spdlog::error("Failed to open file: {0}", path);
+		return false;
+	}
+
+	asset_pack::FileHeader header;
+	header.magic = asset_pack::MAGIC;
+	header.version = asset_pack::VERSION;
+	header.section_count = static_cast<uint32_t>(sections.size());
+	header.reserved = 0;
+
+	std::vector<asset_pack::Section> table(sections.size());
+	uint64_t offset = align(sizeof(header) + sizeof(asset_pack::Section) * table.size());
+
+	for (int i = 0; i < sections.size(); i++)
+	{
+		table[i].type = sections[i].type;
+		table[i].index = sections[i].index;
+		table[i].offset = offset;
+		table[i].size = sections[i].data.size();
+
+		offset = align(offset + table[i].size);
+	}
+
+	static const char padding[asset_pack::ALIGNMENT] = {};
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(table.data()), sizeof(asset_pack::Section) * table.size());
+
+	uint64_t position = sizeof(header) + sizeof(asset_pack::Section) * table.size();
+
+	for (int i = 0; i < sections.size(); i++)
+	{
+		file.write(padding, table[i].offset - position);
+		file.write(reinterpret_cast<const char*>(sections[i].data.data()), table[i].size);
+
+		position = table[i].offset + table[i].size;
+	}
+
+	return file.good();
+}
+
+AssetPack::AssetPack(const std::string& path) : file{files::FileData::load(path)}
+{
+	if (!file)
+		return;
+
+	const uint8_t* data = file->get_data();
+	const size_t size = file->get_size();
+
+	asset_pack::FileHeader header;
+
+	if (size < sizeof(header))
+	{
+		spdlog::error("Asset pack is truncated: {0}", path);
+		return;
+	}
+
+	memcpy(&header, data, sizeof(header));
+
+	if (header.magic != asset_pack::MAGIC || header.version != asset_pack::VERSION)
+	{
+		spdlog::error("Asset pack {0} has version {1}, expected {2}; bake it again", path, header.version, asset_pack::VERSION);
+		return;
+	}
+
+	const asset_pack::Section* table = reinterpret_cast<const asset_pack::Section*>(data + sizeof(header));
+
+	if (sizeof(header) + sizeof(asset_pack::Section) * static_cast<uint64_t>(header.section_count) > size)
+	{
+		spdlog::error("Asset pack is truncated: {0}", path);
+		return;
+	}
+
+	for (uint32_t i = 0; i < header.section_count; i++)
+	{
+		if (table[i].offset % asset_pack::ALIGNMENT != 0 || table[i].offset > size || table[i].size > size - table[i].offset)
+		{
+			spdlog::error("Asset pack is corrupted: {0}", path);
+			return;
+		}
+	}
+
+	sections = table;
+	section_count = header.section_count;
+}
+
+AssetPack::~AssetPack() = default;
+
+bool AssetPack::is_loaded() const
+{
+	return sections != nullptr;
+}
+
+const asset_pack::Section* AssetPack::find_section(SectionType type, uint32_t index) const
+{
+	for (uint32_t i = 0; i < section_count; i++)
+		if (sections[i].type == type && sections[i].index == index)
+			return &sections[i];
+
+	return nullptr;
+}
+
+template <typename T>
+const T* AssetPack::get_section_data(SectionType type, uint32_t index, uint32_t& count) const
+{
+	const asset_pack::Section* section = find_section(type, index);
+
+	if (!section || section->size % sizeof(T) != 0)
+	{
+		count = 0;
+		return nullptr;
+	}
+
+	count = static_cast<uint32_t>(section->size / sizeof(T));
+	return reinterpret_cast<const T*>(file->get_data() + section->offset);
+}
+
+std::vector<std::string> AssetPack::get_strings(SectionType type, uint32_t index) const
+{
+	std::vector<std::string> strings;
+
+	uint32_t size;
+	const char* data = get_section_data<char>(type, index, size);
+
+	for (uint32_t begin = 0, end = 0; end < size; end++)
+	{
+		if (data[end] == 0)
+		{
+			strings.emplace_back(data + begin, end - begin);
+			begin = end + 1;
+		}
+	}
+
+	return strings;
+}
+
+uint32_t AssetPack::get_lod_count() const
+{
+	uint32_t count = 0;
+
+	while (find_section(SectionType::Vertices, count))
+		count++;
+
+	return count;
+}
+
+const PackedVertex* AssetPack::get_vertices(uint32_t lod) const
+{
+	uint32_t count;
+	return get_section_data<PackedVertex>(SectionType::Vertices, lod, count);
+}
+
+uint32_t AssetPack::get_vertex_count(uint32_t lod) const
+{
+	uint32_t count;
+	get_section_data<PackedVertex>(SectionType::Vertices, lod, count);
+	return count;
+}
+
+const void* AssetPack::get_indices(uint32_t lod) const
+{
+	uint32_t count;
+
+	if (find_section(SectionType::ShortIndices, lod))
+		return get_section_data<uint16_t>(SectionType::ShortIndices, lod, count);
+
+	return get_section_data<uint32_t>(SectionType::Indices, lod, count);
+}
+
+uint32_t AssetPack::get_index_count(uint32_t lod) const
+{
+	uint32_t count;
+
+	if (find_section(SectionType::ShortIndices, lod))
+		get_section_data<uint16_t>(SectionType::ShortIndices, lod, count);
+	else
+		get_section_data<uint32_t>(SectionType::Indices, lod, count);
+
+	return count;
+}
+
+uint32_t AssetPack::get_index_size(uint32_t lod) const
+{
+	return find_section(SectionType::ShortIndices, lod) ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+QuantizationBounds AssetPack::get_vertex_bounds() const
+{
+	QuantizationBounds bounds;
+
+	uint32_t count;
+	const QuantizationBounds* stored = get_section_data<QuantizationBounds>(SectionType::VertexBounds, 0, count);
+
+	if (count == 1)
+		memcpy(&bounds, stored, sizeof(bounds));
+
+	return bounds;
+}
+
+RigPtr_t AssetPack::create_rig() const
+{
+	uint32_t node_count, offset_count, transform_count;
+	const SkeletonNode* nodes = get_section_data<SkeletonNode>(SectionType::SkeletonNodes, 0, node_count);
+	const glm::mat4* offsets = get_section_data<glm::mat4>(SectionType::BoneOffsets, 0, offset_count);
+	const glm::mat4* global_inverse_transform = get_section_data<glm::mat4>(SectionType::RigTransform, 0, transform_count);
+
+	std::vector<std::string> node_names = get_strings(SectionType::NodeNames);
+	const std::vector<std::string> bone_names = get_strings(SectionType::BoneNames);
+
+	if (node_count == 0 || transform_count != 1 || node_names.size() != node_count || bone_names.size() != offset_count)
+	{
+		spdlog::error("Asset pack has no valid rig");
+		return nullptr;
+	}
+
+	Skeleton skeleton(std::vector<SkeletonNode>(nodes, nodes + node_count), std::move(node_names));
+
+	return std::make_shared<Rig>(std::move(skeleton), std::vector<glm::mat4>(offsets, offsets + offset_count), *global_inverse_transform, bone_names);
+}
+
+uint32_t AssetPack::get_clip_count() const
+{
+	uint32_t clip_count = 0;
+
+	while (find_section(SectionType::ClipHeader, clip_count))
+		clip_count++;
+
+	return clip_count;
+}
+
+BakedAnimationPtr_t AssetPack::create_clip(uint32_t index) const
+{
+	uint32_t header_count, sample_count;
+	const BakedAnimation::Header* header = get_section_data<BakedAnimation::Header>(SectionType::ClipHeader, index, header_count);
+	const float* samples = get_section_data<float>(SectionType::ClipSamples, index, sample_count);
+
+	const std::vector<std::string> name = get_strings(SectionType::ClipName, index);
+	std::vector<std::string> channel_names = get_strings(SectionType::ChannelNames, index);
+
+	if (header_count != 1 || name.size() != 1 || channel_names.size() != header->channel_count ||
+		static_cast<size_t>(sample_count) != static_cast<size_t>(BakedAnimation::Component::Count) * header->frame_count * header->channel_stride)
+	{
+		spdlog::error("Asset pack has no valid clip {0}", index);
+		return nullptr;
+	}
+
+	// The samples stay in the mapping, which the clip keeps alive.
+	return std::make_shared<BakedAnimation>(name[0], *header, std::move(channel_names), samples, file);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <string>
+
+#include "packed_vertex.h"
+
+#include "../animation/rig.h"
+#include "../animation/baked_animation.h"
+
+namespace files
+{
+	class FileData;
+}
+
+// Versioned binary container produced offline by bake_assets. Every section is a blob in the exact
+// layout the runtime uses (packed vertices, flattened skeleton, SoA clip samples), so loading is
+// a memory map plus a table lookup instead of an Assimp import.
+namespace asset_pack
+{
+	static constexpr uint32_t MAGIC = 0x414d4e41; // "ANMA"
+	// 2: every level of detail is stored with the index size of level 0.
+	static constexpr uint32_t VERSION = 2;
+
+	// Section payloads start on this boundary, enough for every element type (and SIMD loads of clip samples).
+	static constexpr uint32_t ALIGNMENT = 16;
+
+	enum class SectionType : uint32_t
+	{
+		Vertices,
+		Indices,
+		VertexBounds,
+		SkeletonNodes,
+		NodeNames,
+		BoneNames,
+		BoneOffsets,
+		RigTransform,
+		ClipHeader,
+		ClipName,
+		ChannelNames,
+		ClipSamples,
+		// Indices of meshes with at most 65536 vertices, instead of Indices.
+		ShortIndices
+	};
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t section_count;
+		uint32_t reserved;
+	};
+
+	// The section table follows the file header directly.
+	struct Section
+	{
+		SectionType type;
+
+		// Distinguishes sections of the same type, e.g. the clip they belong to.
+		uint32_t index;
+
+		uint64_t offset;
+		uint64_t size;
+	};
+}
+
+class AssetPackWriter
+{
+public:
+	AssetPackWriter() = default;
+
+	// Indices are stored with 16 bits where the vertex count allows, see mesh_optimizer::get_index_size().
+	// Levels of detail go in one after the other, each quantized with the bounds of level 0 and stored with the
+	// index size of level 0, so they can share one index buffer.
+	void add_mesh(const std::vector<PackedVertex>& vertices, const QuantizationBounds& bounds, const std::vector<uint32_t>& indices, uint32_t lod = 0);
+	void add_rig(const Rig& rig);
+
+	// Returns the index the clip can be loaded back with.
+	uint32_t add_clip(const BakedAnimation& animation);
+
+	bool save(const std::string& path) const;
+
+private:
+	struct PendingSection
+	{
+		asset_pack::SectionType type;
+		uint32_t index;
+		std::vector<uint8_t> data;
+	};
+
+	void add_section(asset_pack::SectionType type, uint32_t index, const void* data, size_t size);
+	void add_strings(asset_pack::SectionType type, uint32_t index, const std::vector<std::string>& strings);
+
+	std::vector<PendingSection> sections;
+	uint32_t clip_count{0};
+
+	// Of the level 0 mesh, for the levels after it.
+	uint32_t index_size{0};
+
+	AssetPackWriter(const AssetPackWriter&) = delete;
+	AssetPackWriter& operator=(const AssetPackWriter&) = delete;
+};
+
+// Asset pack read through FileData, so mapped unless it is tiny. Mesh data is handed out as pointers into it, ready to be uploaded as is;
+// clips reference their samples in place and keep the file data alive on their own.
+class AssetPack
+{
+public:
+	AssetPack(const std::string& path);
+	~AssetPack();
+
+	bool is_loaded() const;
+
+	// Levels of detail of the mesh, see mesh_lods.
+	uint32_t get_lod_count() const;
+
+	const PackedVertex* get_vertices(uint32_t lod = 0) const;
+	uint32_t get_vertex_count(uint32_t lod = 0) const;
+
+	// get_index_count() indices of get_index_size() bytes each.
+	const void* get_indices(uint32_t lod = 0) const;
+	uint32_t get_index_count(uint32_t lod = 0) const;
+	uint32_t get_index_size(uint32_t lod = 0) const;
+
+	QuantizationBounds get_vertex_bounds() const;
+
+	RigPtr_t create_rig() const;
+
+	uint32_t get_clip_count() const;
+	BakedAnimationPtr_t create_clip(uint32_t index) const;
+
+private:
+	const asset_pack::Section* find_section(asset_pack::SectionType type, uint32_t index = 0) const;
+
+	template <typename T>
+	const T* get_section_data(asset_pack::SectionType type, uint32_t index, uint32_t& count) const;
+
+	std::vector<std::string> get_strings(asset_pack::SectionType type, uint32_t index = 0) const;
+
+	std::shared_ptr<files::FileData> file;
+
+	const asset_pack::Section* sections{nullptr};
+	uint32_t section_count{0};
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+};
@@ -0,0 +1,278 @@
+#include "asset_streamer.h"
+
+#include "image.h"
+#include "texture_file.h"
+
+#include "xyapi/gl/vbo.h"
+
+#include <GL/glew.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+
+struct PixelFormat
+{
+	int32_t internal_format;
+	uint32_t format;
+};
+
+// Of 8-bit images by channel count.
+static const PixelFormat PIXEL_FORMATS[] = { { GL_R8, GL_RED }, { GL_RG8, GL_RG }, { GL_RGB8, GL_RGB }, { GL_RGBA8, GL_RGBA } };
+
+AssetStreamer::AssetStreamer(JobSystem& job_system, size_t slice_size) : job_system{job_system}, slice_size{slice_size}
+{
+	staging_buffer = std::make_shared<VBO>(-1, VBO::Type::PixelUnpack, VBO::Usage::Stream, slice_size, 1, nullptr);
+}
+
+AssetStreamer::~AssetStreamer()
+{
+	// Decode jobs write into handles and the upload queue, so they have to be finished first.
+	job_system.wait(jobs);
+}
+
+void AssetStreamer::enqueue_upload(Upload_t upload)
+{
+	std::lock_guard<std::mutex> lock(queued_mutex);
+	queued_uploads.push_back(std::move(upload));
+}
+
+void AssetStreamer::stage(const void* data, size_t size)
+{
+	staging_buffer->store(nullptr, std::max(size, slice_size));
+	staging_buffer->update(data, size);
+}
+
+AssetHandle<files::FileData> AssetStreamer::load_file(const std::string& path)
+{
+	return load<files::FileData>([path]() { return files::FileData::load(path); });
+}
+
+AssetHandle<Texture> AssetStreamer::load_texture(const std::string& path, int channels)
+{
+	auto state = std::make_shared<AssetHandle<Texture>::State>();
+
+	{
+		std::lock_guard<std::mutex> lock(queued_mutex);
+		pending_textures.push_back({ path, channels, state });
+	}
+
+	start_textures();
+
+	return AssetHandle<Texture>(state);
+}
+
+void AssetStreamer::start_textures()
+{
+	std::lock_guard<std::mutex> lock(queued_mutex);
+
+	while (!pending_textures.empty() && textures_in_flight < max_textures_in_flight)
+	{
+		PendingTexture texture = std::move(pending_textures.front());
+		pending_textures.pop_front();
+
+		textures_in_flight++;
+
+		job_system.submit_background([this, state = std::move(texture.state), path = std::move(texture.path), channels = texture.channels]()
+		{
+			PROFILE_ZONE("Load texture");
+
+			if (TextureFile::is_texture_file(path))
+				load_texture_file(path, state);
+			else
+				load_image(path, channels, state);
+		}, jobs);
+	}
+}
+
+void AssetStreamer::finish_texture(AssetHandle<Texture>::State& state, AssetState result)
+{
+	state.state.store(result, std::memory_order_release);
+
+	{
+		std::lock_guard<std::mutex> lock(queued_mutex);
+		textures_in_flight--;
+	}
+
+	start_textures();
+}
+
+void AssetStreamer::load_image(const std::string& path, int channels, std::shared_ptr<AssetHandle<Texture>::State> state)
+{
+	std::shared_ptr<Image> image = std::make_shared<Image>(path, channels);
+
+	if (!image->data)
+	{
+		spdlog::error("Failed to load image: {0}", path);
+		finish_texture(*state, AssetState::Failed);
+		return;
+	}
+
+	state->state.store(AssetState::Uploading, std::memory_order_release);
+
+	// The decoded pixels are freed with this upload, right after its last slice went into the staging buffer.
+	enqueue_upload([this, state, image, next_row = 0u]() mutable
+	{
+		const uint32_t width = static_cast<uint32_t>(image->width);
+		const uint32_t height = static_cast<uint32_t>(image->height);
+		const size_t row_size = static_cast<size_t>(width) * image->num_of_channels;
+
+		const PixelFormat& pixel_format = PIXEL_FORMATS[image->num_of_channels - 1];
+
+		if (!state->asset)
+		{
+			state->asset = std::make_shared<Texture>(Texture::Storage{ width, height, Texture::get_mip_count(width, height), pixel_format.internal_format, pixel_format.format, GL_UNSIGNED_BYTE });
+
+			// Gray, and gray with alpha, sample like the RGBA they were decoded from before.
+			if (image->num_of_channels <= 2)
+			{
+				const GLint swizzle[] = { GL_RED, GL_RED, GL_RED, image->num_of_channels == 2 ? GL_GREEN : GL_ONE };
+
+				state->asset->bind();
+					glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+				state->asset->unbind();
+			}
+		}
+
+		const uint32_t rows = std::clamp(static_cast<uint32_t>(slice_size / row_size), 1u, height - next_row);
+
+		// Rows of 1 and 3 channel images aren't 4 byte aligned.
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		staging_buffer->bind();
+			stage(image->data + next_row * row_size, rows * row_size);
+
+			state->asset->bind();
+				state->asset->update(0, 0, next_row, width, rows, nullptr);
+			state->asset->unbind();
+		staging_buffer->unbind();
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		next_row += rows;
+
+		if (next_row < height)
+			return false;
+
+		state->asset->bind();
+			state->asset->generate_mipmaps();
+		state->asset->unbind();
+
+		finish_texture(*state, AssetState::Ready);
+		return true;
+	});
+}
+
+void AssetStreamer::load_texture_file(const std::string& path, std::shared_ptr<AssetHandle<Texture>::State> state)
+{
+	std::shared_ptr<TextureFile> file = std::make_shared<TextureFile>(path);
+
+	if (!file->is_loaded())
+	{
+		spdlog::error("Failed to load texture: {0}", path);
+		finish_texture(*state, AssetState::Failed);
+		return;
+	}
+
+	state->state.store(AssetState::Uploading, std::memory_order_release);
+
+	enqueue_upload([this, state, file, path, next_level = 0u]() mutable
+	{
+		// Support depends on the context, so this can only be checked on the render thread.
+		if (!state->asset && !Texture::is_compressed_format_supported(file->internal_format))
+		{
+			spdlog::error("Compressed format 0x{0:x} of {1} is not supported by this GPU", file->internal_format, path);
+			finish_texture(*state, AssetState::Failed);
+			return true;
+		}
+
+		if (!state->asset)
+			state->asset = std::make_shared<Texture>(Texture::Storage{ file->width, file->height, static_cast<uint32_t>(file->levels.size()), file->internal_format, 0, 0 });
+
+		const TextureFile::Level& level = file->levels[next_level];
+
+		staging_buffer->bind();
+			stage(level.data, level.size);
+
+			state->asset->bind();
+				state->asset->update_compressed(next_level, 0, 0, level.width, level.height, level.size, nullptr);
+			state->asset->unbind();
+		staging_buffer->unbind();
+
+		if (++next_level < file->levels.size())
+			return false;
+
+		finish_texture(*state, AssetState::Ready);
+		return true;
+	});
+}
+
+AssetHandle<VBO> AssetStreamer::upload_buffer(std::shared_ptr<VBO> vbo, const void* data, size_t size, std::shared_ptr<const void> owner, size_t first_element)
+{
+	auto state = std::make_shared<AssetHandle<VBO>::State>();
+	state->state.store(AssetState::Uploading, std::memory_order_relaxed);
+
+	// VBO::update counts in elements, so slices are whole elements.
+	const size_t element_size = vbo->get_size();
+	const size_t element_count = size / element_size;
+	const size_t elements_per_slice = std::max<size_t>(slice_size / element_size, 1);
+
+	enqueue_upload([state, vbo, data, owner, first_element, element_count, elements_per_slice, next_element = size_t(0)]() mutable
+	{
+		const size_t amount = std::min(elements_per_slice, element_count - next_element);
+
+		vbo->bind();
+			vbo->update(static_cast<const uint8_t*>(data) + next_element * vbo->get_size(), amount, first_element + next_element);
+		vbo->unbind();
+
+		next_element += amount;
+
+		if (next_element < element_count)
+			return false;
+
+		state->asset = vbo;
+		state->state.store(AssetState::Ready, std::memory_order_release);
+		return true;
+	});
+
+	return AssetHandle<VBO>(state);
+}
+
+void AssetStreamer::update(float budget_ms)
+{
+	PROFILE_ZONE("Stream assets");
+
+	{
+		std::lock_guard<std::mutex> lock(queued_mutex);
+
+		while (!queued_uploads.empty())
+		{
+			uploads.push_back(std::move(queued_uploads.front()));
+			queued_uploads.pop_front();
+		}
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	while (!uploads.empty())
+	{
+		if (uploads.front()())
+			uploads.pop_front();
+
+		const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		if (elapsed.count() >= budget_ms)
+			break;
+	}
+}
+
+bool AssetStreamer::is_idle() const
+{
+	// Jobs queue their uploads before they count as finished, so checking them first can't miss any.
+	if (jobs.pending.load(std::memory_order_acquire) > 0 || !uploads.empty())
+		return false;
+
+	std::lock_guard<std::mutex> lock(queued_mutex);
+	return queued_uploads.empty() && pending_textures.empty();
+}
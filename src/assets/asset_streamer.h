@@ -0,0 +1,163 @@
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <deque>
+#include <mutex>
+
+#include "xyapi/gl/texture.h"
+
+#include "../core/jobs/job_system.h"
+#include "../core/profiler/profiler.h"
+
+#include "../files/file_data.h"
+
+class VBO;
+
+enum class AssetState : uint32_t
+{
+	Loading,
+	Uploading,
+	Ready,
+	Failed
+};
+
+// Shared view of an asset that is still being streamed in. Poll it every frame and
+// draw a placeholder until is_ready(); the asset itself is only valid from then on.
+template <typename T>
+class AssetHandle
+{
+public:
+	AssetHandle() = default;
+
+	AssetState get_state() const
+	{
+		return state ? state->state.load(std::memory_order_acquire) : AssetState::Failed;
+	}
+
+	bool is_ready() const
+	{
+		return get_state() == AssetState::Ready;
+	}
+
+	bool is_failed() const
+	{
+		return get_state() == AssetState::Failed;
+	}
+
+	const std::shared_ptr<T>& get() const
+	{
+		return state->asset;
+	}
+
+private:
+	friend class AssetStreamer;
+
+	struct State
+	{
+		std::atomic<AssetState> state{AssetState::Loading};
+		std::shared_ptr<T> asset;
+	};
+
+	explicit AssetHandle(std::shared_ptr<State> state) : state{std::move(state)}
+	{
+	}
+
+	std::shared_ptr<State> state;
+};
+
+// Loads assets in the background: files are read and decoded as background jobs, GPU uploads are queued
+// for the render thread and fed through a staging buffer in slices, within a time budget per frame.
+class AssetStreamer
+{
+public:
+	// Upper bound of one upload slice, i.e. of the data handed to GL in a single call.
+	static constexpr size_t DEFAULT_SLICE_SIZE = 1 << 20;
+
+	AssetStreamer(JobSystem& job_system, size_t slice_size = DEFAULT_SLICE_SIZE);
+	~AssetStreamer();
+
+	// Runs decode on a worker; the handle is ready as soon as it returns (or failed if it returned nullptr).
+	template <typename T>
+	AssetHandle<T> load(std::function<std::shared_ptr<T>()> decode)
+	{
+		auto state = std::make_shared<typename AssetHandle<T>::State>();
+
+		job_system.submit_background([state, decode = std::move(decode)]()
+		{
+			PROFILE_ZONE("Decode asset");
+
+			state->asset = decode();
+			state->state.store(state->asset ? AssetState::Ready : AssetState::Failed, std::memory_order_release);
+		}, jobs);
+
+		return AssetHandle<T>(state);
+	}
+
+	// Reads the whole file on a worker, see files::FileData; ready once it's in memory (or mapped).
+	AssetHandle<files::FileData> load_file(const std::string& path);
+
+	// Reads the file on a worker, then creates immutable mipmapped storage and streams the pixels in through a pixel unpack buffer.
+	// KTX2/DDS files go up one compressed level at a time as stored; other images row by row, with mips generated on the GPU.
+	// Images keep their channel count, grayscale ones are swizzled to read as gray, unless channels asks for a fixed
+	// count, e.g. 4 for textures that have to share a format with others like the layers of a SkinSet array; compressed
+	// files are never converted. At most max_textures_in_flight are read or waiting for upload at a time, the rest wait
+	// for a turn, so loading many doesn't hold all their pixels at once.
+	AssetHandle<Texture> load_texture(const std::string& path, int channels = 0);
+
+	// Fills size bytes of vbo, starting at first_element, from the render thread. owner keeps data alive until the upload is done.
+	AssetHandle<VBO> upload_buffer(std::shared_ptr<VBO> vbo, const void* data, size_t size, std::shared_ptr<const void> owner = nullptr, size_t first_element = 0);
+
+	// Render thread, once per frame and with no vertex array bound: runs queued uploads for up to budget_ms
+	// (always at least one slice, so streaming keeps moving on slow frames).
+	void update(float budget_ms);
+
+	bool is_idle() const;
+
+	// Textures decoded in parallel and held in memory until the render thread has uploaded them.
+	uint32_t max_textures_in_flight{8};
+
+private:
+	struct PendingTexture
+	{
+		std::string path;
+		int channels;
+		std::shared_ptr<AssetHandle<Texture>::State> state;
+	};
+
+	// Called on the render thread until it returns true; each call uploads at most one slice.
+	using Upload_t = std::function<bool()>;
+
+	void enqueue_upload(Upload_t upload);
+
+	void load_image(const std::string& path, int channels, std::shared_ptr<AssetHandle<Texture>::State> state);
+	void load_texture_file(const std::string& path, std::shared_ptr<AssetHandle<Texture>::State> state);
+
+	// Starts pending textures while fewer than max_textures_in_flight are going.
+	void start_textures();
+	// A texture is uploaded or failed; its memory is gone once the upload is dropped.
+	void finish_texture(AssetHandle<Texture>::State& state, AssetState result);
+
+	// Copies size bytes into the staging buffer, growing it for this one upload if they don't fit in a slice.
+	void stage(const void* data, size_t size);
+
+	JobSystem& job_system;
+	JobCounter jobs;
+
+	size_t slice_size;
+	std::shared_ptr<VBO> staging_buffer;
+
+	// Filled by workers, drained by the render thread.
+	mutable std::mutex queued_mutex;
+	std::deque<Upload_t> queued_uploads;
+	std::deque<PendingTexture> pending_textures;
+	uint32_t textures_in_flight{0};
+
+	std::deque<Upload_t> uploads;
+
+	AssetStreamer(const AssetStreamer&) = delete;
+	AssetStreamer& operator=(const AssetStreamer&) = delete;
+};
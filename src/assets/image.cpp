@@ -1,13 +1,37 @@
 #include "image.h"
 
+#include "../files/file_data.h"
+
 #include "stb_image.h"
 
-Image::Image(const std::string& path)
+Image::Image(const std::string& path, int channels) : width{0}, height{0}, num_of_channels{0}, data{nullptr}
+{
+	// The encoded file is only kept until it's decoded.
+	const std::shared_ptr<files::FileData> file = files::FileData::load(path);
+
+	if (!file)
+		return;
+
+	data = stbi_load_from_memory(file->get_data(), static_cast<int>(file->get_size()), &width, &height, &num_of_channels, channels);
+
+	if (channels != 0)
+		num_of_channels = channels;
+}
+
+Image::Image(const uint8_t* encoded, size_t size, int channels) : width{0}, height{0}, num_of_channels{0}, data{nullptr}
 {
-	data = stbi_load(path.c_str(), &width, &height, &num_of_channels, STBI_rgb_alpha);
+	data = stbi_load_from_memory(encoded, static_cast<int>(size), &width, &height, &num_of_channels, channels);
+
+	if (channels != 0)
+		num_of_channels = channels;
 }
 
 Image::~Image()
 {
 	stbi_image_free(data);
-}
\ No newline at end of file
+}
+
+size_t Image::get_size() const
+{
+	return data ? static_cast<size_t>(width) * height * num_of_channels : 0;
+}
@@ -1,18 +1,26 @@
 #pragma once
 
+#include <stdint.h>
+#include <cstddef>
 #include <string>
 
 class Image
 {
 public:
-	Image(const std::string& path);
+	// Decoded to 8 bits per channel; channels 0 keeps as many as the file has (1 to 4), anything else converts
+	// to that many. data is null if the file can't be read or decoded.
+	Image(const std::string& path, int channels = 0);
+	Image(const uint8_t* encoded, size_t size, int channels = 0);
 	~Image();
 
+	size_t get_size() const;
+
 	int width, height;
+	// Of data, not necessarily of the file.
 	int num_of_channels;
 	unsigned char* data;
 
 private:
 	Image(const Image&) = delete;
 	Image& operator=(const Image&) = delete;
-};
\ No newline at end of file
+};
@@ -0,0 +1,358 @@
+#include "mesh_lods.h"
+#include "mesh_optimizer.h"
+
+#include "model.h"
+
+#include "../render/aabb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace mesh_lods
+{
+	// Extra cost of a collapse between vertices with entirely different influences, as a squared distance relative
+	// to the size of the mesh; partly different influences cost a share of it.
+	static constexpr float SKIN_ERROR_SCALE = 0.05f;
+
+	// Symmetric 4x4 matrix summing squared distances to a set of planes.
+	struct Quadric
+	{
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+
+		static Quadric from_plane(const glm::vec3& normal, double distance, double weight)
+		{
+			const double a = normal.x, b = normal.y, c = normal.z, d = distance;
+
+			return { a * a * weight, a * b * weight, a * c * weight, a * d * weight, b * b * weight, b * c * weight, b * d * weight, c * c * weight, c * d * weight, d * d * weight };
+		}
+
+		void add(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+		}
+
+		double get_error(const glm::vec3& point) const
+		{
+			const double x = point.x, y = point.y, z = point.z;
+
+			return x * x * a2 + y * y * b2 + z * z * c2 + 2.0 * (x * y * ab + x * z * ac + y * z * bc + x * ad + y * bd + z * cd) + d2;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		float cost;
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3& position) const
+		{
+			// -0 and 0 compare equal, so they have to hash the same.
+			const glm::vec3 normalized = position + glm::vec3(0.0f);
+
+			uint32_t bits[3];
+			memcpy(bits, &normalized, sizeof(bits));
+
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	// Weight a vertex gives to joint, 0 if it isn't influenced by it.
+	static float get_weight(const Vertex& vertex, int32_t joint)
+	{
+		float weight = 0.0f;
+
+		for (uint32_t i = 0; i < 4; i++)
+			if (vertex.joint_ids[i] == joint)
+				weight += vertex.weights[i];
+
+		return weight;
+	}
+
+	// Half the L1 distance between the influences of two vertices, 0 when they're the same, 1 when disjoint.
+	static float get_skin_difference(const Vertex& a, const Vertex& b)
+	{
+		float difference = 0.0f;
+
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			if (a.weights[i] > 0.0f)
+				difference += std::abs(a.weights[i] - get_weight(b, a.joint_ids[i]));
+
+			if (b.weights[i] > 0.0f && get_weight(a, b.joint_ids[i]) == 0.0f)
+				difference += b.weights[i];
+		}
+
+		return difference * 0.5f;
+	}
+
+	const std::vector<Settings>& get_default_settings()
+	{
+		static const std::vector<Settings> settings = { { 1.0f, 4 }, { 0.5f, 2 }, { 0.25f, 2 }, { 0.1f, 1 } };
+		return settings;
+	}
+
+	void simplify(Mesh& mesh, uint32_t target_triangles)
+	{
+		const uint32_t vertex_count = mesh.vertices.size();
+
+		// Split vertices, e.g. along UV seams, share a position id.
+		std::unordered_map<glm::vec3, uint32_t, PositionHash> position_ids;
+		std::vector<uint32_t> position_of(vertex_count);
+		std::vector<uint32_t> position_uses;
+
+		for (uint32_t i = 0; i < vertex_count; i++)
+		{
+			const auto [position_it, inserted] = position_ids.insert({ mesh.vertices[i].position, static_cast<uint32_t>(position_uses.size()) });
+
+			if (inserted)
+				position_uses.push_back(0);
+
+			position_of[i] = position_it->second;
+			position_uses[position_it->second]++;
+		}
+
+		std::vector<uint8_t> locked(vertex_count, 0);
+
+		for (uint32_t i = 0; i < vertex_count; i++)
+			locked[i] = position_uses[position_of[i]] > 1;
+
+		// Edges of only one triangle, by position so seams don't count, lie on a border.
+		std::unordered_map<uint64_t, uint32_t> edge_uses;
+
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				const uint32_t a = position_of[mesh.indices[i + j]];
+				const uint32_t b = position_of[mesh.indices[i + (j + 1) % 3]];
+
+				edge_uses[static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b)]++;
+			}
+		}
+
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				const uint32_t a = mesh.indices[i + j];
+				const uint32_t b = mesh.indices[i + (j + 1) % 3];
+
+				if (edge_uses[static_cast<uint64_t>(std::min(position_of[a], position_of[b])) << 32 | std::max(position_of[a], position_of[b])] == 1)
+					locked[a] = locked[b] = 1;
+			}
+		}
+
+		// Planes of the triangles around each vertex, weighted by area; merged along with the vertices.
+		std::vector<Quadric> quadrics(vertex_count, Quadric{});
+
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			const glm::vec3& a = mesh.vertices[mesh.indices[i]].position;
+			const glm::vec3& b = mesh.vertices[mesh.indices[i + 1]].position;
+			const glm::vec3& c = mesh.vertices[mesh.indices[i + 2]].position;
+
+			const glm::vec3 cross = glm::cross(b - a, c - a);
+			const float length = glm::length(cross);
+
+			if (length == 0.0f)
+				continue;
+
+			const glm::vec3 normal = cross / length;
+			const Quadric quadric = Quadric::from_plane(normal, -glm::dot(normal, a), length * 0.5);
+
+			for (uint32_t j = 0; j < 3; j++)
+				quadrics[mesh.indices[i + j]].add(quadric);
+		}
+
+		Aabb bounds;
+
+		for (const Vertex& vertex : mesh.vertices)
+			bounds.extend(vertex.position);
+
+		const float skin_error_size = glm::length(bounds.max - bounds.min) * SKIN_ERROR_SCALE;
+		const float skin_error = skin_error_size * skin_error_size;
+
+		std::vector<uint32_t> remap(vertex_count);
+		std::vector<uint8_t> touched(vertex_count);
+		std::vector<Collapse> collapses;
+
+		std::vector<uint32_t> triangle_offsets(vertex_count + 1);
+		std::vector<uint32_t> vertex_triangles;
+
+		// Every pass collapses the cheapest edges whose surroundings no other collapse of the pass changed, in the
+		// spirit of a priority queue without having to update one.
+		while (mesh.indices.size() / 3 > target_triangles)
+		{
+			const uint32_t triangle_count = mesh.indices.size() / 3;
+
+			std::fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+
+			for (uint32_t index : mesh.indices)
+				triangle_offsets[index + 1]++;
+
+			for (uint32_t i = 0; i < vertex_count; i++)
+				triangle_offsets[i + 1] += triangle_offsets[i];
+
+			vertex_triangles.resize(mesh.indices.size());
+			std::vector<uint32_t> fill(triangle_offsets.begin(), triangle_offsets.end() - 1);
+
+			for (uint32_t i = 0; i < mesh.indices.size(); i++)
+				vertex_triangles[fill[mesh.indices[i]]++] = i / 3;
+
+			collapses.clear();
+
+			for (size_t i = 0; i < mesh.indices.size(); i += 3)
+			{
+				for (uint32_t j = 0; j < 3; j++)
+				{
+					const uint32_t a = mesh.indices[i + j];
+					const uint32_t b = mesh.indices[i + (j + 1) % 3];
+
+					const float skin_cost = get_skin_difference(mesh.vertices[a], mesh.vertices[b]) * skin_error;
+
+					if (!locked[a])
+						collapses.push_back({ a, b, static_cast<float>(quadrics[a].get_error(mesh.vertices[b].position)) + skin_cost });
+
+					if (!locked[b])
+						collapses.push_back({ b, a, static_cast<float>(quadrics[b].get_error(mesh.vertices[a].position)) + skin_cost });
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			for (uint32_t i = 0; i < vertex_count; i++)
+				remap[i] = i;
+
+			std::fill(touched.begin(), touched.end(), 0);
+
+			// A collapse takes about two triangles along; the pass stops once the target would be met.
+			const uint32_t wanted = std::max<uint32_t>((triangle_count - target_triangles) / 2, 1);
+			uint32_t collapsed = 0;
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapsed >= wanted)
+					break;
+
+				if (touched[collapse.from] || touched[collapse.to])
+					continue;
+
+				const glm::vec3& to = mesh.vertices[collapse.to].position;
+				bool flips = false;
+
+				for (uint32_t k = triangle_offsets[collapse.from]; k < triangle_offsets[collapse.from + 1] && !flips; k++)
+				{
+					const uint32_t* triangle = &mesh.indices[vertex_triangles[k] * 3];
+
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+						continue;
+
+					// The triangle as seen from the vertex that moves.
+					const uint32_t corner = triangle[0] == collapse.from ? 0 : triangle[1] == collapse.from ? 1 : 2;
+					const glm::vec3& from = mesh.vertices[collapse.from].position;
+					const glm::vec3& b = mesh.vertices[triangle[(corner + 1) % 3]].position;
+					const glm::vec3& c = mesh.vertices[triangle[(corner + 2) % 3]].position;
+
+					flips = glm::dot(glm::cross(b - from, c - from), glm::cross(b - to, c - to)) <= 0.0f;
+				}
+
+				if (flips)
+					continue;
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to].add(quadrics[collapse.from]);
+
+				// Everything around the collapse changed, none of it is considered again this pass.
+				for (uint32_t k = triangle_offsets[collapse.from]; k < triangle_offsets[collapse.from + 1]; k++)
+				{
+					const uint32_t* triangle = &mesh.indices[vertex_triangles[k] * 3];
+					touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+				}
+
+				collapsed++;
+			}
+
+			if (collapsed == 0)
+				break;
+
+			std::vector<uint32_t> indices;
+			indices.reserve(mesh.indices.size());
+
+			for (size_t i = 0; i < mesh.indices.size(); i += 3)
+			{
+				const uint32_t a = remap[mesh.indices[i]];
+				const uint32_t b = remap[mesh.indices[i + 1]];
+				const uint32_t c = remap[mesh.indices[i + 2]];
+
+				if (a != b && b != c && a != c)
+					indices.insert(indices.end(), { a, b, c });
+			}
+
+			mesh.indices = std::move(indices);
+		}
+
+		// Drops the vertices collapsed away.
+		mesh_optimizer::optimize_vertex_fetch(mesh);
+	}
+
+	void limit_influences(Mesh& mesh, uint32_t max_influences)
+	{
+		// Weights are sorted from the largest down, see Model.
+		for (Vertex& vertex : mesh.vertices)
+		{
+			for (uint32_t i = max_influences; i < 4; i++)
+			{
+				vertex.weights[i] = 0.0f;
+				vertex.joint_ids[i] = 0;
+			}
+
+			const float weight_sum = vertex.weights[0] + vertex.weights[1] + vertex.weights[2] + vertex.weights[3];
+
+			if (weight_sum > 0.0f)
+				vertex.weights /= weight_sum;
+		}
+	}
+
+	std::vector<Mesh> generate(const Mesh& mesh, const std::vector<Settings>& settings)
+	{
+		std::vector<Mesh> lods;
+		lods.reserve(settings.size());
+
+		const uint32_t triangle_count = mesh.indices.size() / 3;
+		uint32_t previous_influences = 4;
+
+		for (const Settings& lod : settings)
+		{
+			Mesh simplified = lods.empty() ? mesh : lods.back();
+
+			simplify(simplified, static_cast<uint32_t>(triangle_count * lod.triangle_ratio));
+			limit_influences(simplified, lod.max_influences);
+
+			// Fewer influences can make split vertices identical, so the mesh is deduplicated again.
+			mesh_optimizer::optimize(simplified);
+
+			// Still worth a level while it saves influences.
+			if (!lods.empty() && simplified.indices.size() >= lods.back().indices.size() && lod.max_influences >= previous_influences)
+				break;
+
+			previous_influences = lod.max_influences;
+
+			simplified.name = mesh.name + " LOD" + std::to_string(lods.size());
+			lods.push_back(std::move(simplified));
+		}
+
+		return lods;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+struct Mesh;
+
+// Levels of detail of a skinned mesh, generated at import or bake time. Lower levels are simplified with
+// quadric error edge collapses and blend fewer bones per vertex, so distant avatars cost less to shade and skin.
+namespace mesh_lods
+{
+	struct Settings
+	{
+		// Of the triangles of level 0.
+		float triangle_ratio;
+		uint32_t max_influences;
+	};
+
+	// Full detail, then halving down to a tenth while going from four influences to one.
+	const std::vector<Settings>& get_default_settings();
+
+	// Collapses edges onto one of their vertices until at most target_triangles are left or nothing can go without
+	// tearing the mesh: vertices on borders and on attribute seams (positions shared by split vertices) stay put.
+	// A vertex always keeps its own attributes and bone influences; collapses between differently weighted vertices
+	// cost extra, so the simplified mesh still bends where the original did.
+	void simplify(Mesh& mesh, uint32_t target_triangles);
+
+	// Keeps the max_influences largest weights of every vertex and renormalises them.
+	void limit_influences(Mesh& mesh, uint32_t max_influences);
+
+	// One mesh per level, each simplified from the one before and run through mesh_optimizer. Once a level saves
+	// neither triangles nor influences over the one before, it and the rest are left out.
+	std::vector<Mesh> generate(const Mesh& mesh, const std::vector<Settings>& settings = get_default_settings());
+}
@@ -0,0 +1,346 @@
+#include "mesh_optimizer.h"
+
+#include "model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace mesh_optimizer
+{
+	// Forsyth scores against a larger cache than the one simulated, so vertices stay attractive a little longer
+	// than they're likely to be cached.
+	static constexpr uint32_t SCORED_CACHE_SIZE = 32;
+
+	struct VertexHash
+	{
+		size_t operator()(const Vertex& vertex) const
+		{
+			// FNV-1a.
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&vertex);
+			uint64_t hash = 14695981039346656037ull;
+
+			for (size_t i = 0; i < sizeof(Vertex); i++)
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	struct VertexEqual
+	{
+		bool operator()(const Vertex& a, const Vertex& b) const
+		{
+			return memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+
+	static_assert(sizeof(Vertex) == 64, "Vertices are compared byte by byte, padding would have to be cleared");
+
+	static float get_vertex_score(int32_t cache_position, uint32_t remaining_triangles)
+	{
+		if (remaining_triangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+
+		// The last triangle's vertices score the same, whichever order they were emitted in.
+		if (cache_position >= 0)
+			score = cache_position < 3 ? 0.75f : std::pow(1.0f - (cache_position - 3) / static_cast<float>(SCORED_CACHE_SIZE - 3), 1.5f);
+
+		// Vertices with few triangles left are finished first, so they don't linger as lone strays.
+		return score + 2.0f / std::sqrt(static_cast<float>(remaining_triangles));
+	}
+
+	void deduplicate_vertices(Mesh& mesh)
+	{
+		std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> unique_vertices;
+		unique_vertices.reserve(mesh.vertices.size());
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(mesh.vertices.size());
+
+		std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+
+		for (uint32_t& index : mesh.indices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				const auto [vertex_it, inserted] = unique_vertices.insert({ mesh.vertices[index], static_cast<uint32_t>(vertices.size()) });
+
+				if (inserted)
+					vertices.push_back(mesh.vertices[index]);
+
+				remap[index] = vertex_it->second;
+			}
+
+			index = remap[index];
+		}
+
+		mesh.vertices = std::move(vertices);
+	}
+
+	void optimize_vertex_cache(std::vector<uint32_t>& indices, uint32_t vertex_count)
+	{
+		const uint32_t triangle_count = indices.size() / 3;
+
+		if (triangle_count == 0)
+			return;
+
+		// Triangles of each vertex; the ones still to be emitted are kept at the front of its range.
+		std::vector<uint32_t> remaining(vertex_count, 0);
+
+		for (uint32_t index : indices)
+			remaining[index]++;
+
+		std::vector<uint32_t> offsets(vertex_count + 1, 0);
+
+		for (uint32_t i = 0; i < vertex_count; i++)
+			offsets[i + 1] = offsets[i] + remaining[i];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+		for (uint32_t i = 0; i < indices.size(); i++)
+			adjacency[fill[indices[i]]++] = i / 3;
+
+		std::vector<int32_t> cache_positions(vertex_count, -1);
+		std::vector<float> vertex_scores(vertex_count);
+
+		for (uint32_t i = 0; i < vertex_count; i++)
+			vertex_scores[i] = get_vertex_score(-1, remaining[i]);
+
+		std::vector<float> triangle_scores(triangle_count);
+		std::vector<uint8_t> emitted(triangle_count, 0);
+
+		for (uint32_t i = 0; i < triangle_count; i++)
+			triangle_scores[i] = vertex_scores[indices[i * 3]] + vertex_scores[indices[i * 3 + 1]] + vertex_scores[indices[i * 3 + 2]];
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		std::vector<uint32_t> cache, next_cache;
+		cache.reserve(SCORED_CACHE_SIZE + 3);
+		next_cache.reserve(SCORED_CACHE_SIZE + 3);
+
+		int64_t best = std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin();
+		uint32_t next_unemitted = 0;
+
+		while (output.size() < indices.size())
+		{
+			// Nothing left around the cache, e.g. a mesh island is done: carry on in input order.
+			if (best < 0)
+			{
+				while (emitted[next_unemitted])
+					next_unemitted++;
+
+				best = next_unemitted;
+			}
+
+			const uint32_t* triangle = &indices[best * 3];
+
+			emitted[best] = 1;
+			output.insert(output.end(), triangle, triangle + 3);
+
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				const uint32_t vertex = triangle[i];
+				uint32_t* begin = &adjacency[offsets[vertex]];
+				uint32_t* end = begin + remaining[vertex];
+
+				std::iter_swap(std::find(begin, end, static_cast<uint32_t>(best)), end - 1);
+				remaining[vertex]--;
+			}
+
+			// The triangle's vertices move to the front, everything else shifts back and past the end falls out.
+			next_cache.assign(triangle, triangle + 3);
+
+			for (uint32_t vertex : cache)
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					next_cache.push_back(vertex);
+
+			for (uint32_t i = 0; i < next_cache.size(); i++)
+			{
+				const uint32_t vertex = next_cache[i];
+
+				cache_positions[vertex] = i < SCORED_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+				vertex_scores[vertex] = get_vertex_score(cache_positions[vertex], remaining[vertex]);
+			}
+
+			// Only triangles around the touched vertices changed their score, the best of them goes next.
+			best = -1;
+			float best_score = -1.0f;
+
+			for (uint32_t vertex : next_cache)
+			{
+				for (uint32_t i = offsets[vertex], end = offsets[vertex] + remaining[vertex]; i < end; i++)
+				{
+					const uint32_t t = adjacency[i];
+					const float score = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+
+					triangle_scores[t] = score;
+
+					if (score > best_score)
+					{
+						best_score = score;
+						best = t;
+					}
+				}
+			}
+
+			if (next_cache.size() > SCORED_CACHE_SIZE)
+				next_cache.resize(SCORED_CACHE_SIZE);
+
+			cache.swap(next_cache);
+		}
+
+		indices = std::move(output);
+	}
+
+	void optimize_overdraw(Mesh& mesh)
+	{
+		const uint32_t triangle_count = mesh.indices.size() / 3;
+
+		if (triangle_count == 0)
+			return;
+
+		// A triangle missing all three of its vertices means the cache has nothing to lose there.
+		std::vector<uint32_t> cluster_starts;
+		std::vector<uint32_t> cache_stamps(mesh.vertices.size(), 0);
+		uint32_t misses = 0;
+
+		for (uint32_t i = 0; i < triangle_count; i++)
+		{
+			uint32_t triangle_misses = 0;
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				const uint32_t vertex = mesh.indices[i * 3 + j];
+
+				// Cached when it missed within the last CACHE_SIZE misses.
+				if (cache_stamps[vertex] == 0 || misses - cache_stamps[vertex] >= CACHE_SIZE)
+				{
+					cache_stamps[vertex] = ++misses;
+					triangle_misses++;
+				}
+			}
+
+			if (triangle_misses == 3)
+				cluster_starts.push_back(i);
+		}
+
+		cluster_starts.push_back(triangle_count);
+
+		glm::vec3 mesh_centroid(0.0f);
+
+		for (const Vertex& vertex : mesh.vertices)
+			mesh_centroid += vertex.position;
+
+		mesh_centroid /= static_cast<float>(std::max<size_t>(mesh.vertices.size(), 1));
+
+		// Clusters whose area weighted normal points away from the middle of the mesh are likely in front of it.
+		const uint32_t cluster_count = cluster_starts.size() - 1;
+		std::vector<float> sort_keys(cluster_count);
+
+		for (uint32_t cluster = 0; cluster < cluster_count; cluster++)
+		{
+			glm::vec3 centroid(0.0f);
+			glm::vec3 normal(0.0f);
+
+			for (uint32_t i = cluster_starts[cluster]; i < cluster_starts[cluster + 1]; i++)
+			{
+				const glm::vec3& a = mesh.vertices[mesh.indices[i * 3]].position;
+				const glm::vec3& b = mesh.vertices[mesh.indices[i * 3 + 1]].position;
+				const glm::vec3& c = mesh.vertices[mesh.indices[i * 3 + 2]].position;
+
+				centroid += a + b + c;
+				normal += glm::cross(b - a, c - a);
+			}
+
+			centroid /= static_cast<float>((cluster_starts[cluster + 1] - cluster_starts[cluster]) * 3);
+
+			sort_keys[cluster] = glm::dot(centroid - mesh_centroid, normal);
+		}
+
+		std::vector<uint32_t> order(cluster_count);
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sort_keys[a] > sort_keys[b]; });
+
+		std::vector<uint32_t> indices;
+		indices.reserve(mesh.indices.size());
+
+		for (uint32_t cluster : order)
+			indices.insert(indices.end(), mesh.indices.begin() + cluster_starts[cluster] * 3, mesh.indices.begin() + cluster_starts[cluster + 1] * 3);
+
+		mesh.indices = std::move(indices);
+	}
+
+	void optimize_vertex_fetch(Mesh& mesh)
+	{
+		std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(mesh.vertices.size());
+
+		for (uint32_t& index : mesh.indices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(mesh.vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		mesh.vertices = std::move(vertices);
+	}
+
+	void optimize(Mesh& mesh)
+	{
+		deduplicate_vertices(mesh);
+		optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+		optimize_overdraw(mesh);
+		optimize_vertex_fetch(mesh);
+	}
+
+	float get_acmr(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size)
+	{
+		if (indices.empty())
+			return 0.0f;
+
+		std::vector<uint32_t> cache_stamps(vertex_count, 0);
+		uint32_t misses = 0;
+
+		for (uint32_t index : indices)
+			if (cache_stamps[index] == 0 || misses - cache_stamps[index] >= cache_size)
+				cache_stamps[index] = ++misses;
+
+		return misses / static_cast<float>(indices.size() / 3);
+	}
+
+	uint32_t get_index_size(uint32_t vertex_count)
+	{
+		return vertex_count <= UINT16_MAX + 1 ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	std::vector<uint8_t> pack_indices(const std::vector<uint32_t>& indices, uint32_t index_size)
+	{
+		std::vector<uint8_t> packed(indices.size() * index_size);
+
+		if (index_size == sizeof(uint32_t))
+		{
+			memcpy(packed.data(), indices.data(), packed.size());
+			return packed;
+		}
+
+		uint16_t* short_indices = reinterpret_cast<uint16_t*>(packed.data());
+
+		for (size_t i = 0; i < indices.size(); i++)
+			short_indices[i] = static_cast<uint16_t>(indices[i]);
+
+		return packed;
+	}
+}
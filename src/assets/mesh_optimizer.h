@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+struct Mesh;
+
+// Reorders a triangle mesh for the GPU at import time; what it draws stays the same up to triangle order.
+// Skinning runs once per vertex shader invocation, so each vertex taken from the post-transform cache instead of
+// being shaded again saves the whole palette blend.
+namespace mesh_optimizer
+{
+	// Vertices per simulated post-transform cache, a common size for current hardware.
+	static constexpr uint32_t CACHE_SIZE = 16;
+
+	// Merges vertices that are identical bit for bit, bone influences included, and drops unreferenced ones.
+	void deduplicate_vertices(Mesh& mesh);
+
+	// Orders triangles so that vertices are reused while they're still in the cache (Forsyth's linear-speed
+	// greedy algorithm, scoring vertices by cache position and remaining triangles).
+	void optimize_vertex_cache(std::vector<uint32_t>& indices, uint32_t vertex_count);
+
+	// Sorts the clusters of a cache-optimized order so outward-facing ones come first and occlude the rest
+	// early. Clusters are cut where the cache starts over anyway, so the cache hit rate stays as it was.
+	void optimize_overdraw(Mesh& mesh);
+
+	// Renumbers vertices in the order the indices first use them, so vertex fetch walks memory forward.
+	void optimize_vertex_fetch(Mesh& mesh);
+
+	// All of the above in order.
+	void optimize(Mesh& mesh);
+
+	// Average cache misses per triangle with a FIFO cache of cache_size vertices, from 0.5 (ideal) to 3.
+	float get_acmr(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size = CACHE_SIZE);
+
+	// 2 bytes when every index of a mesh of vertex_count vertices fits 16 bits, 4 otherwise.
+	uint32_t get_index_size(uint32_t vertex_count);
+
+	// indices stored index_size bytes apiece, 2 or 4. Levels of detail pass the size of level 0, so all of them fit one index buffer.
+	std::vector<uint8_t> pack_indices(const std::vector<uint32_t>& indices, uint32_t index_size);
+}
@@ -1,4 +1,9 @@
 #include "model.h"
+#include "mesh_optimizer.h"
+
+#include "../core/jobs/job_system.h"
+#include "../files/file_data.h"
+#include "../files/files.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -23,88 +28,170 @@ static void create_skeleton(aiNode* ai_node, Bone& self)
 	self.name = std::string(ai_node->mName.data);
 	self.transformation = convert_matrix(ai_node->mTransformation);
 
+	self.children.reserve(ai_node->mNumChildren);
+
 	for (int i = 0; i < ai_node->mNumChildren; i++)
 		create_skeleton(ai_node->mChildren[i], self.children.emplace_back());
 };
 
-Model::Model(const std::string& path)
+// Keeps the four largest influences of a vertex, sorted from the largest down.
+static void add_influence(Vertex& vertex, int32_t joint, float weight)
 {
-	importer = new Assimp::Importer();
+	if (weight <= vertex.weights[3])
+		return;
 
-	const aiScene* scene = importer->ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+	int k = 3;
 
-	if (!scene)
-		spdlog::error("Failed to load model: {0}", path);
+	for (; k > 0 && vertex.weights[k - 1] < weight; k--)
+	{
+		vertex.weights[k] = vertex.weights[k - 1];
+		vertex.joint_ids[k] = vertex.joint_ids[k - 1];
+	}
 
-	const aiMesh& mesh = *scene->mMeshes[0];
+	vertex.weights[k] = weight;
+	vertex.joint_ids[k] = joint;
+}
 
-	vertices.resize(mesh.mNumVertices);
+// bone_indices maps the mesh's own bones to the model-wide palette slots.
+static void load_mesh(const aiMesh& ai_mesh, const std::vector<uint32_t>& bone_indices, Mesh& mesh)
+{
+	mesh.name = std::string(ai_mesh.mName.data);
+	mesh.vertices.resize(ai_mesh.mNumVertices);
 
-	for (int i = 0; i < mesh.mNumVertices; i++)
+	for (int i = 0; i < ai_mesh.mNumVertices; i++)
 	{
-		const aiVector3D& position = mesh.mVertices[i];
-		const aiVector2D& uv = { mesh.mTextureCoords[0][i].x, mesh.mTextureCoords[0][i].y };
-		const aiVector3D& normal = mesh.mNormals[i];
+		Vertex& vertex = mesh.vertices[i];
 
-		memcpy(&vertices[i].position, &position, sizeof(glm::vec3));
-		memcpy(&vertices[i].uv, &uv, sizeof(glm::vec2));
-		memcpy(&vertices[i].normal, &normal, sizeof(glm::vec3));
+		vertex.position = glm::vec3(ai_mesh.mVertices[i].x, ai_mesh.mVertices[i].y, ai_mesh.mVertices[i].z);
+		vertex.normal = ai_mesh.mNormals ? glm::vec3(ai_mesh.mNormals[i].x, ai_mesh.mNormals[i].y, ai_mesh.mNormals[i].z) : glm::vec3(0.0f);
+		vertex.uv = ai_mesh.mTextureCoords[0] ? glm::vec2(ai_mesh.mTextureCoords[0][i].x, ai_mesh.mTextureCoords[0][i].y) : glm::vec2(0.0f);
+		vertex.joint_ids = glm::ivec4(0);
+		vertex.weights = glm::vec4(0.0f);
 	}
 
-	indices.resize(mesh.mNumFaces * 3);
+	mesh.indices.resize(ai_mesh.mNumFaces * 3);
 
 	const uint32_t indices_per_face = 3;
 
-	for (int i = 0; i < mesh.mNumFaces; i++)
+	for (int i = 0; i < ai_mesh.mNumFaces; i++)
 		for (int j = 0; j < indices_per_face; j++)
-			indices[i * indices_per_face + j] = mesh.mFaces[i].mIndices[j];
+			mesh.indices[i * indices_per_face + j] = ai_mesh.mFaces[i].mIndices[j];
 
-	struct PerVertexBoneData { uint32_t ids[4]; float weights[4]; };
-	std::vector<PerVertexBoneData> bones_data(mesh.mNumVertices);
+	for (int i = 0; i < ai_mesh.mNumBones; i++)
+	{
+		const aiBone& bone = *ai_mesh.mBones[i];
 
-	std::map<std::string, uint32_t> bones_map;
-	uint32_t amount_of_bones = 0;
+		for (int j = 0; j < bone.mNumWeights; j++)
+			add_influence(mesh.vertices[bone.mWeights[j].mVertexId], static_cast<int32_t>(bone_indices[i]), bone.mWeights[j].mWeight);
+	}
 
-	for (int i = 0; i < mesh.mNumBones; i++)
+	// Whatever was dropped past the fourth influence is redistributed over the ones kept.
+	for (Vertex& vertex : mesh.vertices)
 	{
-		uint32_t bone_index = 0;
-		const std::string bone_name(mesh.mBones[i]->mName.data);
+		const float weight_sum = vertex.weights[0] + vertex.weights[1] + vertex.weights[2] + vertex.weights[3];
+
+		if (weight_sum > 0.0f)
+			vertex.weights /= weight_sum;
+	}
+
+	// Once the influences are final, so vertices only merge when they skin the same.
+	mesh_optimizer::optimize(mesh);
+}
+
+Model::Model(const std::string& path, JobSystem* job_system)
+{
+	const std::shared_ptr<files::FileData> file = files::FileData::load(path);
+
+	if (!file)
+		return;
+
+	// Parsed from memory with the extension as the format hint; files the model references by name aren't
+	// opened, skins come from the SkinSet.
+	Assimp::Importer importer;
+
+	const aiScene* scene = importer.ReadFileFromMemory(file->get_data(), file->get_size(), aiProcess_Triangulate | aiProcess_FlipUVs, files::get_type(path).c_str());
+
+	if (!scene || !scene->mRootNode)
+	{
+		spdlog::error("Failed to load model {0}: {1}", path, importer.GetErrorString());
+		return;
+	}
+
+	// Palette slots are shared by all meshes, so they're assigned up front and the meshes can be processed independently.
+	std::map<std::string, uint32_t> bones_map;
+	std::vector<std::vector<uint32_t>> mesh_bone_indices(scene->mNumMeshes);
 
-		if (bones_map.find(bone_name) == bones_map.end())
-			bones_map[bone_name] = bone_index = amount_of_bones++;
-		else
-			bone_index = bones_map[bone_name];
+	for (int i = 0; i < scene->mNumMeshes; i++)
+	{
+		const aiMesh& ai_mesh = *scene->mMeshes[i];
 
-		for (int j = 0; j < mesh.mBones[i]->mNumWeights; j++)
+		for (int j = 0; j < ai_mesh.mNumBones; j++)
 		{
-			const uint32_t vertex_id = mesh.mBones[i]->mWeights[j].mVertexId;
-			const float weight = mesh.mBones[i]->mWeights[j].mWeight;
-
-			for (int k = 0; k < 4; k++)
-			{
-				if (bones_data[vertex_id].weights[k] == 0.0)
-				{
-					bones_data[vertex_id].ids[k] = bone_index;
-					bones_data[vertex_id].weights[k] = weight;
-					break;
-				}
-			}
+			const aiBone& bone = *ai_mesh.mBones[j];
+			const auto [bone_it, inserted] = bones_map.insert({ std::string(bone.mName.data), static_cast<uint32_t>(bone_map.size()) });
+
+			if (inserted)
+				bone_map.push_back({ bone_it->first, convert_matrix(bone.mOffsetMatrix) });
+
+			mesh_bone_indices[i].push_back(bone_it->second);
 		}
 	}
 
-	for (int i = 0; i < mesh.mNumVertices; i++)
+	meshes.resize(scene->mNumMeshes);
+
+	const auto load_meshes = [&](uint32_t begin, uint32_t end)
 	{
-		memcpy(&vertices[i].joint_ids[0], &bones_data[i].ids[0], sizeof(glm::vec4));
-		memcpy(&vertices[i].weights[0], &bones_data[i].weights[0], sizeof(glm::vec4));
-	}
+		for (uint32_t i = begin; i < end; i++)
+			load_mesh(*scene->mMeshes[i], mesh_bone_indices[i], meshes[i]);
+	};
 
-	for (int i = 0; i < mesh.mNumBones; i++)
-		bone_map.push_back({ mesh.mBones[i]->mName.data, convert_matrix(mesh.mBones[i]->mOffsetMatrix) });	
+	if (job_system)
+		job_system->parallel_for(scene->mNumMeshes, 1, load_meshes);
+	else
+		load_meshes(0, scene->mNumMeshes);
 
 	create_skeleton(scene->mRootNode, skeleton);
+
+	animations.reserve(scene->mNumAnimations);
+
+	for (int i = 0; i < scene->mNumAnimations; i++)
+		animations.emplace_back(*scene->mAnimations[i]);
+
+	loaded = true;
+
+	// The importer (and with it the whole aiScene) goes away here.
+}
+
+bool Model::is_loaded() const
+{
+	return loaded;
 }
 
-Model::~Model()
+Mesh Model::merge_meshes() const
 {
-	delete importer;
+	Mesh merged;
+
+	size_t vertex_count = 0;
+	size_t index_count = 0;
+
+	for (const Mesh& mesh : meshes)
+	{
+		vertex_count += mesh.vertices.size();
+		index_count += mesh.indices.size();
+	}
+
+	merged.vertices.reserve(vertex_count);
+	merged.indices.reserve(index_count);
+
+	for (const Mesh& mesh : meshes)
+	{
+		const uint32_t first_vertex = static_cast<uint32_t>(merged.vertices.size());
+
+		merged.vertices.insert(merged.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+
+		for (uint32_t index : mesh.indices)
+			merged.indices.push_back(first_vertex + index);
+	}
+
+	return merged;
 }
\ No newline at end of file
@@ -14,15 +14,7 @@
 
 #include "../animation/animation.h"
 
-struct aiNode;
-struct aiMesh;
-struct aiScene;
-struct aiAnimation;
-
-namespace Assimp
-{
-	class Importer;
-}
+class JobSystem;
 
 struct Vertex
 {
@@ -39,27 +31,45 @@ struct Vertex
             { 3, sizeof(Vertex), offsetof(Vertex, position) },
             { 2, sizeof(Vertex), offsetof(Vertex, uv) },
             { 3, sizeof(Vertex), offsetof(Vertex, normal) },
-            { 4, sizeof(Vertex), offsetof(Vertex, joint_ids) },
+            { 4, sizeof(Vertex), offsetof(Vertex, joint_ids), 0, VertexBufferLayout::ComponentType::Int32 },
             { 4, sizeof(Vertex), offsetof(Vertex, weights) },
         };
     }
 };
 
+struct Mesh
+{
+	std::string name;
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+};
+
+// Everything a model file holds, read in a single Assimp import: all meshes, the skeleton and all animations.
+// The imported scene is released before the constructor returns, nothing of Assimp outlives loading.
+// Vertices keep their four largest bone influences, sorted from the largest down and renormalised to sum to one.
+// Each mesh is deduplicated and reordered for the vertex cache, overdraw and vertex fetch, see mesh_optimizer.
 class Model
 {
 public:
-	Model(const std::string& path);
-	~Model();
+	// With a job system, meshes are processed in parallel.
+	Model(const std::string& path, JobSystem* job_system = nullptr);
+
+	bool is_loaded() const;
 
+	// Joint ids of every mesh index into bone_map, which holds each bone once.
 	OffsetPerNameVec_t bone_map;
 	Skeleton_t skeleton;
 
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	std::vector<Mesh> meshes;
+	std::vector<Animation> animations;
 
-	Assimp::Importer* importer;
+	// All meshes in one vertex/index buffer pair, for drawing the model with a single call.
+	Mesh merge_meshes() const;
 
 private:
+	bool loaded{false};
+
 	Model(const Model&) = delete;
 	Model& operator=(const Model&) = delete;
 };
\ No newline at end of file
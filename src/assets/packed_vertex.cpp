@@ -0,0 +1,145 @@
+#include "packed_vertex.h"
+
+#include "model.h"
+
+#include "../core/jobs/job_system.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Vertices handed to one job when packing in parallel.
+static constexpr uint32_t PACK_BATCH_SIZE = 4096;
+
+static int16_t to_snorm16(float value)
+{
+	return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Octahedral encoding: projects the unit sphere onto an octahedron and unfolds it into [-1, 1]^2.
+static glm::vec2 oct_encode(const glm::vec3& normal)
+{
+	const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+	if (length == 0.0f)
+		return glm::vec2(0.0f, 0.0f);
+
+	glm::vec2 encoded = glm::vec2(normal.x, normal.y) / length;
+
+	if (normal.z < 0.0f)
+	{
+		encoded = glm::vec2(
+			(1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f)
+		);
+	}
+
+	return encoded;
+}
+
+QuantizationBounds QuantizationBounds::from_vertices(const std::vector<Vertex>& vertices)
+{
+	QuantizationBounds bounds;
+
+	if (vertices.empty())
+		return bounds;
+
+	glm::vec3 min = vertices[0].position;
+	glm::vec3 max = vertices[0].position;
+
+	for (const Vertex& vertex : vertices)
+	{
+		min = glm::min(min, vertex.position);
+		max = glm::max(max, vertex.position);
+	}
+
+	bounds.offset = (min + max) * 0.5f;
+	bounds.scale = glm::max((max - min) * 0.5f, glm::vec3(1e-6f));
+
+	return bounds;
+}
+
+glm::vec3 PackedVertex::get_position(const QuantizationBounds& bounds) const
+{
+	const glm::vec3 stored = glm::vec3(position[0], position[1], position[2]) / 32767.0f;
+	return bounds.offset + bounds.scale * glm::max(stored, glm::vec3(-1.0f));
+}
+
+PackedVertex PackedVertex::pack(const Vertex& vertex, const QuantizationBounds& bounds)
+{
+	PackedVertex packed;
+
+	const glm::vec3 position = (vertex.position - bounds.offset) / bounds.scale;
+	packed.position[0] = to_snorm16(position.x);
+	packed.position[1] = to_snorm16(position.y);
+	packed.position[2] = to_snorm16(position.z);
+	packed.position[3] = 0;
+
+	packed.uv[0] = glm::packHalf1x16(vertex.uv.x);
+	packed.uv[1] = glm::packHalf1x16(vertex.uv.y);
+
+	const glm::vec2 normal = oct_encode(vertex.normal);
+	packed.normal[0] = to_snorm16(normal.x);
+	packed.normal[1] = to_snorm16(normal.y);
+
+	// Weights are renormalised before rounding; the largest one absorbs the rounding error
+	// so the four always sum to exactly 255.
+	float weight_sum = 0.0f;
+	uint32_t largest = 0;
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		weight_sum += std::max(vertex.weights[i], 0.0f);
+
+		if (vertex.weights[i] > vertex.weights[largest])
+			largest = i;
+	}
+
+	int32_t quantized_sum = 0;
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const float weight = weight_sum > 0.0f ? std::max(vertex.weights[i], 0.0f) / weight_sum : 0.0f;
+
+		packed.joint_ids[i] = static_cast<uint8_t>(vertex.joint_ids[i]);
+		packed.weights[i] = static_cast<uint8_t>(std::round(weight * 255.0f));
+
+		quantized_sum += packed.weights[i];
+	}
+
+	if (quantized_sum > 0)
+		packed.weights[largest] = static_cast<uint8_t>(std::clamp(packed.weights[largest] + 255 - quantized_sum, 0, 255));
+
+	return packed;
+}
+
+std::vector<PackedVertex> pack_vertices(const std::vector<Vertex>& vertices, const QuantizationBounds& bounds, JobSystem* job_system)
+{
+	std::vector<PackedVertex> packed(vertices.size());
+
+	const auto pack_range = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				if (vertices[i].weights[j] > 0.0f && static_cast<uint32_t>(vertices[i].joint_ids[j]) >= PackedVertex::MAX_JOINTS)
+				{
+					spdlog::error("Joint index {0} does not fit into a packed vertex", vertices[i].joint_ids[j]);
+				}
+			}
+
+			packed[i] = PackedVertex::pack(vertices[i], bounds);
+		}
+	};
+
+	if (job_system)
+		job_system->parallel_for(vertices.size(), PACK_BATCH_SIZE, pack_range);
+	else
+		pack_range(0, vertices.size());
+
+	return packed;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "xyapi/gl/vbo.h"
+
+struct Vertex;
+class JobSystem;
+
+// Positions are stored as snorm16 relative to the mesh bounds: position = offset + scale * stored.
+struct QuantizationBounds
+{
+	glm::vec3 offset { 0.0f };
+	glm::vec3 scale  { 1.0f };
+
+	static QuantizationBounds from_vertices(const std::vector<Vertex>& vertices);
+};
+
+// 24-byte skinned vertex: snorm16 position, half uv, oct-encoded snorm16 normal,
+// uint8 joint indices and unorm8 weights (so at most 256 bones per mesh).
+struct PackedVertex
+{
+	int16_t  position[4];
+	uint16_t uv[2];
+	int16_t  normal[2];
+	uint8_t  joint_ids[4];
+	uint8_t  weights[4];
+
+	static constexpr uint32_t MAX_JOINTS = 256;
+
+	static PackedVertex pack(const Vertex& vertex, const QuantizationBounds& bounds);
+
+	glm::vec3 get_position(const QuantizationBounds& bounds) const;
+
+	inline static std::vector<VertexBufferLayout> GetLayout()
+	{
+		using Type = VertexBufferLayout::ComponentType;
+
+		return
+		{
+			{ 3, sizeof(PackedVertex), offsetof(PackedVertex, position),  0, Type::Int16,     true  },
+			{ 2, sizeof(PackedVertex), offsetof(PackedVertex, uv),        0, Type::HalfFloat, false },
+			{ 2, sizeof(PackedVertex), offsetof(PackedVertex, normal),    0, Type::Int16,     true  },
+			{ 4, sizeof(PackedVertex), offsetof(PackedVertex, joint_ids), 0, Type::UInt8,     false },
+			{ 4, sizeof(PackedVertex), offsetof(PackedVertex, weights),   0, Type::UInt8,     true  },
+		};
+	}
+};
+
+static_assert(sizeof(PackedVertex) == 24, "PackedVertex has to stay 24 bytes, skinning.comp reads it as six uints");
+
+// With a job system, ranges of vertices are packed in parallel.
+std::vector<PackedVertex> pack_vertices(const std::vector<Vertex>& vertices, const QuantizationBounds& bounds, JobSystem* job_system = nullptr);
@@ -0,0 +1,253 @@
+#include "texture_file.h"
+
+#include <GL/glew.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+static constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static constexpr size_t KTX2_HEADER_SIZE = 80;
+static constexpr size_t KTX2_LEVEL_SIZE = 24;
+
+static constexpr uint32_t DDS_MAGIC = 0x20534444;
+static constexpr size_t DDS_HEADER_SIZE = 128;
+static constexpr size_t DDS_DX10_HEADER_SIZE = 20;
+
+static constexpr uint32_t make_four_cc(char a, char b, char c, char d)
+{
+	return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+}
+
+template <typename T>
+static T read(const uint8_t* data, size_t offset)
+{
+	T value;
+	memcpy(&value, data + offset, sizeof(T));
+	return value;
+}
+
+static bool has_extension(const std::string& path, const std::string& extension)
+{
+	if (path.size() < extension.size())
+		return false;
+
+	return std::equal(extension.rbegin(), extension.rend(), path.rbegin(), [](char a, char b)
+	{
+		return a == std::tolower(static_cast<unsigned char>(b));
+	});
+}
+
+// VK_FORMAT_* values from the Vulkan spec, which is what KTX2 stores.
+static int32_t vk_format_to_gl(uint32_t vk_format)
+{
+	switch (vk_format)
+	{
+	case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case 132: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+	case 133: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case 134: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+	case 135: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+	case 136: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+	case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case 138: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	case 139: return GL_COMPRESSED_RED_RGTC1;
+	case 140: return GL_COMPRESSED_SIGNED_RED_RGTC1;
+	case 141: return GL_COMPRESSED_RG_RGTC2;
+	case 142: return GL_COMPRESSED_SIGNED_RG_RGTC2;
+	case 143: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+	case 144: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+	case 145: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	case 146: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+	case 147: return GL_COMPRESSED_RGB8_ETC2;
+	case 148: return GL_COMPRESSED_SRGB8_ETC2;
+	case 149: return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+	case 150: return GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+	case 151: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+	case 152: return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+	case 153: return GL_COMPRESSED_R11_EAC;
+	case 154: return GL_COMPRESSED_SIGNED_R11_EAC;
+	case 155: return GL_COMPRESSED_RG11_EAC;
+	case 156: return GL_COMPRESSED_SIGNED_RG11_EAC;
+	}
+
+	// ASTC comes in unorm/sRGB pairs per block size, in the same block size order as the GL enums.
+	if (vk_format >= 157 && vk_format <= 184)
+	{
+		const uint32_t block_size = (vk_format - 157) / 2;
+		const bool srgb = (vk_format - 157) % 2 == 1;
+
+		return static_cast<int32_t>((srgb ? GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR : GL_COMPRESSED_RGBA_ASTC_4x4_KHR) + block_size);
+	}
+
+	return 0;
+}
+
+static int32_t four_cc_to_gl(uint32_t four_cc)
+{
+	switch (four_cc)
+	{
+	case make_four_cc('D', 'X', 'T', '1'): return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case make_four_cc('D', 'X', 'T', '3'): return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+	case make_four_cc('D', 'X', 'T', '5'): return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case make_four_cc('A', 'T', 'I', '1'):
+	case make_four_cc('B', 'C', '4', 'U'): return GL_COMPRESSED_RED_RGTC1;
+	case make_four_cc('A', 'T', 'I', '2'):
+	case make_four_cc('B', 'C', '5', 'U'): return GL_COMPRESSED_RG_RGTC2;
+	}
+
+	return 0;
+}
+
+// DXGI_FORMAT_* values, from the DX10 extension header.
+static int32_t dxgi_format_to_gl(uint32_t dxgi_format)
+{
+	switch (dxgi_format)
+	{
+	case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case 72: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+	case 74: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+	case 75: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+	case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	case 80: return GL_COMPRESSED_RED_RGTC1;
+	case 81: return GL_COMPRESSED_SIGNED_RED_RGTC1;
+	case 83: return GL_COMPRESSED_RG_RGTC2;
+	case 84: return GL_COMPRESSED_SIGNED_RG_RGTC2;
+	case 95: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+	case 96: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+	case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+	}
+
+	return 0;
+}
+
+// Bytes per 4x4 block of the BCn formats a DDS file can hold.
+static size_t get_block_size(int32_t internal_format)
+{
+	switch (internal_format)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+		return 8;
+	}
+
+	return 16;
+}
+
+TextureFile::TextureFile(const std::string& path) : file{files::FileData::load(path)}
+{
+	if (!file)
+		return;
+
+	const bool loaded = has_extension(path, ".ktx2") ? load_ktx2() : load_dds();
+
+	if (!loaded)
+	{
+		spdlog::error("Unsupported or corrupt texture file: {0}", path);
+		levels.clear();
+	}
+}
+
+bool TextureFile::is_texture_file(const std::string& path)
+{
+	return has_extension(path, ".ktx2") || has_extension(path, ".dds");
+}
+
+bool TextureFile::is_loaded() const
+{
+	return !levels.empty();
+}
+
+bool TextureFile::load_ktx2()
+{
+	const uint8_t* data = file->get_data();
+	const size_t size = file->get_size();
+
+	if (size < KTX2_HEADER_SIZE || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		return false;
+
+	internal_format = vk_format_to_gl(read<uint32_t>(data, 12));
+	width = read<uint32_t>(data, 20);
+	height = read<uint32_t>(data, 24);
+
+	const uint32_t depth = read<uint32_t>(data, 28);
+	const uint32_t layer_count = read<uint32_t>(data, 32);
+	const uint32_t face_count = read<uint32_t>(data, 36);
+	const uint32_t level_count = std::max(read<uint32_t>(data, 40), 1u);
+	const uint32_t supercompression = read<uint32_t>(data, 44);
+
+	// Plain 2D textures only; Basis/zstd supercompressed files would need a transcoder first.
+	if (!internal_format || depth > 0 || layer_count > 1 || face_count != 1 || supercompression != 0)
+		return false;
+
+	if (size < KTX2_HEADER_SIZE + level_count * KTX2_LEVEL_SIZE)
+		return false;
+
+	for (uint32_t i = 0; i < level_count; ++i)
+	{
+		const size_t entry = KTX2_HEADER_SIZE + i * KTX2_LEVEL_SIZE;
+		const uint64_t offset = read<uint64_t>(data, entry);
+		const uint64_t length = read<uint64_t>(data, entry + 8);
+
+		if (offset + length > size)
+			return false;
+
+		levels.push_back({ std::max(width >> i, 1u), std::max(height >> i, 1u), data + offset, static_cast<size_t>(length) });
+	}
+
+	return true;
+}
+
+bool TextureFile::load_dds()
+{
+	const uint8_t* data = file->get_data();
+	const size_t size = file->get_size();
+
+	if (size < DDS_HEADER_SIZE || read<uint32_t>(data, 0) != DDS_MAGIC)
+		return false;
+
+	height = read<uint32_t>(data, 12);
+	width = read<uint32_t>(data, 16);
+
+	const uint32_t level_count = std::max(read<uint32_t>(data, 28), 1u);
+	const uint32_t four_cc = read<uint32_t>(data, 84);
+
+	if (four_cc != make_four_cc('D', 'X', '1', '0'))
+	{
+		internal_format = four_cc_to_gl(four_cc);
+		return internal_format && add_block_levels(DDS_HEADER_SIZE, level_count);
+	}
+
+	if (size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE)
+		return false;
+
+	internal_format = dxgi_format_to_gl(read<uint32_t>(data, DDS_HEADER_SIZE));
+	return internal_format && add_block_levels(DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE, level_count);
+}
+
+bool TextureFile::add_block_levels(size_t offset, uint32_t level_count)
+{
+	const size_t block_size = get_block_size(internal_format);
+
+	for (uint32_t i = 0; i < level_count; ++i)
+	{
+		const uint32_t level_width = std::max(width >> i, 1u);
+		const uint32_t level_height = std::max(height >> i, 1u);
+		const size_t level_size = static_cast<size_t>((level_width + 3) / 4) * ((level_height + 3) / 4) * block_size;
+
+		if (offset + level_size > file->get_size())
+			return false;
+
+		levels.push_back({ level_width, level_height, file->get_data() + offset, level_size });
+		offset += level_size;
+	}
+
+	return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../files/file_data.h"
+
+// A texture that was compressed offline (KTX2 or DDS with BCn, ETC2 or ASTC data), mip chain included.
+// The levels point into the FileData (mapped for all but small files) and go to the GPU as they are.
+class TextureFile
+{
+public:
+	struct Level
+	{
+		uint32_t width;
+		uint32_t height;
+
+		const uint8_t* data;
+		size_t size;
+	};
+
+	TextureFile(const std::string& path);
+
+	// Whether path has an extension this loader understands.
+	static bool is_texture_file(const std::string& path);
+
+	bool is_loaded() const;
+
+	int32_t internal_format{0};
+	uint32_t width{0}, height{0};
+
+	std::vector<Level> levels;
+
+private:
+	bool load_ktx2();
+	bool load_dds();
+
+	// Only for the DDS path, KTX2 stores the size of every level.
+	bool add_block_levels(size_t offset, uint32_t level_count);
+
+	std::shared_ptr<files::FileData> file;
+
+	TextureFile(const TextureFile&) = delete;
+	TextureFile& operator=(const TextureFile&) = delete;
+};
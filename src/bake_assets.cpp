@@ -0,0 +1,67 @@
+#include "assets/asset_pack.h"
+#include "assets/model.h"
+#include "assets/mesh_lods.h"
+#include "assets/mesh_optimizer.h"
+
+#include "core/jobs/job_system.h"
+
+#include "common.h"
+
+#include <filesystem>
+
+// Imports a model through Assimp once, offline, and writes everything the runtime needs into an asset pack:
+// packed vertices and indices of all meshes with their levels of detail, the flattened rig and every clip baked into SoA samples.
+bool bake_assets(const std::string& source, const std::string& destination)
+{
+	spdlog::info("Baking {0} into {1}..", source, destination);
+
+	JobSystem job_system;
+
+	Model model(source, &job_system);
+
+	if (!model.is_loaded())
+		return false;
+
+	const Mesh mesh = model.merge_meshes();
+	const Rig rig(model.bone_map, model.skeleton);
+	const QuantizationBounds bounds = QuantizationBounds::from_vertices(mesh.vertices);
+
+	AssetPackWriter writer;
+
+	// Simplified levels only drop vertices, so the bounds of level 0 hold all of them.
+	const std::vector<Mesh> lods = mesh_lods::generate(mesh);
+
+	for (uint32_t i = 0; i < lods.size(); i++)
+	{
+		const Mesh& lod = lods[i];
+
+		spdlog::info("LOD {0}: {1} vertices, {2} triangles, {3:.3f} cache misses per triangle", i, lod.vertices.size(), lod.indices.size() / 3, mesh_optimizer::get_acmr(lod.indices, lod.vertices.size()));
+		writer.add_mesh(pack_vertices(lod.vertices, bounds, &job_system), bounds, lod.indices, i);
+	}
+
+	writer.add_rig(rig);
+
+	for (const Animation& animation : model.animations)
+		writer.add_clip(BakedAnimation(animation));
+
+	const std::filesystem::path destination_directory = std::filesystem::path(destination).parent_path();
+
+	if (!destination_directory.empty())
+		std::filesystem::create_directories(destination_directory);
+
+	return writer.save(destination);
+}
+
+#ifdef BAKE_ASSETS
+int main(int argc, char* argv[])
+{
+	arguments(argc, argv);
+
+	const std::vector<std::string>& args = get_arguments();
+
+	const std::string source = args.size() > 1 ? args[1] : "assets/models/1.fbx";
+	const std::string destination = args.size() > 2 ? args[2] : "assets/baked/1.pack";
+
+	return bake_assets(source, destination) ? 0 : 1;
+}
+#endif
@@ -0,0 +1,450 @@
+#include "animation/animation.h"
+#include "animation/animation_world.h"
+#include "animation/compressed_animation.h"
+#include "animation/pose_kernel.h"
+#include "animation/pose_query.h"
+
+#include "assets/asset_pack.h"
+#include "assets/model.h"
+
+#include "core/jobs/job_system.h"
+#include "core/profiler/profiler.h"
+
+#include "common.h"
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+// Pose evaluation throughput without a window or GL context. Rigs and clips are synthetic by default, so the numbers
+// only move when the sampling, hierarchy or blending code does; every run evaluates the same work. A model or baked
+// pack given on the command line is benched instead, with its first clip.
+
+static constexpr uint32_t BONE_COUNTS[] = { 50, 100, 250, 500 };
+
+// Long enough that cursors and caches see realistic clip sizes.
+static constexpr float CLIP_SECONDS = 60.0f;
+static constexpr float KEYS_PER_SECOND = 30.0f;
+
+static constexpr float FRAME_TIME = 1.0f / 60.0f;
+
+struct BenchRig
+{
+	RigPtr_t rig;
+
+	// Packs only hold baked clips, the rows that need keyframes are skipped for them.
+	std::shared_ptr<AssetPack> pack;
+	std::unique_ptr<Animation> animation;
+	BakedAnimationPtr_t baked;
+	std::unique_ptr<CompressedAnimation> compressed;
+
+	AnimationBindingPtr_t binding;
+	AnimationBindingPtr_t second_binding;
+	std::unique_ptr<Animation> second_animation;
+};
+
+static std::string get_bone_name(uint32_t bone)
+{
+	return "bone_" + std::to_string(bone);
+}
+
+// Short chains branching off each other, roughly the shape of spines, limbs and fingers.
+static int32_t get_parent(uint32_t bone)
+{
+	return bone % 5 == 1 ? static_cast<int32_t>(bone - 1) / 2 : static_cast<int32_t>(bone) - 1;
+}
+
+static RigPtr_t create_rig(uint32_t bone_count)
+{
+	std::vector<SkeletonNode> nodes(bone_count);
+	std::vector<std::string> names(bone_count);
+	std::vector<glm::mat4> bind_globals(bone_count);
+	std::vector<glm::mat4> offsets(bone_count);
+
+	for (uint32_t i = 0; i < bone_count; i++)
+	{
+		SkeletonNode& node = nodes[i];
+		node.parent = i == 0 ? -1 : get_parent(i);
+		node.bone_index = i;
+		node.transformation = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.02f * (i % 3)));
+
+		names[i] = get_bone_name(i);
+		bind_globals[i] = node.parent < 0 ? node.transformation : bind_globals[node.parent] * node.transformation;
+		offsets[i] = glm::inverse(bind_globals[i]);
+	}
+
+	return std::make_shared<Rig>(Skeleton(std::move(nodes), names), std::move(offsets), glm::mat4(1.0f), names);
+}
+
+// Every bone rotates on its own phase and the root moves as well; scale tracks are constant, like in most clips.
+static std::unique_ptr<Animation> create_clip(uint32_t bone_count, float phase)
+{
+	const uint32_t key_count = static_cast<uint32_t>(CLIP_SECONDS * KEYS_PER_SECOND) + 1;
+
+	aiAnimation clip;
+	clip.mName.Set("synthetic");
+	clip.mDuration = key_count - 1;
+	clip.mTicksPerSecond = KEYS_PER_SECOND;
+	clip.mNumChannels = bone_count;
+	clip.mChannels = new aiNodeAnim*[bone_count];
+
+	for (uint32_t i = 0; i < bone_count; i++)
+	{
+		aiNodeAnim* channel = clip.mChannels[i] = new aiNodeAnim();
+		channel->mNodeName.Set(get_bone_name(i));
+
+		channel->mNumPositionKeys = key_count;
+		channel->mNumRotationKeys = key_count;
+		channel->mNumScalingKeys = key_count;
+		channel->mPositionKeys = new aiVectorKey[key_count];
+		channel->mRotationKeys = new aiQuatKey[key_count];
+		channel->mScalingKeys = new aiVectorKey[key_count];
+
+		const glm::vec3 axis = glm::normalize(glm::vec3(1.0f + i % 3, 1.0f + i % 5, 1.0f + i % 7));
+
+		for (uint32_t key = 0; key < key_count; key++)
+		{
+			const float t = key / KEYS_PER_SECOND;
+			const glm::quat rotation = glm::angleAxis(0.4f * std::sin(t * 2.0f + i * 0.3f + phase), axis);
+			const float offset = i == 0 ? std::sin(t + phase) : 0.0f;
+
+			channel->mPositionKeys[key].mTime = key;
+			channel->mPositionKeys[key].mValue.x = offset;
+			channel->mPositionKeys[key].mValue.y = 0.1f;
+			channel->mPositionKeys[key].mValue.z = 0.02f * (i % 3);
+
+			channel->mRotationKeys[key].mTime = key;
+			channel->mRotationKeys[key].mValue.w = rotation.w;
+			channel->mRotationKeys[key].mValue.x = rotation.x;
+			channel->mRotationKeys[key].mValue.y = rotation.y;
+			channel->mRotationKeys[key].mValue.z = rotation.z;
+
+			channel->mScalingKeys[key].mTime = key;
+			channel->mScalingKeys[key].mValue.x = 1.0f;
+			channel->mScalingKeys[key].mValue.y = 1.0f;
+			channel->mScalingKeys[key].mValue.z = 1.0f;
+		}
+	}
+
+	return std::make_unique<Animation>(clip);
+}
+
+static BenchRig create_synthetic_rig(uint32_t bone_count)
+{
+	BenchRig synthetic;
+
+	synthetic.rig = create_rig(bone_count);
+	synthetic.animation = create_clip(bone_count, 0.0f);
+	synthetic.second_animation = create_clip(bone_count, 1.0f);
+	synthetic.baked = std::make_shared<BakedAnimation>(*synthetic.animation);
+	synthetic.compressed = std::make_unique<CompressedAnimation>(*synthetic.animation);
+	synthetic.binding = std::make_shared<AnimationBinding>(synthetic.rig->skeleton, *synthetic.animation);
+	synthetic.second_binding = std::make_shared<AnimationBinding>(synthetic.rig->skeleton, *synthetic.second_animation);
+
+	return synthetic;
+}
+
+// The first clip of a baked pack, or of anything Assimp imports. Returns false if there's no rig and clip to bench.
+static bool load_rig(const std::string& path, BenchRig& loaded)
+{
+	if (std::filesystem::path(path).extension() == ".pack")
+	{
+		loaded.pack = std::make_shared<AssetPack>(path);
+
+		if (!loaded.pack->is_loaded() || loaded.pack->get_clip_count() == 0)
+			return false;
+
+		loaded.rig = loaded.pack->create_rig();
+		loaded.baked = loaded.pack->create_clip(0);
+		loaded.binding = std::make_shared<AnimationBinding>(loaded.rig->skeleton, *loaded.baked);
+
+		return true;
+	}
+
+	Model model(path);
+
+	if (model.animations.empty())
+		return false;
+
+	loaded.rig = std::make_shared<Rig>(model.bone_map, model.skeleton);
+	loaded.animation = std::make_unique<Animation>(std::move(model.animations[0]));
+	loaded.baked = std::make_shared<BakedAnimation>(*loaded.animation);
+	loaded.compressed = std::make_unique<CompressedAnimation>(*loaded.animation);
+	loaded.binding = std::make_shared<AnimationBinding>(loaded.rig->skeleton, *loaded.animation);
+
+	// With a single clip the blend row cross-fades it with itself.
+	if (model.animations.size() > 1)
+	{
+		loaded.second_animation = std::make_unique<Animation>(std::move(model.animations[1]));
+		loaded.second_binding = std::make_shared<AnimationBinding>(loaded.rig->skeleton, *loaded.second_animation);
+	}
+	else
+	{
+		loaded.second_binding = loaded.binding;
+	}
+
+	return true;
+}
+
+static double measure(const std::function<void()>& work)
+{
+	const auto start = std::chrono::steady_clock::now();
+	work();
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count();
+}
+
+static void report(const char* name, uint32_t bone_count, uint32_t threads, uint64_t poses, double seconds)
+{
+	const double ns_per_bone = seconds * 1e9 / (static_cast<double>(poses) * bone_count);
+
+	std::printf("%-12s %5u bones %3u threads %10.2f ns/bone %12.0f poses/s\n", name, bone_count, threads, ns_per_bone, poses / seconds);
+}
+
+// Largest difference of any matrix element the vector kernels may have from the scalar reference; the terms are
+// around unit size, so this leaves a few ulps for FMA contraction and the refined NEON reciprocal square root.
+static constexpr float KERNEL_TOLERANCE = 1e-6f;
+
+// Every supported pose_kernel implementation against sample_local_matrices_scalar, over frame pairs and blend
+// factors spread across the clip. Returns false and reports the worst element if one of them differs.
+static bool check_kernels(const BenchRig& bench_rig)
+{
+	const BakedAnimation& baked = *bench_rig.baked;
+	const pose_kernel::Implementation selected = pose_kernel::get_implementation();
+
+	std::vector<glm::mat4> expected(baked.channel_stride);
+	std::vector<glm::mat4> sampled(baked.channel_stride);
+
+	bool matches = true;
+
+	for (const pose_kernel::Implementation implementation : { pose_kernel::Implementation::SSE, pose_kernel::Implementation::AVX, pose_kernel::Implementation::NEON })
+	{
+		if (!pose_kernel::set_implementation(implementation))
+			continue;
+
+		float max_error = 0.0f;
+
+		for (uint32_t frame = 0; frame < baked.frame_count; frame += 37)
+		{
+			const uint32_t next_frame = std::min(frame + 1, baked.frame_count - 1);
+			const float alpha = (frame % 10) / 10.0f;
+
+			pose_kernel::sample_local_matrices_scalar(baked, frame, next_frame, alpha, expected.data());
+			pose_kernel::sample_local_matrices(baked, frame, next_frame, alpha, sampled.data());
+
+			for (uint32_t channel = 0; channel < baked.channel_count; channel++)
+				for (int column = 0; column < 4; column++)
+					for (int row = 0; row < 4; row++)
+						max_error = std::max(max_error, std::abs(sampled[channel][column][row] - expected[channel][column][row]));
+		}
+
+		if (max_error > KERNEL_TOLERANCE)
+		{
+			std::fprintf(stderr, "%s kernel differs from scalar by %g on %u channels\n", pose_kernel::get_implementation_name(implementation), max_error, baked.channel_count);
+			matches = false;
+		}
+	}
+
+	pose_kernel::set_implementation(selected);
+
+	return matches;
+}
+
+// avatar_count avatars advance frame_count frames, each starting at its own point of the clip.
+static void bench_single_thread(const BenchRig& bench_rig, uint32_t avatar_count, uint32_t frame_count)
+{
+	const uint32_t bone_count = bench_rig.rig->get_amount_of_bones();
+	const uint64_t poses = static_cast<uint64_t>(avatar_count) * frame_count;
+
+	std::vector<std::unique_ptr<Avatar>> avatars(avatar_count);
+
+	for (std::unique_ptr<Avatar>& avatar : avatars)
+	{
+		avatar = std::make_unique<Avatar>();
+		avatar->init(bench_rig.rig);
+	}
+
+	const auto run = [&](const char* name, const std::function<void(uint32_t, float)>& pose)
+	{
+		const double seconds = measure([&]()
+		{
+			for (uint32_t frame = 0; frame < frame_count; frame++)
+				for (uint32_t i = 0; i < avatar_count; i++)
+					pose(i, frame * FRAME_TIME + i * 0.37f);
+		});
+
+		report(name, bone_count, 1, poses, seconds);
+	};
+
+	if (bench_rig.animation)
+		run("keyframes", [&](uint32_t i, float time) { avatars[i]->calculate_pose(time, *bench_rig.binding); });
+
+	run("baked", [&](uint32_t i, float time) { avatars[i]->calculate_pose(time, *bench_rig.baked, *bench_rig.binding); });
+
+	// Every avatar stays at its own time, so after the first frame each pose is the cached one.
+	run("paused", [&](uint32_t i, float) { avatars[i]->calculate_pose(i * 0.37f, *bench_rig.baked, *bench_rig.binding); });
+
+	if (bench_rig.compressed)
+		run("compressed", [&](uint32_t i, float time) { avatars[i]->calculate_pose(time, *bench_rig.compressed, *bench_rig.binding); });
+
+	// What a hit-detection server asks for: the root and a few extremities, still reported per bone of the whole rig.
+	const int32_t node_count = bench_rig.rig->skeleton.get_amount_of_nodes();
+	const PoseQuery query(bench_rig.rig, std::vector<int32_t>{ 0, node_count / 2, node_count - 1 });
+	std::vector<glm::mat4> queried(query.get_node_count());
+
+	run("query", [&](uint32_t, float time) { query.evaluate(time, *bench_rig.baked, *bench_rig.binding, queried.data()); });
+
+	if (!bench_rig.animation)
+		return;
+
+	// Two clips cross-faded on top of the bind pose, then the hierarchy pass. Layers hold cursors, so every avatar has its own.
+	PoseBlender blender(bench_rig.rig->skeleton);
+	Pose_t pose;
+
+	std::vector<std::array<AnimationLayer, 2>> layers(avatar_count);
+
+	for (std::array<AnimationLayer, 2>& avatar_layers : layers)
+	{
+		avatar_layers[0].set_binding(bench_rig.binding);
+		avatar_layers[1].set_binding(bench_rig.second_binding);
+		avatar_layers[1].weight = 0.5f;
+	}
+
+	run("blend", [&](uint32_t i, float time)
+	{
+		layers[i][0].time = time;
+		layers[i][1].time = time;
+
+		blender.evaluate(layers[i].data(), 2, pose);
+		avatars[i]->calculate_pose(pose);
+	});
+}
+
+// The baked path through AnimationWorld, which is what the game runs, with growing worker counts.
+// The single-threaded case is the "baked" row above, JobSystem always has at least one worker.
+static void bench_scaling(const BenchRig& bench_rig, uint32_t avatar_count, uint32_t frame_count)
+{
+	const uint32_t bone_count = bench_rig.rig->get_amount_of_bones();
+	const uint32_t hardware_threads = std::max(std::thread::hardware_concurrency(), 2u);
+
+	// Powers of two, and the hardware's own count last even if it isn't one.
+	std::vector<uint32_t> thread_counts;
+
+	for (uint32_t threads = 2; threads < hardware_threads; threads *= 2)
+		thread_counts.push_back(threads);
+
+	thread_counts.push_back(hardware_threads);
+
+	for (const uint32_t threads : thread_counts)
+	{
+		// The calling thread takes part in parallel_for, so it counts as one of them.
+		JobSystem job_system(threads - 1);
+		AnimationWorld world(job_system);
+
+		for (uint32_t i = 0; i < avatar_count; i++)
+			world.add_instance(bench_rig.rig, bench_rig.baked, bench_rig.binding, i * 0.37f);
+
+		const double seconds = measure([&]()
+		{
+			for (uint32_t frame = 0; frame < frame_count; frame++)
+				world.update(FRAME_TIME);
+		});
+
+		report("world", bone_count, threads, static_cast<uint64_t>(avatar_count) * frame_count, seconds);
+	}
+}
+
+// Positive integers only; anything else keeps fallback, so a typo can't throw or bench zero avatars.
+static uint32_t parse_count(const std::string& text, uint32_t fallback)
+{
+	char* end = nullptr;
+	errno = 0;
+	const unsigned long count = std::strtoul(text.c_str(), &end, 10);
+
+	if (text.empty() || text[0] == '-' || errno != 0 || *end != '\0' || count == 0 || count > UINT32_MAX)
+	{
+		std::fprintf(stderr, "Ignoring count %s, using %u\n", text.c_str(), fallback);
+		return fallback;
+	}
+
+	return static_cast<uint32_t>(count);
+}
+
+// Timings, the kernel check and the key sizes of one rig.
+static bool bench(const BenchRig& rig, uint32_t avatar_count, uint32_t frame_count)
+{
+	const uint32_t bone_count = rig.rig->get_amount_of_bones();
+
+	// Timings of a kernel that computes something else are meaningless, but the other rows still are.
+	const bool kernels_match = check_kernels(rig);
+
+	if (rig.animation)
+	{
+		size_t key_bytes = 0;
+
+		for (const BoneAnimation& channel : rig.animation->channels)
+			key_bytes += (channel.position_keys.size() + channel.scale_keys.size()) * sizeof(KeyFrame<glm::vec3>) + channel.rotation_keys.size() * sizeof(KeyFrame<glm::quat>);
+
+		std::printf("\n%u bones: %zu bytes of keys, %zu compressed\n", bone_count, key_bytes, rig.compressed->get_memory_size());
+	}
+	else
+	{
+		std::printf("\n%u bones: baked only\n", bone_count);
+	}
+
+	bench_single_thread(rig, avatar_count, frame_count);
+	bench_scaling(rig, avatar_count, frame_count);
+
+	return kernels_match;
+}
+
+#ifdef BENCH_ANIMATION
+int main(int argc, char* argv[])
+{
+	arguments(argc, argv);
+
+	const std::vector<std::string>& args = get_arguments();
+
+	const uint32_t avatar_count = args.size() > 1 ? parse_count(args[1], 256) : 256;
+	const uint32_t frame_count = args.size() > 2 ? parse_count(args[2], 120) : 120;
+
+	// Zones would be timed along with the poses.
+	profiler::set_enabled(false);
+
+	std::printf("%u avatars x %u frames, %s kernel\n", avatar_count, frame_count, pose_kernel::get_implementation_name(pose_kernel::get_implementation()));
+
+	if (args.size() > 3)
+	{
+		BenchRig loaded;
+
+		if (!load_rig(args[3], loaded))
+		{
+			std::fprintf(stderr, "No rig and clip to bench in %s\n", args[3].c_str());
+			return 1;
+		}
+
+		std::printf("%s\n", args[3].c_str());
+
+		return bench(loaded, avatar_count, frame_count) ? 0 : 1;
+	}
+
+	std::printf("%.0f s synthetic clips\n", CLIP_SECONDS);
+
+	bool kernels_match = true;
+
+	for (const uint32_t bone_count : BONE_COUNTS)
+		kernels_match = bench(create_synthetic_rig(bone_count), avatar_count, frame_count) && kernels_match;
+
+	return kernels_match ? 0 : 1;
+}
+#endif
@@ -0,0 +1,282 @@
+#include "benchmark.h"
+
+#include <GL/glew.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Lets streaming, shader compilation and the first palette uploads settle before frames are recorded.
+static constexpr double WARMUP_SECONDS = 2.0;
+
+static double get_seconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t get_peak_memory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	// Kilobytes on Linux, bytes on macOS.
+#ifdef __APPLE__
+	return usage.ru_maxrss;
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// The whole argument has to be the number, so typos don't silently turn into 0 or a prefix of it.
+static bool parse_value(const std::string& text, uint32_t& value)
+{
+	if (text.empty() || text[0] == '-')
+		return false;
+
+	char* end = nullptr;
+	errno = 0;
+	const unsigned long parsed = std::strtoul(text.c_str(), &end, 10);
+
+	if (errno != 0 || *end != '\0' || parsed > UINT32_MAX)
+		return false;
+
+	value = static_cast<uint32_t>(parsed);
+	return true;
+}
+
+static bool parse_value(const std::string& text, float& value)
+{
+	if (text.empty())
+		return false;
+
+	char* end = nullptr;
+	errno = 0;
+	const float parsed = std::strtof(text.c_str(), &end);
+
+	if (errno != 0 || *end != '\0' || !std::isfinite(parsed))
+		return false;
+
+	value = parsed;
+	return true;
+}
+
+BenchmarkSettings BenchmarkSettings::from_arguments(const std::vector<std::string>& args)
+{
+	BenchmarkSettings settings;
+
+	for (uint32_t i = 1; i < args.size(); i++)
+	{
+		const std::string& arg = args[i];
+		const bool has_value = i + 1 < args.size();
+
+		if (arg == "--benchmark")
+			settings.enabled = true;
+		else if (arg == "--offscreen")
+			settings.offscreen = true;
+		else if (arg == "--crowd" && has_value)
+		{
+			uint32_t crowd_size = 0;
+
+			if (parse_value(args[++i], crowd_size) && crowd_size > 0)
+				settings.crowd_size = crowd_size;
+			else
+				spdlog::warn("Ignoring crowd size {0}, expected a positive integer", args[i]);
+		}
+		else if (arg == "--duration" && has_value)
+		{
+			float duration = 0.0f;
+
+			if (parse_value(args[++i], duration) && duration > 0.0f)
+				settings.duration = std::max(duration, 1.0f);
+			else
+				spdlog::warn("Ignoring duration {0}, expected seconds", args[i]);
+		}
+		else if (arg == "--output" && has_value)
+			settings.output = args[++i];
+		else if (arg == "--resolution" && has_value)
+		{
+			uint32_t width = 0, height = 0;
+
+			if (std::sscanf(args[++i].c_str(), "%ux%u", &width, &height) == 2 && width > 0 && height > 0)
+			{
+				settings.width = width;
+				settings.height = height;
+			}
+			else
+			{
+				spdlog::warn("Ignoring resolution {0}, expected WIDTHxHEIGHT", args[i]);
+			}
+		}
+		else if (arg == "--crowd" || arg == "--duration" || arg == "--output" || arg == "--resolution")
+		{
+			spdlog::warn("Ignoring {0}, it needs a value", arg);
+		}
+	}
+
+	return settings;
+}
+
+Benchmark::Benchmark(const BenchmarkSettings& settings) : settings{settings}
+{
+}
+
+bool Benchmark::is_measuring() const
+{
+	return start > 0.0 && frame_begin >= start + WARMUP_SECONDS;
+}
+
+void Benchmark::begin_frame()
+{
+	now = get_seconds();
+
+	if (is_measuring())
+		frame_times.push_back(static_cast<float>((now - frame_begin) * 1e3));
+
+	if (start == 0.0)
+		start = now;
+
+	frame_begin = now;
+}
+
+void Benchmark::end_cpu()
+{
+	if (is_measuring())
+		cpu_times.push_back(static_cast<float>((get_seconds() - frame_begin) * 1e3));
+}
+
+void Benchmark::add_gpu_frame(float milliseconds)
+{
+	// 0 until the timer has a result.
+	if (is_measuring() && milliseconds > 0.0f)
+		gpu_times.push_back(milliseconds);
+}
+
+bool Benchmark::is_running() const
+{
+	return start > 0.0;
+}
+
+bool Benchmark::is_done() const
+{
+	return is_running() && now >= start + WARMUP_SECONDS + settings.duration;
+}
+
+float Benchmark::get_progress() const
+{
+	if (!is_running())
+		return 0.0f;
+
+	return static_cast<float>(std::clamp((now - start - WARMUP_SECONDS) / settings.duration, 0.0, 1.0));
+}
+
+const BenchmarkSettings& Benchmark::get_settings() const
+{
+	return settings;
+}
+
+// Nearest-rank percentiles, mean and maximum of a series in milliseconds.
+static void append_series(std::string& out, const char* name, std::vector<float> values)
+{
+	char line[256];
+
+	if (values.empty())
+	{
+		std::snprintf(line, sizeof(line), "\t\"%s\": null,\n", name);
+		out += line;
+		return;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	const auto percentile = [&values](float p) { return values[std::min(static_cast<size_t>(p * values.size()), values.size() - 1)]; };
+
+	double sum = 0.0;
+
+	for (const float value : values)
+		sum += value;
+
+	std::snprintf(line, sizeof(line), "\t\"%s\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n", name, sum / values.size(), percentile(0.5f), percentile(0.95f), percentile(0.99f), values.back());
+	out += line;
+}
+
+static void append_string(std::string& out, const char* name, const GLubyte* value)
+{
+	out += "\t\"";
+	out += name;
+	out += "\": \"";
+
+	for (const char* c = value ? reinterpret_cast<const char*>(value) : ""; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			out += '\\';
+
+		out += *c;
+	}
+
+	out += "\",\n";
+}
+
+bool Benchmark::write_report() const
+{
+	std::string report = "{\n";
+
+	append_string(report, "vendor", glGetString(GL_VENDOR));
+	append_string(report, "renderer", glGetString(GL_RENDERER));
+	append_string(report, "version", glGetString(GL_VERSION));
+
+	double frame_seconds = 0.0;
+
+	for (const float frame_time : frame_times)
+		frame_seconds += frame_time / 1e3;
+
+	char line[256];
+	std::snprintf(line, sizeof(line), "\t\"width\": %u,\n\t\"height\": %u,\n\t\"offscreen\": %s,\n\t\"crowd_size\": %u,\n", settings.width, settings.height, settings.offscreen ? "true" : "false", settings.crowd_size);
+	report += line;
+	std::snprintf(line, sizeof(line), "\t\"duration\": %.3f,\n\t\"frames\": %u,\n\t\"fps\": %.2f,\n", frame_seconds, static_cast<uint32_t>(frame_times.size()), frame_seconds > 0.0 ? frame_times.size() / frame_seconds : 0.0);
+	report += line;
+
+	append_series(report, "frame_ms", frame_times);
+	append_series(report, "cpu_ms", cpu_times);
+	append_series(report, "gpu_ms", gpu_times);
+
+	std::snprintf(line, sizeof(line), "\t\"peak_memory_bytes\": %llu\n}\n", static_cast<unsigned long long>(get_peak_memory()));
+	report += line;
+
+	std::ofstream file(settings.output, std::ios::binary);
+
+	if (!file.is_open())
+	{
+		spdlog::error("Failed to write benchmark report {0}", settings.output);
+		return false;
+	}
+
+	file << report;
+
+	spdlog::info("Benchmark report written to {0}", settings.output);
+
+	return true;
+}
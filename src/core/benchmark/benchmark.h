@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Command line of a benchmark run:
+// anima --benchmark [--crowd N] [--duration SECONDS] [--resolution WIDTHxHEIGHT] [--offscreen] [--output PATH]
+struct BenchmarkSettings
+{
+	bool enabled{false};
+
+	// Animated avatars, laid out in a square-ish grid.
+	uint32_t crowd_size{256};
+
+	// Measured time, after the warm-up.
+	float duration{30.0f};
+
+	uint32_t width{1280};
+	uint32_t height{720};
+
+	// Renders into a hidden window.
+	bool offscreen{false};
+
+	std::string output{"benchmark.json"};
+
+	static BenchmarkSettings from_arguments(const std::vector<std::string>& args);
+};
+
+// Records frame times of a fixed-duration run and writes their percentiles, the CPU/GPU split and peak memory as JSON.
+// A frame's CPU time runs from begin_frame() to end_cpu(), i.e. everything but waiting in swap_buffers(); GPU times
+// come from timer queries and lag a frame or two behind, which doesn't matter for the distribution.
+class Benchmark
+{
+public:
+	explicit Benchmark(const BenchmarkSettings& settings);
+
+	// Starts the clock on the first call, so loading isn't measured. Frames of the warm-up aren't recorded.
+	void begin_frame();
+	void end_cpu();
+	void add_gpu_frame(float milliseconds);
+
+	bool is_running() const;
+	bool is_done() const;
+
+	// 0 to 1 over the measured time, drives the scripted camera. Stays at 0 during the warm-up.
+	float get_progress() const;
+
+	const BenchmarkSettings& get_settings() const;
+
+	// Device strings are read from the current GL context.
+	bool write_report() const;
+
+private:
+	BenchmarkSettings settings;
+
+	// Seconds on the steady clock, 0 until the first frame.
+	double start{0.0};
+	double frame_begin{0.0};
+	double now{0.0};
+
+	std::vector<float> frame_times;
+	std::vector<float> cpu_times;
+	std::vector<float> gpu_times;
+
+	bool is_measuring() const;
+
+	Benchmark(const Benchmark&) = delete;
+	Benchmark& operator=(const Benchmark&) = delete;
+};
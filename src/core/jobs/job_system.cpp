@@ -0,0 +1,216 @@
+#include "job_system.h"
+
+#include "../profiler/profiler.h"
+
+#include <algorithm>
+
+// The pool the current thread works for and the index of its queue there. Several pools may exist at once, e.g. the
+// shader compiler's next to the game's, and a worker of one submitting to another counts as outside that one.
+struct WorkerIdentity
+{
+	const JobSystem* owner{nullptr};
+	int32_t queue{-1};
+};
+
+static thread_local WorkerIdentity worker_identity;
+
+JobSystem::JobSystem(uint32_t worker_count)
+{
+	if (worker_count == 0)
+		worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	// One queue per worker plus a shared one for submissions from outside the pool.
+	for (uint32_t i = 0; i < worker_count + 1; i++)
+		queues.push_back(std::make_unique<Queue>());
+
+	for (uint32_t i = 0; i < worker_count; i++)
+		workers.emplace_back(&JobSystem::worker_loop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		running = false;
+	}
+
+	wake.notify_all();
+
+	for (int i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+uint32_t JobSystem::get_worker_count() const
+{
+	return workers.size();
+}
+
+int32_t JobSystem::get_worker_queue() const
+{
+	return worker_identity.owner == this ? worker_identity.queue : -1;
+}
+
+uint32_t JobSystem::get_queue_index() const
+{
+	const int32_t worker_queue = get_worker_queue();
+	return worker_queue >= 0 ? worker_queue : workers.size();
+}
+
+void JobSystem::submit(Job_t job, JobCounter& counter)
+{
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+	// Workers keep their own jobs local; everything else is spread round robin.
+	const int32_t worker_queue = get_worker_queue();
+	const uint32_t index = worker_queue >= 0 ? worker_queue : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->jobs.push_back({ std::move(job), &counter });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		queued_jobs.fetch_add(1, std::memory_order_release);
+	}
+
+	wake.notify_one();
+}
+
+void JobSystem::submit_background(Job_t job, JobCounter& counter)
+{
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(background_queue.mutex);
+		background_queue.jobs.push_back({ std::move(job), &counter });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		queued_jobs.fetch_add(1, std::memory_order_release);
+	}
+
+	wake.notify_one();
+}
+
+bool JobSystem::pop(uint32_t index, Job& job)
+{
+	{
+		Queue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			return true;
+		}
+	}
+
+	for (uint32_t i = 1; i < queues.size(); i++)
+	{
+		Queue& victim = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::try_run(uint32_t index)
+{
+	Job job;
+
+	if (!pop(index, job))
+		return false;
+
+	run(job);
+
+	return true;
+}
+
+bool JobSystem::try_run_background()
+{
+	Job job;
+
+	{
+		std::lock_guard<std::mutex> lock(background_queue.mutex);
+
+		if (background_queue.jobs.empty())
+			return false;
+
+		job = std::move(background_queue.jobs.front());
+		background_queue.jobs.pop_front();
+	}
+
+	run(job);
+
+	return true;
+}
+
+void JobSystem::run(Job& job)
+{
+	queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+
+	job.function();
+	job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::worker_loop(uint32_t index)
+{
+	worker_identity = { this, static_cast<int32_t>(index) };
+
+	profiler::set_thread_name("Worker " + std::to_string(index));
+
+	while (true)
+	{
+		if (try_run(index) || try_run_background())
+			continue;
+
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		wake.wait(lock, [this]() { return !running || queued_jobs.load(std::memory_order_acquire) > 0; });
+
+		if (!running)
+			return;
+	}
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	const uint32_t index = get_queue_index();
+
+	while (counter.pending.load(std::memory_order_acquire) > 0)
+		if (!try_run(index))
+			std::this_thread::yield();
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t batch_size, const RangeJob_t& job)
+{
+	if (count == 0)
+		return;
+
+	batch_size = std::max(batch_size, 1u);
+
+	if (count <= batch_size || workers.empty())
+	{
+		job(0, count);
+		return;
+	}
+
+	JobCounter counter;
+
+	for (uint32_t begin = 0; begin < count; begin += batch_size)
+	{
+		const uint32_t end = std::min(begin + batch_size, count);
+		submit([&job, begin, end]() { job(begin, end); }, counter);
+	}
+
+	wait(counter);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <deque>
+#include <mutex>
+
+// Number of jobs still running for a group of submissions. wait() returns once it drops to zero.
+struct JobCounter
+{
+	std::atomic<uint32_t> pending{0};
+};
+
+// Fixed pool of worker threads, each with its own deque. Workers pop their own jobs LIFO and
+// steal FIFO from the others when they run dry. Threads that wait on a counter run jobs too.
+class JobSystem
+{
+public:
+	using Job_t = std::function<void()>;
+	using RangeJob_t = std::function<void(uint32_t begin, uint32_t end)>;
+
+	// 0 picks one worker per hardware thread, minus the calling thread.
+	explicit JobSystem(uint32_t worker_count = 0);
+	~JobSystem();
+
+	void submit(Job_t job, JobCounter& counter);
+	void wait(JobCounter& counter);
+
+	// Long-running work such as asset decoding. Only idle workers pick these up, never a thread
+	// helping out in wait(), so a frame waiting on its own jobs is not stalled behind them.
+	void submit_background(Job_t job, JobCounter& counter);
+
+	// Splits [0, count) into batches of batch_size and blocks until all of them have run.
+	void parallel_for(uint32_t count, uint32_t batch_size, const RangeJob_t& job);
+
+	uint32_t get_worker_count() const;
+
+private:
+	struct Job
+	{
+		Job_t function;
+		JobCounter* counter;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void worker_loop(uint32_t index);
+	bool pop(uint32_t index, Job& job);
+	bool try_run(uint32_t index);
+	bool try_run_background();
+	void run(Job& job);
+	// Of the calling thread in this pool, -1 if it isn't one of its workers.
+	int32_t get_worker_queue() const;
+	uint32_t get_queue_index() const;
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	Queue background_queue;
+	std::vector<std::thread> workers;
+
+	std::atomic<uint32_t> queued_jobs{0};
+	std::atomic<uint32_t> next_queue{0};
+	std::atomic<bool> running{true};
+
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+};
@@ -0,0 +1,57 @@
+#include "arena.h"
+
+#include <algorithm>
+
+Arena::Arena(size_t block_size) : block_size{block_size}
+{
+}
+
+Arena::~Arena() = default;
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+	for (;; current++, offset = 0)
+	{
+		if (current == blocks.size())
+		{
+			// Room for the worst case padding, so the allocation fits however the block is aligned.
+			const size_t new_size = std::max(block_size, size + alignment);
+			blocks.push_back({ std::make_unique<uint8_t[]>(new_size), new_size });
+		}
+
+		Block& block = blocks[current];
+
+		const uintptr_t address = reinterpret_cast<uintptr_t>(block.data.get()) + offset;
+		const size_t padding = (alignment - address % alignment) % alignment;
+
+		if (offset + padding + size <= block.size)
+		{
+			offset += padding + size;
+			used += size;
+
+			return reinterpret_cast<void*>(address + padding);
+		}
+	}
+}
+
+void Arena::reset()
+{
+	current = 0;
+	offset = 0;
+	used = 0;
+}
+
+size_t Arena::get_used() const
+{
+	return used;
+}
+
+size_t Arena::get_reserved() const
+{
+	size_t reserved = 0;
+
+	for (const Block& block : blocks)
+		reserved += block.size;
+
+	return reserved;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator: allocations bump an offset through blocks of block_size bytes (bigger ones get a block of their
+// own) and are never freed one by one. reset() makes everything reusable at once and keeps the blocks, so an arena
+// reset every frame serves per-frame scratch without going to the heap; destroying it returns all of it in one go,
+// e.g. the data of an imported asset. Objects in it aren't destroyed either, so keep to trivially destructible types
+// or containers with an ArenaAllocator. Not thread safe, give each thread its own.
+class Arena
+{
+public:
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 64 << 10;
+
+	explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+	~Arena();
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template <typename T>
+	T* allocate_array(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "Arena memory is released without destroying what's in it");
+
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// Everything allocated so far becomes invalid.
+	void reset();
+
+	// Bytes handed out since the last reset, and held from the heap.
+	size_t get_used() const;
+	size_t get_reserved() const;
+
+private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+		size_t size;
+	};
+
+	const size_t block_size;
+
+	std::vector<Block> blocks;
+	size_t current{0};
+	size_t offset{0};
+	size_t used{0};
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+};
+
+// Lets standard containers allocate from an Arena. Freeing is a no-op, the memory goes when the arena is reset or
+// destroyed, so it has to outlive the container. Without an arena it falls back to the heap.
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	// Containers take the allocator along when moved or assigned, so their memory always comes from where it was allocated.
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	ArenaAllocator() = default;
+
+	ArenaAllocator(Arena& arena) : arena{&arena}
+	{
+	}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena{other.arena}
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		if (!arena)
+			return static_cast<T*>(::operator new(sizeof(T) * count));
+
+		return static_cast<T*>(arena->allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	void deallocate(T* pointer, size_t)
+	{
+		if (!arena)
+			::operator delete(pointer);
+	}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const
+	{
+		return arena == other.arena;
+	}
+
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const
+	{
+		return arena != other.arena;
+	}
+
+	Arena* arena{nullptr};
+};
+
+template <typename T>
+using ArenaVector_t = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed-size slots for objects of one type, carved out of chunks of CHUNK_SIZE slots. Destroyed objects leave their
+// slot on a free list that create() takes from first, so objects coming and going over a long session reuse the
+// same memory instead of fragmenting the heap; chunks are only released with the pool. Addresses stay put.
+// Not thread safe; the pool has to outlive every Ptr_t it handed out.
+template <typename T, uint32_t CHUNK_SIZE = 64>
+class Pool
+{
+public:
+	struct Deleter
+	{
+		Pool* pool{nullptr};
+
+		void operator()(T* object) const
+		{
+			pool->destroy(object);
+		}
+	};
+
+	using Ptr_t = std::unique_ptr<T, Deleter>;
+
+	Pool() = default;
+
+	template <typename... Args>
+	Ptr_t create(Args&&... args)
+	{
+		if (!free_slots)
+			add_chunk();
+
+		Slot* slot = free_slots;
+		free_slots = slot->next;
+
+		T* object = new (slot->storage) T(std::forward<Args>(args)...);
+		live_count++;
+
+		return Ptr_t(object, Deleter{ this });
+	}
+
+	uint32_t get_live_count() const
+	{
+		return live_count;
+	}
+
+	uint32_t get_capacity() const
+	{
+		return chunks.size() * CHUNK_SIZE;
+	}
+
+private:
+	union Slot
+	{
+		Slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	void add_chunk()
+	{
+		chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+		Slot* chunk = chunks.back().get();
+
+		for (uint32_t i = 0; i < CHUNK_SIZE; i++)
+		{
+			chunk[i].next = free_slots;
+			free_slots = &chunk[i];
+		}
+	}
+
+	void destroy(T* object)
+	{
+		object->~T();
+
+		Slot* slot = reinterpret_cast<Slot*>(object);
+		slot->next = free_slots;
+		free_slots = slot;
+
+		live_count--;
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> chunks;
+	Slot* free_slots{nullptr};
+	uint32_t live_count{0};
+
+	Pool(const Pool&) = delete;
+	Pool& operator=(const Pool&) = delete;
+};
@@ -0,0 +1,376 @@
+#include "profiler.h"
+
+#include <imgui/imgui.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace profiler
+{
+	// Zones a thread can record between two begin_frame() calls before the oldest ones are overwritten.
+	static constexpr uint32_t RING_CAPACITY = 1 << 14;
+	static constexpr uint32_t FRAME_HISTORY = 240;
+
+	// Written by its own thread only; written is published with release so the reader sees complete zones.
+	struct ThreadBuffer
+	{
+		std::vector<Zone> ring = std::vector<Zone>(RING_CAPACITY);
+		std::atomic<uint64_t> written{0};
+
+		uint32_t index{0};
+		uint32_t depth{0};
+
+		// Main thread only.
+		uint64_t read{0};
+	};
+
+	static std::atomic<bool> enabled{true};
+
+	// Only taken when a thread records its first zone, by set_thread_name() and by begin_frame().
+	static std::mutex threads_mutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> threads;
+	static std::vector<std::string> thread_names;
+
+	static thread_local ThreadBuffer* local_buffer{nullptr};
+
+	// Main thread only.
+	static Frame last_frame;
+	static std::vector<std::string> frame_thread_names;
+	static std::vector<float> frame_times;
+
+	static float gpu_frame_ms{0.0f};
+	static std::vector<GpuZone> gpu_zones;
+
+	static bool capturing{false};
+	static uint64_t capture_begin{0};
+	static std::vector<Zone> captured_zones;
+
+	static ThreadBuffer& get_buffer()
+	{
+		if (!local_buffer)
+		{
+			const std::lock_guard<std::mutex> lock(threads_mutex);
+
+			ThreadBuffer& buffer = *threads.emplace_back(std::make_unique<ThreadBuffer>());
+			buffer.index = threads.size() - 1;
+			thread_names.push_back("Thread " + std::to_string(buffer.index));
+
+			local_buffer = &buffer;
+		}
+
+		return *local_buffer;
+	}
+
+	uint64_t get_time()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	ScopedZone::ScopedZone(const char* p_name) : name{nullptr}, begin{0}
+	{
+		if (!enabled.load(std::memory_order_relaxed))
+			return;
+
+		get_buffer().depth++;
+
+		name = p_name;
+		begin = get_time();
+	}
+
+	ScopedZone::~ScopedZone()
+	{
+		if (!name)
+			return;
+
+		const uint64_t end = get_time();
+
+		ThreadBuffer& buffer = *local_buffer;
+		buffer.depth--;
+
+		const uint64_t written = buffer.written.load(std::memory_order_relaxed);
+		buffer.ring[written % RING_CAPACITY] = { name, begin, end, buffer.depth, buffer.index };
+		buffer.written.store(written + 1, std::memory_order_release);
+	}
+
+	void set_enabled(bool p_enabled)
+	{
+		enabled = p_enabled;
+	}
+
+	bool is_enabled()
+	{
+		return enabled;
+	}
+
+	void set_thread_name(const std::string& name)
+	{
+		const uint32_t index = get_buffer().index;
+
+		const std::lock_guard<std::mutex> lock(threads_mutex);
+		thread_names[index] = name;
+	}
+
+	void begin_frame()
+	{
+		const uint64_t now = get_time();
+
+		Frame frame;
+		frame.begin = last_frame.end;
+		frame.end = now;
+
+		{
+			const std::lock_guard<std::mutex> lock(threads_mutex);
+
+			for (const std::unique_ptr<ThreadBuffer>& buffer : threads)
+			{
+				const uint64_t written = buffer->written.load(std::memory_order_acquire);
+
+				// A thread that got that far ahead has overwritten what wasn't read yet.
+				if (written - buffer->read > RING_CAPACITY)
+					buffer->read = written - RING_CAPACITY;
+
+				for (; buffer->read < written; buffer->read++)
+					frame.zones.push_back(buffer->ring[buffer->read % RING_CAPACITY]);
+			}
+
+			frame_thread_names = thread_names;
+		}
+
+		std::sort(frame.zones.begin(), frame.zones.end(), [](const Zone& a, const Zone& b) { return a.thread != b.thread ? a.thread < b.thread : a.begin < b.begin; });
+
+		if (capturing)
+			captured_zones.insert(captured_zones.end(), frame.zones.begin(), frame.zones.end());
+
+		// The very first call has no frame to close.
+		if (frame.begin != 0)
+		{
+			if (frame_times.size() == FRAME_HISTORY)
+				frame_times.erase(frame_times.begin());
+
+			frame_times.push_back((frame.end - frame.begin) / 1e6f);
+		}
+
+		last_frame = std::move(frame);
+	}
+
+	const Frame& get_last_frame()
+	{
+		return last_frame;
+	}
+
+	const std::vector<std::string>& get_thread_names()
+	{
+		return frame_thread_names;
+	}
+
+	const std::vector<float>& get_frame_times()
+	{
+		return frame_times;
+	}
+
+	void set_gpu_frame(float frame_ms, std::vector<GpuZone> zones)
+	{
+		gpu_frame_ms = frame_ms;
+		gpu_zones = std::move(zones);
+	}
+
+	void begin_capture()
+	{
+		captured_zones.clear();
+		capture_begin = get_time();
+		capturing = true;
+	}
+
+	bool is_capturing()
+	{
+		return capturing;
+	}
+
+	static void append_escaped(std::string& out, const std::string& text)
+	{
+		for (const char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+
+			out += c;
+		}
+	}
+
+	bool end_capture(const std::string& path)
+	{
+		if (!capturing)
+			return false;
+
+		capturing = false;
+
+		std::string trace = "{\"traceEvents\":[\n";
+
+		for (uint32_t i = 0; i < frame_thread_names.size(); i++)
+		{
+			trace += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" + std::to_string(i) + ",\"args\":{\"name\":\"";
+			append_escaped(trace, frame_thread_names[i]);
+			trace += "\"}},\n";
+		}
+
+		char timing[96];
+
+		for (const Zone& zone : captured_zones)
+		{
+			if (zone.begin < capture_begin)
+				continue;
+
+			// Complete events, timestamps in microseconds.
+			trace += "{\"name\":\"";
+			append_escaped(trace, zone.name);
+			std::snprintf(timing, sizeof(timing), "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", zone.thread, (zone.begin - capture_begin) / 1e3, (zone.end - zone.begin) / 1e3);
+			trace += timing;
+		}
+
+		// Metadata always comes first, so the list never ends on a dangling comma.
+		trace.resize(trace.size() - 2);
+		trace += "\n]}\n";
+
+		captured_zones.clear();
+
+		std::ofstream file(path, std::ios::binary);
+
+		if (!file.is_open())
+		{
+			spdlog::error("Failed to write trace {0}", path);
+			return false;
+		}
+
+		file << trace;
+
+		spdlog::info("Trace written to {0}", path);
+
+		return true;
+	}
+
+	static ImU32 get_zone_color(const char* name)
+	{
+		// Zones with the same name keep their color from frame to frame.
+		uint32_t hash = 2166136261u;
+
+		for (const char* c = name; *c; c++)
+			hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+
+		return IM_COL32(80 + hash % 150, 80 + (hash >> 8) % 150, 80 + (hash >> 16) % 150, 255);
+	}
+
+	static void draw_zone(ImDrawList& draw_list, const ImVec2& min, const ImVec2& max, const char* name, float duration_ms)
+	{
+		draw_list.AddRectFilled(min, max, get_zone_color(name));
+
+		// Names only go on zones wide enough to read them.
+		if (max.x - min.x > 40.0f)
+		{
+			draw_list.PushClipRect(min, max, true);
+			draw_list.AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), name);
+			draw_list.PopClipRect();
+		}
+
+		if (ImGui::IsMouseHoveringRect(min, max))
+			ImGui::SetTooltip("%s\n%.3f ms", name, duration_ms);
+	}
+
+	void draw_window()
+	{
+		static constexpr float ROW_HEIGHT = 18.0f;
+		static const char* CAPTURE_PATH = "profile.json";
+
+		ImGui::Begin("Profiler");
+
+			bool profiling = is_enabled();
+
+			if (ImGui::Checkbox("Enabled", &profiling))
+				set_enabled(profiling);
+
+			ImGui::SameLine();
+
+			if (!capturing && ImGui::Button("Capture trace"))
+				begin_capture();
+			else if (capturing && ImGui::Button("Save trace"))
+				end_capture(CAPTURE_PATH);
+
+			if (!frame_times.empty())
+			{
+				const float frame_time = frame_times.back();
+				const float longest = *std::max_element(frame_times.begin(), frame_times.end());
+
+				ImGui::Text("Frame %.2f ms, longest of the last %u %.2f ms, GPU %.2f ms", frame_time, static_cast<uint32_t>(frame_times.size()), longest, gpu_frame_ms);
+				ImGui::PlotLines("##frame_times", frame_times.data(), frame_times.size(), 0, nullptr, 0.0f, longest, ImVec2(-1.0f, 48.0f));
+			}
+
+			const Frame& frame = last_frame;
+			const float width = ImGui::GetContentRegionAvail().x;
+			const double scale = frame.end > frame.begin ? width / static_cast<double>(frame.end - frame.begin) : 0.0;
+
+			ImDrawList* draw_list = ImGui::GetWindowDrawList();
+
+			// One band per thread, nested zones stacked below their parents.
+			for (uint32_t first = 0; first < frame.zones.size();)
+			{
+				const uint32_t thread = frame.zones[first].thread;
+
+				uint32_t last = first;
+				uint32_t depth = 0;
+
+				for (; last < frame.zones.size() && frame.zones[last].thread == thread; last++)
+					depth = std::max(depth, frame.zones[last].depth);
+
+				ImGui::TextUnformatted(thread < frame_thread_names.size() ? frame_thread_names[thread].c_str() : "?");
+
+				const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+				for (uint32_t i = first; i < last; i++)
+				{
+					const Zone& zone = frame.zones[i];
+
+					const uint64_t begin = std::max(zone.begin, frame.begin);
+					const float x0 = origin.x + static_cast<float>((begin - frame.begin) * scale);
+					const float x1 = std::max(origin.x + static_cast<float>((zone.end - frame.begin) * scale), x0 + 1.0f);
+					const float y0 = origin.y + zone.depth * ROW_HEIGHT;
+
+					draw_zone(*draw_list, ImVec2(x0, y0), ImVec2(x1, y0 + ROW_HEIGHT - 1.0f), zone.name, (zone.end - zone.begin) / 1e6f);
+				}
+
+				ImGui::Dummy(ImVec2(width, (depth + 1) * ROW_HEIGHT));
+
+				first = last;
+			}
+
+			// GPU passes on the same scale, starting at the left edge.
+			if (!gpu_zones.empty())
+			{
+				ImGui::TextUnformatted("GPU");
+
+				const ImVec2 origin = ImGui::GetCursorScreenPos();
+				const double ms_scale = scale * 1e6;
+
+				uint32_t depth = 0;
+
+				for (const GpuZone& zone : gpu_zones)
+				{
+					const float x0 = origin.x + static_cast<float>(zone.start_ms * ms_scale);
+					const float x1 = std::max(origin.x + static_cast<float>((zone.start_ms + zone.duration_ms) * ms_scale), x0 + 1.0f);
+					const float y0 = origin.y + zone.depth * ROW_HEIGHT;
+
+					draw_zone(*draw_list, ImVec2(x0, y0), ImVec2(x1, y0 + ROW_HEIGHT - 1.0f), zone.name, zone.duration_ms);
+
+					depth = std::max(depth, zone.depth);
+				}
+
+				ImGui::Dummy(ImVec2(width, (depth + 1) * ROW_HEIGHT));
+			}
+
+		ImGui::End();
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Lightweight CPU instrumentation. PROFILE_ZONE("name") times the rest of its scope. Every thread writes
+// its zones into its own ring buffer without locking; the main thread gathers them once per frame in
+// begin_frame(). Without ANIMA_PROFILE the macro compiles to nothing; with it, set_enabled(false) reduces
+// a zone to a single branch.
+namespace profiler
+{
+	struct Zone
+	{
+		// Must outlive the profiler, in practice a string literal.
+		const char* name;
+
+		// Nanoseconds on the steady clock.
+		uint64_t begin;
+		uint64_t end;
+
+		// Nesting level on its thread, 0 for outermost zones.
+		uint32_t depth;
+		uint32_t thread;
+	};
+
+	struct Frame
+	{
+		uint64_t begin{0};
+		uint64_t end{0};
+
+		// Zones that ended during the frame, sorted by thread and then by begin.
+		std::vector<Zone> zones;
+	};
+
+	void set_enabled(bool enabled);
+	bool is_enabled();
+
+	// Shown in the timeline and in traces instead of the thread's index.
+	void set_thread_name(const std::string& name);
+
+	// Closes the current frame and gathers the zones recorded during it. Called once per frame on the main thread.
+	void begin_frame();
+
+	const Frame& get_last_frame();
+	const std::vector<std::string>& get_thread_names();
+
+	// Duration of recent frames in milliseconds, oldest first.
+	const std::vector<float>& get_frame_times();
+
+	// Zones recorded between the two calls are kept and written in the Chrome trace event format, for
+	// chrome://tracing, Perfetto or Speedscope.
+	void begin_capture();
+	bool end_capture(const std::string& path);
+	bool is_capturing();
+
+	// GPU passes, e.g. from GpuTimer, shown as their own band in the timeline. They usually lag a frame or two behind.
+	struct GpuZone
+	{
+		const char* name;
+
+		// Since the start of the GPU frame.
+		float start_ms;
+		float duration_ms;
+
+		uint32_t depth;
+	};
+
+	void set_gpu_frame(float frame_ms, std::vector<GpuZone> zones);
+
+	// Frame times and a per-thread timeline of the last frame.
+	void draw_window();
+
+	uint64_t get_time();
+
+	class ScopedZone
+	{
+	public:
+		explicit ScopedZone(const char* name);
+		~ScopedZone();
+
+	private:
+		const char* name;
+		uint64_t begin;
+
+		ScopedZone(const ScopedZone&) = delete;
+		ScopedZone& operator=(const ScopedZone&) = delete;
+	};
+}
+
+#ifdef ANIMA_PROFILE
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) const profiler::ScopedZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
@@ -1,15 +1,19 @@
 #include "window.h"
 
-Win::Win()
+#include "../profiler/profiler.h"
+
+Win::Win(const WindowSettings& settings)
 {
 	glfwInit();
 	glfwDefaultWindowHints();
 	glfwWindowHint(GLFW_SAMPLES, 4);
+	glfwWindowHint(GLFW_VISIBLE, settings.visible ? GLFW_TRUE : GLFW_FALSE);
+	glfwWindowHint(GLFW_RESIZABLE, settings.resizable ? GLFW_TRUE : GLFW_FALSE);
 
-	handle = glfwCreateWindow(640, 480, "Anima", nullptr, nullptr);
+	handle = glfwCreateWindow(settings.width, settings.height, "Anima", nullptr, nullptr);
 	glfwMakeContextCurrent(handle);
 	//glfwMaximizeWindow(handle);
-    glfwSwapInterval(1);
+	glfwSwapInterval(settings.vsync ? 1 : 0);
 
 	glewInit();
 	glEnable(GL_DEPTH_TEST);
@@ -34,6 +38,9 @@ void Win::poll_events() const
 
 void Win::swap_buffers() const
 {
+	// Includes waiting for vsync and for the driver to catch up.
+	PROFILE_ZONE("Swap buffers");
+
 	glfwSwapBuffers(handle);
 }
 
@@ -7,10 +7,27 @@
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 
+#include <stdint.h>
+
+struct WindowSettings
+{
+	uint32_t width{640};
+	uint32_t height{480};
+
+	// Off for benchmarks, so frames aren't capped at the refresh rate.
+	bool vsync{true};
+
+	// A hidden window still has a default framebuffer to render into, for runs without a display in view.
+	bool visible{true};
+
+	// Fixed size windows keep the resolution of a benchmark from changing under it.
+	bool resizable{true};
+};
+
 class Win
 {
 public:
-	Win();
+	Win(const WindowSettings& settings = {});
 	~Win();
 
 	GLFWwindow* get_handle();
@@ -0,0 +1,64 @@
+#include "file_data.h"
+#include "mapped_file.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+namespace files
+{
+	std::shared_ptr<FileData> FileData::load(const std::string& path)
+	{
+		std::error_code error;
+		const uintmax_t file_size = std::filesystem::file_size(path, error);
+
+		if (error)
+		{
+			spdlog::error("Failed to read {0}: {1}", path, error.message());
+			return nullptr;
+		}
+
+		std::shared_ptr<FileData> file = std::make_shared<FileData>();
+		file->size = static_cast<size_t>(file_size);
+
+		if (file->size == 0)
+			return file;
+
+		if (file->size >= MAP_THRESHOLD)
+		{
+			file->mapping = std::make_unique<MappedFile>(path);
+
+			// MappedFile has logged why.
+			return file->mapping->is_open() ? file : nullptr;
+		}
+
+		std::ifstream stream(path, std::ios::binary);
+		file->buffer.resize((file->size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+
+		if (!stream.read(reinterpret_cast<char*>(file->buffer.data()), file->size))
+		{
+			spdlog::error("Failed to read {0}: got {1} of {2} bytes", path, stream.gcount(), file->size);
+			return nullptr;
+		}
+
+		return file;
+	}
+
+	FileData::~FileData() = default;
+
+	const uint8_t* FileData::get_data() const
+	{
+		return mapping ? mapping->get_data() : reinterpret_cast<const uint8_t*>(buffer.data());
+	}
+
+	size_t FileData::get_size() const
+	{
+		return size;
+	}
+
+	bool FileData::is_mapped() const
+	{
+		return mapping != nullptr;
+	}
+}
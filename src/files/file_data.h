@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace files
+{
+	class MappedFile;
+
+	// A whole file as one read-only range of bytes, exactly as stored. Files from MAP_THRESHOLD up are memory mapped,
+	// so only the pages touched are read and data can go to the GPU straight from the mapping; smaller ones are read
+	// into a buffer sized up front, which is cheaper than setting up a mapping. Either way the data starts on an
+	// alignof(std::max_align_t) boundary.
+	class FileData
+	{
+	public:
+		static constexpr size_t MAP_THRESHOLD = 256 << 10;
+
+		// Null, with the reason logged, if the file can't be opened or read.
+		static std::shared_ptr<FileData> load(const std::string& path);
+
+		FileData() = default;
+		~FileData();
+
+		const uint8_t* get_data() const;
+		size_t get_size() const;
+
+		bool is_mapped() const;
+
+	private:
+		std::unique_ptr<MappedFile> mapping;
+		std::vector<std::max_align_t> buffer;
+		size_t size{0};
+
+		FileData(const FileData&) = delete;
+		FileData& operator=(const FileData&) = delete;
+	};
+}
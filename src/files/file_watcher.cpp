@@ -0,0 +1,128 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+
+FileWatcher::FileWatcher(float interval) : interval{interval}
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	stop();
+}
+
+void FileWatcher::watch(const std::string& path)
+{
+	roots.push_back(path);
+}
+
+void FileWatcher::start()
+{
+	if (thread.joinable())
+		return;
+
+	// What is there now is the baseline, only edits from here on are changes.
+	entries.clear();
+	scan(false);
+
+	running = true;
+	thread = std::thread(&FileWatcher::run, this);
+}
+
+void FileWatcher::stop()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+
+	wake.notify_all();
+
+	if (thread.joinable())
+		thread.join();
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+	std::vector<std::string> result;
+
+	const std::lock_guard<std::mutex> lock(mutex);
+	result.swap(changes);
+
+	return result;
+}
+
+std::string FileWatcher::get_key(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+void FileWatcher::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (running)
+	{
+		if (wake.wait_for(lock, std::chrono::duration<float>(interval), [this]() { return !running; }))
+			break;
+
+		lock.unlock();
+		scan(true);
+		lock.lock();
+	}
+}
+
+void FileWatcher::scan(bool report)
+{
+	scanned.clear();
+
+	for (const std::string& root : roots)
+		visit(root, report);
+
+	// Whatever wasn't seen again has been removed.
+	entries.swap(scanned);
+}
+
+void FileWatcher::visit(const std::filesystem::path& path, bool report)
+{
+	// Files come and go while this runs, errors only mean skipping them until the next scan.
+	std::error_code error;
+
+	if (std::filesystem::is_directory(path, error))
+	{
+		for (std::filesystem::directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+			visit(it->path(), report);
+
+		return;
+	}
+
+	Entry entry;
+	entry.time = std::filesystem::last_write_time(path, error);
+
+	if (error)
+		return;
+
+	entry.size = std::filesystem::file_size(path, error);
+
+	if (error)
+		return;
+
+	const std::string key = get_key(path.string());
+	const auto previous = entries.find(key);
+
+	if (previous == entries.end() || previous->second.time != entry.time || previous->second.size != entry.size)
+	{
+		// Reported by the next scan that finds it unchanged.
+		entry.settling = report;
+	}
+	else if (previous->second.settling)
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+
+		if (std::find(changes.begin(), changes.end(), key) == changes.end())
+			changes.push_back(key);
+	}
+
+	scanned[key] = entry;
+}
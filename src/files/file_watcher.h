@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reports files that changed on disk, for hot reloading. A background thread polls the modification times and sizes
+// of everything under the watched paths every interval; a change is only reported once the file has held still for
+// a poll, so an editor saving in several writes triggers one reload of the finished file. Files appearing count as
+// changed, removed ones are just forgotten.
+class FileWatcher
+{
+public:
+	static constexpr float DEFAULT_INTERVAL = 0.2f;
+
+	explicit FileWatcher(float interval = DEFAULT_INTERVAL);
+	~FileWatcher();
+
+	// A file, or a directory watched with everything below it. Before start().
+	void watch(const std::string& path);
+
+	void start();
+	void stop();
+
+	// Paths changed since the last call, lexically normal and with forward slashes; see get_key().
+	std::vector<std::string> poll();
+
+	// How poll() spells path, to compare against.
+	static std::string get_key(const std::string& path);
+
+private:
+	struct Entry
+	{
+		std::filesystem::file_time_type time;
+		uintmax_t size{0};
+		bool settling{false};
+	};
+
+	void run();
+	void scan(bool report);
+	void visit(const std::filesystem::path& path, bool report);
+
+	const float interval;
+
+	std::vector<std::string> roots;
+
+	// Watcher thread only.
+	std::map<std::string, Entry> entries;
+	std::map<std::string, Entry> scanned;
+
+	std::thread thread;
+	bool running{false};
+
+	// Guards running and changes.
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::vector<std::string> changes;
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+};
@@ -1,6 +1,8 @@
 #include "files.h"
 
+#include <algorithm>
 #include <fstream>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
@@ -29,23 +31,121 @@ namespace files
 		return path.substr(point_index + 1, path.size());
 	}
 
-	std::string read(const std::string& path)
+	// Text mode, so line endings come back as they were written on this platform. One read into a string sized
+	// for the file, the conversion can only make it shorter.
+	static bool read_text(const std::string& path, std::string& text)
 	{
-		std::string fff;
-
 		std::ifstream file(path);
 
 		if (!file.is_open())
+			return false;
+
+		std::error_code error;
+		const uintmax_t size = std::filesystem::file_size(path, error);
+
+		if (error)
+			return false;
+
+		text.resize(static_cast<size_t>(size));
+		file.read(&text[0], text.size());
+		text.resize(static_cast<size_t>(file.gcount()));
+
+		return !file.bad();
+	}
+
+	bool read(const std::string& path, std::string& text)
+	{
+		if (!read_text(path, text))
 		{
-			spdlog::error("Failed to open file: {0}", path);
+			spdlog::error("Failed to read file: {0}", path);
+			return false;
 		}
 
-		for( std::string line; std::getline( file, line ); )
+		// The last line gets its newline too.
+		if (!text.empty() && text.back() != '\n')
+			text += '\n';
+
+		return true;
+	}
+
+	std::string read(const std::string& path)
+	{
+		std::string text;
+		read(path, text);
+
+		return text;
+	}
+
+	// Inlines the lines #include "name" of a shader, name relative to the including file. Every file goes in once per
+	// shader, which also breaks include cycles. Files are numbered in the order they're first included, the shader
+	// itself being 0, and #line directives with that source string number keep compiler messages pointing at the
+	// right line of the right file: "2(14)" is line 14 of the file the comment above "#line 1 2" names.
+	static bool expand_includes(const std::filesystem::path& path, std::vector<std::string>& sources, std::string& out)
+	{
+		const uint32_t source = sources.size();
+		sources.push_back(std::filesystem::weakly_canonical(path).string());
+
+		std::string content;
+
+		if (!read(path.string(), content))
+			return false;
+
+		if (source > 0)
+			out += "// " + std::to_string(source) + ": " + path.filename().string() + "\n#line 1 " + std::to_string(source) + "\n";
+
+		uint32_t line_number = 0;
+
+		for (size_t begin = 0; begin < content.size();)
 		{
-			fff.append(line + "\n");
+			const size_t end = content.find('\n', begin);
+			const std::string line = content.substr(begin, end - begin);
+
+			begin = end + 1;
+			line_number++;
+
+			const size_t directive = line.find_first_not_of(" \t");
+
+			if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+			{
+				out += line;
+				out += '\n';
+				continue;
+			}
+
+			const size_t name_begin = line.find('"', directive);
+			const size_t name_end = name_begin == std::string::npos ? std::string::npos : line.find('"', name_begin + 1);
+
+			if (name_end == std::string::npos)
+			{
+				spdlog::error("{0}:{1}: expected #include \"file\"", path.string(), line_number);
+				return false;
+			}
+
+			const std::filesystem::path include_path = path.parent_path() / line.substr(name_begin + 1, name_end - name_begin - 1);
+
+			if (!std::filesystem::exists(include_path))
+			{
+				spdlog::error("{0}:{1}: {2} not found", path.string(), line_number, include_path.string());
+				return false;
+			}
+
+			const std::string canonical = std::filesystem::weakly_canonical(include_path).string();
+
+			// An include that was already expanded drops its line, the #line below makes up for it as well.
+			if (std::find(sources.begin(), sources.end(), canonical) == sources.end() && !expand_includes(include_path, sources, out))
+				return false;
+
+			out += "#line " + std::to_string(line_number + 1) + " " + std::to_string(source) + "\n";
 		}
 
-		return fff;
+		return true;
+	}
+
+	bool expand_includes(const std::string& path, std::string& out)
+	{
+		std::vector<std::string> sources;
+
+		return expand_includes(std::filesystem::path(path), sources, out);
 	}
 
 	static std::string path_to_var_name(const std::string& path)
@@ -74,22 +174,48 @@ namespace files
 		return var_name;
 	}
 
+	std::string make_header(const std::string& path, const std::string& data)
+	{
+		std::string header;
+		header.reserve(data.size() + 128);
+
+		header += "#include <vector> \n";
+		header += "#include <string> \n";
+		header += "inline static const std::string ";
+		header += path_to_var_name(path);
+		header += " = R\"\"\"\"( \n";
+
+		header += data;
+
+		header += "\n)\"\"\"\";";
+
+		return header;
+	}
+
 	void write(const std::string& path, const std::string& data)
 	{
 		std::ofstream file;
 		file.open(path);
 
-		const std::string var_name = path_to_var_name(path);
+		file << make_header(path, data);
+		file.close();
+	}
+
+	bool write_if_changed(const std::string& path, const std::string& data)
+	{
+		const std::string header = make_header(path, data);
 
-		file << "#include <vector> \n";
-		file << "#include <string> \n";
-		file << "inline static const std::string ";
-		file << var_name;
-		file << " = R\"\"\"\"( \n";
+		std::string existing;
 
-		file << data;
+		if (read_text(path, existing) && existing == header)
+			return false;
 
-		file << "\n)\"\"\"\";";
+		std::ofstream file;
+		file.open(path);
+
+		file << header;
 		file.close();
+
+		return true;
 	}
 }
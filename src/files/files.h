@@ -16,7 +16,23 @@ namespace files
 
 	std::string get_type(const std::string& path);
 
+	// Whole text file, every line ending in a newline. False, with the reason logged, if it can't be read.
+	// Binary data goes through FileData instead, which doesn't touch line endings.
+	bool read(const std::string& path, std::string& text);
+
+	// read() for files that are expected to be there; an empty string if they aren't.
 	std::string read(const std::string& path);
 
+	// Appends the text of a shader to out with every line #include "name" replaced by that file, name relative to
+	// the including file. False, with the error logged, when an include is malformed or missing.
+	bool expand_includes(const std::string& path, std::string& out);
+
+	// Source of a header that embeds data as an inline std::string named after the file, what write() puts in path.
+	std::string make_header(const std::string& path, const std::string& data);
+
 	void write(const std::string& path, const std::string& data);
+
+	// Like write(), but leaves the file and its timestamp alone when it already holds this header,
+	// so nothing including it is rebuilt. Returns whether the file was written.
+	bool write_if_changed(const std::string& path, const std::string& data);
 }
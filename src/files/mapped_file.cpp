@@ -0,0 +1,125 @@
+#include "mapped_file.h"
+
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace files
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& path)
+	{
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			spdlog::error("Failed to open file: {0}", path);
+			return;
+		}
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (!mapping)
+		{
+			spdlog::error("Failed to map file: {0}", path);
+			CloseHandle(file);
+			return;
+		}
+
+		data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (!data)
+		{
+			spdlog::error("Failed to map file: {0}", path);
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return;
+		}
+
+		size = static_cast<size_t>(file_size.QuadPart);
+		file_handle = file;
+		mapping_handle = mapping;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (data)
+			UnmapViewOfFile(data);
+
+		if (mapping_handle)
+			CloseHandle(mapping_handle);
+
+		if (file_handle)
+			CloseHandle(file_handle);
+	}
+#else
+	MappedFile::MappedFile(const std::string& path)
+	{
+		const int file = open(path.c_str(), O_RDONLY);
+
+		if (file < 0)
+		{
+			spdlog::error("Failed to open file: {0}", path);
+			return;
+		}
+
+		struct stat file_stat;
+		if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+		{
+			close(file);
+			return;
+		}
+
+		void* mapping = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+		// The mapping stays valid after the descriptor is closed.
+		close(file);
+
+		if (mapping == MAP_FAILED)
+		{
+			spdlog::error("Failed to map file: {0}", path);
+			return;
+		}
+
+		data = static_cast<const uint8_t*>(mapping);
+		size = static_cast<size_t>(file_stat.st_size);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (data)
+			munmap(const_cast<uint8_t*>(data), size);
+	}
+#endif
+
+	bool MappedFile::is_open() const
+	{
+		return data != nullptr;
+	}
+
+	const uint8_t* MappedFile::get_data() const
+	{
+		return data;
+	}
+
+	size_t MappedFile::get_size() const
+	{
+		return size;
+	}
+}
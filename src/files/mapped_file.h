@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace files
+{
+	// Read-only view of a whole file mapped into memory. Pages are loaded by the OS on first touch,
+	// so opening is cheap and data can be handed to the GPU straight from the mapping.
+	class MappedFile
+	{
+	public:
+		MappedFile(const std::string& path);
+		~MappedFile();
+
+		bool is_open() const;
+
+		const uint8_t* get_data() const;
+		size_t get_size() const;
+
+	private:
+		const uint8_t* data{nullptr};
+		size_t size{0};
+
+#ifdef _WIN32
+		void* file_handle{nullptr};
+		void* mapping_handle{nullptr};
+#endif
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+	};
+}
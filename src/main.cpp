@@ -3,100 +3,869 @@
 #include "xyapi/common.h"
 #include "xyapi/gl/texture.h"
 #include "xyapi/gl/shader.h"
+#include "xyapi/gl/shader_variants.h"
 #include "xyapi/gl/vao.h"
+#include "xyapi/gl/gl_state.h"
+#include "xyapi/gl/gl_stats.h"
+#include "xyapi/gl/gpu_timer.h"
+#include "xyapi/gl/program_cache.h"
 
 #include "common.h"
 
-#include "shaders/default.vert.h"
-#include "shaders/default.frag.h"
+#include "shaders/skinned_instanced.vert.h"
+#include "shaders/skinned_vertices.vert.h"
+#include "shaders/skinned_array.frag.h"
+#include "shaders/skinned_bindless.frag.h"
 
 #include "assets/model.h"
-#include "assets/image.h"
+#include "assets/mesh_lods.h"
+#include "assets/mesh_optimizer.h"
+#include "assets/packed_vertex.h"
+#include "assets/asset_pack.h"
+#include "assets/asset_streamer.h"
+
+#include "animation/animation_world.h"
+#include "animation/simulation_thread.h"
+#include "animation/clip_bounds.h"
+#include "animation/dual_quaternion.h"
+#include "core/jobs/job_system.h"
+#include "core/profiler/profiler.h"
+#include "core/benchmark/benchmark.h"
+#include "files/files.h"
+#include "files/file_watcher.h"
+
+#include "render/palette_buffer.h"
+#include "render/instance_data.h"
+#include "render/skinning_pass.h"
+#include "render/sampler_cache.h"
+#include "render/skin_set.h"
+#include "render/mesh_buffer.h"
+#include "render/render_queue.h"
+#include "render/command_buffer.h"
+#include "render/command_executor.h"
+#include "render/frustum.h"
+#include "render/pose_cache.h"
+#include "render/skinned_features.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+
+// Benchmarks pick their own crowd size, see BenchmarkSettings.
+static constexpr uint32_t CROWD_COLUMNS = 4;
+static constexpr uint32_t CROWD_ROWS = 4;
+static constexpr uint32_t CROWD_SIZE = CROWD_COLUMNS * CROWD_ROWS;
+
+// Rows behind the crowd that only loop their clip, played from baked palettes instead of avatars.
+static constexpr uint32_t BACKGROUND_ROWS = 8;
+
+static const std::string MODEL_PATH = "assets/models/1.fbx";
+static const std::string ASSET_PACK_PATH = "assets/baked/1.pack";
+static const std::string TEXTURE_PATH = "assets/textures/1.png";
+
+// Where --hot-reload reads the shaders from when they're edited, relative to the working directory like the assets.
+static const std::string SHADER_SOURCE_PATH = "src/shaders";
+
+// Linked programs from earlier runs, see program_cache.
+static const std::string PROGRAM_CACHE_PATH = "cache/programs";
+
+// Layers reserved in the skin array, or handles when skins are bindless.
+static constexpr uint32_t SKIN_CAPACITY = 8;
+
+// Room in the megabuffers shared by all meshes drawn through the render queue.
+static constexpr uint32_t MESH_VERTEX_CAPACITY = 1 << 20;
+static constexpr uint32_t MESH_INDEX_CAPACITY = 1 << 22;
+static constexpr uint32_t MESH_INSTANCE_CAPACITY = 1 << 12;
+
+// Animation runs on its own thread at a fixed rate, the render thread blends its two latest snapshots.
+static constexpr float SIMULATION_STEP = 1.0f / 60.0f;
+
+// Clips play this much faster than real time, as 0.2 s per frame at 60 Hz used to.
+static constexpr float PLAYBACK_SPEED = 12.0f;
+
+// Degrees per second the crowd turns.
+static constexpr float CROWD_TURN_RATE = 20.0f;
+
+// Render thread time per frame spent on streaming uploads.
+static constexpr float UPLOAD_BUDGET_MS = 2.0f;
+
+// Vertical, in degrees.
+static constexpr float FIELD_OF_VIEW = 70.0f;
+
+// Instances a single job culls, picks the level of and records draws for.
+static constexpr uint32_t DRAW_BATCH_SIZE = 256;
+
+// Projected height, as a share of the viewport, below which the crowd switches to the next level of detail.
+static const std::vector<float> LOD_SCREEN_HEIGHTS = { 0.25f, 0.12f, 0.05f };
+
+// Palette variant of each crowd level's materials, levels past the end use matrices. skinned_features::DualQuaternions
+// skins a level with dual quaternions, which keeps joints from collapsing but drops bone scale; the background rows
+// always use the matrices of their PoseCache. Only the formats some level reads are uploaded, so with every level on
+// dual quaternions no matrix palettes go up at all.
+static constexpr uint32_t CROWD_LOD_PALETTE_FEATURES[] = { skinned_features::DualQuaternions, skinned_features::DualQuaternions, skinned_features::DualQuaternions, skinned_features::DualQuaternions };
+
+// One level of detail of the crowd mesh, see mesh_lods. Vertex and index data point into the mapped pack
+// or, when the FBX had to be imported, into the vectors below.
+struct CrowdLod
+{
+	std::vector<PackedVertex> packed_vertices;
+	std::vector<uint8_t> indices;
+
+	const PackedVertex* vertex_data{nullptr};
+	uint32_t vertex_count{0};
+
+	// 16-bit wherever the vertex count allows, see mesh_optimizer::get_index_size().
+	const void* index_data{nullptr};
+	uint32_t index_count{0};
+	uint32_t index_size{sizeof(uint32_t)};
+
+	// Picks the skinning variants, see skinned_features.
+	uint32_t max_influences{4};
+};
+
+// CPU side of the crowd, decoded on a worker.
+struct CrowdAsset
+{
+	RigPtr_t rig;
+	BakedAnimationPtr_t clip;
+	QuantizationBounds bounds;
+
+	std::shared_ptr<AssetPack> pack;
+
+	// Level 0 is the full mesh.
+	std::vector<CrowdLod> lods;
+
+	// Mesh space box around every frame of the clip, for culling.
+	Aabb clip_bounds;
+};
+
+// What a level of detail of the crowd is drawn with.
+struct CrowdLodDraw
+{
+	uint32_t mesh;
+	uint32_t crowd_material;
+	uint32_t background_material;
+};
+
+// Levels get coarser as the box shrinks on screen. One that couldn't be loaded is stood in for by the next coarser
+// loaded level, or the next finer one if there is none; at least one level has to be loaded.
+static uint32_t select_lod(const Aabb& box, const glm::vec3& camera_position, float tan_half_fov, const std::vector<CrowdLodDraw>& lods)
+{
+	const float distance = std::max(glm::distance(box.get_center(), camera_position), 0.001f);
+	const float screen_height = glm::length(box.get_extent()) / (distance * tan_half_fov);
+
+	uint32_t lod = 0;
+
+	while (lod + 1 < lods.size() && lod < LOD_SCREEN_HEIGHTS.size() && screen_height < LOD_SCREEN_HEIGHTS[lod])
+		lod++;
+
+	for (uint32_t coarser = lod; coarser < lods.size(); coarser++)
+	{
+		if (lods[coarser].mesh != UINT32_MAX)
+			return coarser;
+	}
+
+	while (lods[lod].mesh == UINT32_MAX)
+		lod--;
+
+	return lod;
+}
+
+// Everything derived from the mesh and the clip, however they were loaded.
+static void analyze(CrowdAsset& asset)
+{
+	for (CrowdLod& lod : asset.lods)
+		lod.max_influences = skinned_features::get_max_influences(lod.vertex_data, lod.vertex_count);
+
+	// The full mesh bounds the simplified ones too.
+	const CrowdLod& mesh = asset.lods[0];
+	const std::vector<Aabb> bone_bounds = clip_bounds::compute_bone_bounds(mesh.vertex_data, mesh.vertex_count, asset.bounds, asset.rig->get_amount_of_bones());
+	asset.clip_bounds = clip_bounds::compute_clip_bounds(asset.rig, *asset.clip, AnimationBinding(asset.rig->skeleton, *asset.clip), bone_bounds);
+}
+
+static std::shared_ptr<CrowdAsset> load_crowd_asset(JobSystem& job_system)
+{
+	std::shared_ptr<CrowdAsset> asset = std::make_shared<CrowdAsset>();
+
+	// The baked pack (see bake_assets) is mapped and uploaded in place; the FBX is only imported when it's missing.
+	if (std::filesystem::exists(ASSET_PACK_PATH))
+	{
+		asset->pack = std::make_shared<AssetPack>(ASSET_PACK_PATH);
+
+		if (asset->pack->is_loaded() && asset->pack->get_clip_count() > 0)
+		{
+			asset->rig = asset->pack->create_rig();
+			asset->clip = asset->pack->create_clip(0);
+			asset->bounds = asset->pack->get_vertex_bounds();
+
+			asset->lods.resize(asset->pack->get_lod_count());
+
+			for (uint32_t i = 0; i < asset->lods.size(); i++)
+			{
+				CrowdLod& lod = asset->lods[i];
+
+				lod.vertex_data = asset->pack->get_vertices(i);
+				lod.vertex_count = asset->pack->get_vertex_count(i);
+				lod.index_data = asset->pack->get_indices(i);
+				lod.index_count = asset->pack->get_index_count(i);
+				lod.index_size = asset->pack->get_index_size(i);
+			}
+		}
+	}
+
+	if (asset->rig && asset->clip && !asset->lods.empty())
+	{
+		analyze(*asset);
+		return asset;
+	}
+
+	Model model(MODEL_PATH, &job_system);
+
+	if (model.animations.empty())
+	{
+		spdlog::error("No animation to play in {0}", MODEL_PATH);
+		return nullptr;
+	}
+
+	const std::vector<Mesh> meshes = mesh_lods::generate(model.merge_meshes());
+
+	asset->pack.reset();
+	asset->rig = std::make_shared<Rig>(model.bone_map, model.skeleton);
+	asset->clip = std::make_shared<BakedAnimation>(model.animations[0]);
+	asset->bounds = QuantizationBounds::from_vertices(meshes[0].vertices);
+
+	asset->lods.resize(meshes.size());
+
+	// Every level in one index buffer, at the size the full mesh needs.
+	const uint32_t index_size = mesh_optimizer::get_index_size(meshes[0].vertices.size());
+
+	for (uint32_t i = 0; i < meshes.size(); i++)
+	{
+		const Mesh& mesh = meshes[i];
+		CrowdLod& lod = asset->lods[i];
+
+		lod.packed_vertices = pack_vertices(mesh.vertices, asset->bounds, &job_system);
+		lod.index_size = index_size;
+		lod.indices = mesh_optimizer::pack_indices(mesh.indices, index_size);
+
+		lod.vertex_data = lod.packed_vertices.data();
+		lod.vertex_count = lod.packed_vertices.size();
+		lod.index_data = lod.indices.data();
+		lod.index_count = mesh.indices.size();
+	}
+
+	analyze(*asset);
+
+	return asset;
+}
+
+// The shaders main builds, read from SHADER_SOURCE_PATH instead of the copies embedded at build time.
+struct ShaderSources
+{
+	std::string skinned_instanced_vert;
+	std::string skinned_vertices_vert;
+	std::string skinned_frag;
+	std::string skinning_comp;
+};
+
+static std::shared_ptr<ShaderSources> load_shader_sources(SkinSet::Mode skin_mode)
+{
+	const auto load = [](const std::string& name, std::string& out) { return files::expand_includes(SHADER_SOURCE_PATH + "/" + name, out); };
+
+	std::shared_ptr<ShaderSources> sources = std::make_shared<ShaderSources>();
+
+	const bool loaded =
+		load("skinned_instanced.vert", sources->skinned_instanced_vert) &&
+		load("skinned_vertices.vert", sources->skinned_vertices_vert) &&
+		load(skin_mode == SkinSet::Mode::Bindless ? "skinned_bindless.frag" : "skinned_array.frag", sources->skinned_frag) &&
+		load("skinning.comp", sources->skinning_comp);
+
+	return loaded ? sources : nullptr;
+}
+
+// Circles the whole grid (crowd and background rows, depth units deep and width wide) while looking at its center,
+// moving closer and further and up and down on the way, so culling, LOD levels and overdraw all change during a run.
+static glm::mat4 get_benchmark_view(float progress, float width, float depth, glm::vec3& position)
+{
+	const glm::vec3 center(0.0f, -2.0f, -5.0f - depth * 0.5f);
+	const float angle = progress * glm::two_pi<float>();
+	const float radius = (std::max(width, depth) * 0.5f + 6.0f) * (0.75f + 0.25f * std::cos(angle * 2.0f));
+
+	position = center + glm::vec3(std::sin(angle) * radius, 3.0f + 2.0f * std::sin(angle * 3.0f), std::cos(angle) * radius);
 
-static glm::mat4 model_matrix;
+	return glm::lookAt(position, center, glm::vec3(0, 1, 0));
+}
 
-#ifndef COMPILE_SHADERS
+#if !defined(COMPILE_SHADERS) && !defined(BAKE_ASSETS) && !defined(BENCH_ANIMATION)
 int main(int argc, char* argv[])
 {
 	arguments(argc, argv);
 
+	// anima --benchmark runs a scripted camera for a fixed time at a fixed resolution and writes a report.
+	const BenchmarkSettings benchmark_settings = BenchmarkSettings::from_arguments(get_arguments());
+	Benchmark benchmark(benchmark_settings);
+
+	// anima --hot-reload, from the root of the source tree, picks up edits to the shaders and the skin while it runs.
+	const std::vector<std::string>& args = get_arguments();
+	const bool hot_reload = std::find(args.begin(), args.end(), "--hot-reload") != args.end();
+
+	WindowSettings window_settings;
+
+	if (benchmark_settings.enabled)
+	{
+		window_settings.width = benchmark_settings.width;
+		window_settings.height = benchmark_settings.height;
+		window_settings.vsync = false;
+		window_settings.visible = !benchmark_settings.offscreen;
+		window_settings.resizable = false;
+	}
+
 	Win** window_pp = global::get_window_pp();
-	*window_pp = new Win();
+	*window_pp = new Win(window_settings);
 	Win& window = **window_pp;
 
 	global::gui::init();
 
-	Shader shader(default_vert, default_frag, { "u_model", "u_proj" });
+	profiler::set_thread_name("Main");
 
-	Avatar avatar;
-	VAO vao;
+	// Skins become bindless handles where the driver allows it and layers of one texture array otherwise.
+	// Per-instance skin indices select from either, so skins don't split draws.
+	const SkinSet::Mode skin_mode = SkinSet::is_bindless_supported() ? SkinSet::Mode::Bindless : SkinSet::Mode::Array;
+	const std::string& skinned_frag = skin_mode == SkinSet::Mode::Bindless ? skinned_bindless_frag : skinned_array_frag;
 
-	// Load model
-	{
-		Model model("assets/models/1.fbx");
+	program_cache::set_directory(PROGRAM_CACHE_PATH);
 
-		avatar.init(model.bone_map, model.skeleton);
+	// Shaders are created before they're needed, so drivers with parallel compiles build them at the same time
+	// while the assets stream in; each one only waits for its build when it's first used. The skinned variants
+	// depend on the mesh and are built as soon as it's decoded, all of them in one go.
+	ShaderVariants skinned_shaders(skinned_instanced_vert, skinned_frag, skinned_features::get_defines());
 
-		vao.bind();
-			vao.add_vbo(VBO::Type::Array, VBO::Usage::Static, model.vertices.size(), sizeof(Vertex), &model.vertices[0], Vertex::GetLayout());
-			vao.add_vbo(VBO::Type::Indices, VBO::Usage::Static, model.indices.size(), sizeof(uint32_t), &model.indices[0]);
-	}
+	// Skin once per frame in a compute pass where available, otherwise in the vertex shader.
+	ShaderVariants skinned_vertices_shaders(skinned_vertices_vert, skinned_frag, {});
+
+	if (SkinningPass::is_supported())
+		skinned_vertices_shaders.get(0);
+
+	JobSystem job_system;
+	AnimationWorld animation_world(job_system);
+
+	// Distant avatars are posed less often and without their leaf bones, the frames in between are interpolated.
+	animation_world.set_lods({ { 0.0f, 1, 0 }, { 8.0f, 2, 1 }, { 11.0f, 4, 2 } });
+
+	AssetStreamer asset_streamer(job_system);
+
+	// Everything is loaded in the background, frames are drawn with whatever has arrived so far.
+	const AssetHandle<CrowdAsset> crowd_asset = asset_streamer.load<CrowdAsset>([&job_system]() { return load_crowd_asset(job_system); });
+
+	// Array layers all share the format of the first skin, the RGBA8 placeholder below included, and a layer copy
+	// doesn't carry the swizzle gray images get; bindless skins can keep the channels of their files.
+	const int skin_channels = skin_mode == SkinSet::Mode::Array ? 4 : 0;
+	const AssetHandle<Texture> texture = asset_streamer.load_texture(TEXTURE_PATH, skin_channels);
+
+	// Sampling state lives in sampler objects rather than in each texture.
+	SamplerCache sampler_cache;
+	SkinSet skins(skin_mode, sampler_cache.get({ Interpolation::Constant, true, Sampler::Wrap::Repeat, 8.0f }), SKIN_CAPACITY);
+
+	// Used as the skin instead if the texture fails to load.
+	const unsigned char placeholder_pixel[] = { 255, 255, 255, 255 };
+	const std::shared_ptr<Texture> placeholder_texture = std::make_shared<Texture>(Texture::Storage{ 1, 1, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE });
+	placeholder_texture->bind();
+		placeholder_texture->update(0, 0, 1, 1, placeholder_pixel);
+	placeholder_texture->unbind();
+
+	bool crowd_skinned = false;
+
+	RigPtr_t rig;
+
+	// All meshes live in shared buffers and are drawn by the render queue, one multi-draw per material.
+	MeshBuffer mesh_buffer(MESH_VERTEX_CAPACITY, MESH_INDEX_CAPACITY, MESH_INSTANCE_CAPACITY);
+	RenderQueue render_queue(mesh_buffer);
+
+	// Draws are recorded by the workers and replayed into the render queue here, where the context is.
+	CommandRecorder draw_commands;
+	CommandExecutor command_executor(render_queue);
+
+	glm::mat4 projection_matrix = glm::mat4(1);
+
+	// The grid stays roughly square; half the instance capacity leaves room for the background rows.
+	const uint32_t crowd_size = benchmark_settings.enabled ? std::min(benchmark_settings.crowd_size, MESH_INSTANCE_CAPACITY / 2) : CROWD_SIZE;
+	const uint32_t crowd_columns = benchmark_settings.enabled ? static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(crowd_size)))) : CROWD_COLUMNS;
+	const uint32_t crowd_rows = (crowd_size + crowd_columns - 1) / crowd_columns;
+	const uint32_t background_size = crowd_columns * BACKGROUND_ROWS;
+
+	Aabb crowd_bounds;
+	std::vector<glm::mat4> crowd_models(crowd_size);
+	std::vector<Aabb> crowd_boxes(crowd_size);
+	std::vector<uint8_t> crowd_visible(crowd_size);
+
+	// Level each avatar is drawn at this frame, UINT32_MAX for those that aren't. The skinning pass only runs for
+	// the ones at level 0, packed into its output in crowd order; skinning_slots says where each one went.
+	std::vector<uint32_t> crowd_levels(crowd_size);
+	std::vector<uint32_t> skinning_slots(crowd_size);
+	std::vector<uint32_t> skinning_palette_offsets;
+
+	PoseCache pose_cache;
+
+	std::vector<glm::mat4> background_models(background_size);
+	std::vector<Aabb> background_boxes(background_size);
+	std::vector<uint8_t> background_visible(background_size);
+
+	uint32_t background_clip = 0;
+
+	// The skinning pass only covers level 0, the coarser levels are skinned in their vertex shader either way.
+	std::vector<CrowdLodDraw> crowd_lods;
+	uint32_t crowd_skin = 0;
+
+	std::unique_ptr<SkinningPass> skinning_pass;
 
-	Image image("assets/textures/1.png");
+	BindingCache bindings;
 
-	Animation animation("assets/models/1.fbx");
+	// The crowd's instances in the world start here, one after the other.
+	uint32_t first_avatar = 0;
 
-	Texture texture(image.width, image.height, image.data, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, { Texture::set_interpolation(Interpolation::Constant) });
+	bool crowd_spawned = false;
+	std::vector<AssetHandle<VBO>> mesh_uploads;
+
+	// Each format goes up only if a crowd level skins with it, both bound at once when they do.
+	PaletteBuffer palette_buffer;
+	PaletteBuffer dual_quaternion_palette_buffer(PaletteBuffer::Format::DualQuaternions);
+	bool matrix_materials = false;
+	bool dual_quaternion_materials = false;
+
+	// Started once the crowd has spawned; from then on the world is only reached through it.
+	std::unique_ptr<SimulationThread> simulation;
+	SimulationThread::View simulation_view;
+	std::vector<uint8_t> avatar_posed;
+	std::vector<glm::mat4> palettes;
+	std::vector<DualQuaternion> dual_quaternion_palettes;
+
+	GpuTimer gpu_timer;
+
+	// The camera sits at the origin looking down -z unless a benchmark moves it.
+	glm::vec3 camera_position(0.0f);
+	glm::mat4 view_matrix(1);
+
+	bool crowd_ready = false;
+
+	// A background thread notices edited files, their new versions are loaded and built while the old ones are
+	// still drawn with and swapped in between frames once they're ready.
+	FileWatcher file_watcher;
+	AssetHandle<ShaderSources> shader_reload;
+	AssetHandle<Texture> texture_reload;
+	bool shaders_changed = false;
+
+	if (hot_reload)
+	{
+		file_watcher.watch(SHADER_SOURCE_PATH);
+		file_watcher.watch(TEXTURE_PATH);
+		file_watcher.watch(MODEL_PATH);
+		file_watcher.watch(ASSET_PACK_PATH);
+		file_watcher.start();
+	}
 
 	while (window.is_running())
 	{
+		// Benchmarks start measuring once there is a crowd to draw.
+		if (benchmark_settings.enabled && crowd_ready)
+			benchmark.begin_frame();
+
+		profiler::begin_frame();
+		gpu_timer.begin_frame();
+
 		window.poll_events();
+
+		asset_streamer.update(UPLOAD_BUDGET_MS);
+
+		if (hot_reload)
+		{
+			for (const std::string& path : file_watcher.poll())
+			{
+				spdlog::info("{0} changed", path);
+
+				if (path == FileWatcher::get_key(TEXTURE_PATH))
+					texture_reload = asset_streamer.load_texture(TEXTURE_PATH, skin_channels);
+				else if (path == FileWatcher::get_key(MODEL_PATH) || path == FileWatcher::get_key(ASSET_PACK_PATH))
+					spdlog::warn("Meshes and clips are only loaded at startup, restart to see the change");
+				else
+					shaders_changed = true;
+			}
+
+			// Edits made while sources are being read are picked up by the next read.
+			if (shaders_changed && shader_reload.get_state() != AssetState::Loading)
+			{
+				shader_reload = asset_streamer.load<ShaderSources>([skin_mode]() { return load_shader_sources(skin_mode); });
+				shaders_changed = false;
+			}
+
+			if (shader_reload.is_ready())
+			{
+				const ShaderSources& sources = *shader_reload.get();
+
+				skinned_shaders.reload(sources.skinned_instanced_vert, sources.skinned_frag);
+				skinned_vertices_shaders.reload(sources.skinned_vertices_vert, sources.skinned_frag);
+
+				if (skinning_pass)
+					skinning_pass->reload(sources.skinning_comp);
+
+				shader_reload = {};
+			}
+
+			if (texture_reload.is_ready() && crowd_skinned)
+			{
+				skins.replace(crowd_skin, texture_reload.get());
+				texture_reload = {};
+			}
+
+			if (skinned_shaders.update() | skinned_vertices_shaders.update())
+				spdlog::info("Shaders reloaded");
+		}
+
+		// The crowd is spawned once its data is decoded and becomes visible when the mesh has streamed in.
+		if (!crowd_spawned && crowd_asset.is_ready())
+		{
+			const std::shared_ptr<CrowdAsset>& asset = crowd_asset.get();
+
+			crowd_spawned = true;
+
+			bool crowd_loaded = false;
+
+			for (uint32_t i = 0; i < asset->lods.size(); i++)
+			{
+				const CrowdLod& lod = asset->lods[i];
+				const uint32_t mesh_index = mesh_buffer.add_mesh(lod.vertex_count, lod.index_count, lod.index_size, asset->bounds);
+
+				// Levels keep their index into the asset and the tables above, select_lod() skips the ones left out.
+				if (mesh_index == UINT32_MAX)
+				{
+					crowd_lods.push_back({ UINT32_MAX, 0, 0 });
+					continue;
+				}
+
+				const MeshBuffer::Mesh& mesh = mesh_buffer.get_mesh(mesh_index);
+
+				// Only as many joints per vertex as the mesh uses are blended, rigid meshes skip skinning entirely.
+				const uint32_t influence_features = skinned_features::from_influences(lod.max_influences);
+				const uint32_t palette_features = i < std::size(CROWD_LOD_PALETTE_FEATURES) ? CROWD_LOD_PALETTE_FEATURES[i] : static_cast<uint32_t>(0);
+
+				if (influence_features != skinned_features::Rigid)
+				{
+					if (palette_features & skinned_features::DualQuaternions)
+						dual_quaternion_materials = true;
+					else
+						matrix_materials = true;
+				}
+
+				// Meshes are uploaded in their 24-byte packed layout, vertex bandwidth dominates large crowds.
+				mesh_uploads.push_back(asset_streamer.upload_buffer(mesh_buffer.get_vertex_buffer(), lod.vertex_data, lod.vertex_count * sizeof(PackedVertex), asset, mesh.base_vertex));
+				mesh_uploads.push_back(asset_streamer.upload_buffer(mesh_buffer.get_index_buffer(), lod.index_data, lod.index_count * lod.index_size, asset, mesh.first_index));
+
+				CrowdLodDraw draw{ mesh_index, 0, 0 };
+
+				if (i == 0 && SkinningPass::is_supported())
+				{
+					skinning_pass = std::make_unique<SkinningPass>(mesh_buffer.get_vertex_buffer(), mesh.base_vertex, lod.vertex_count, asset->bounds, influence_features | palette_features);
+					draw.crowd_material = render_queue.add_material({ &skinned_vertices_shaders.get(0), &skins, {} });
+				}
+				else
+				{
+					draw.crowd_material = render_queue.add_material({ &skinned_shaders.get(influence_features | palette_features), &skins, {} });
+				}
+
+				draw.background_material = render_queue.add_material({ &skinned_shaders.get(influence_features | skinned_features::BakedPalettes), &skins, {} });
+
+				crowd_lods.push_back(draw);
+				crowd_loaded = true;
+			}
+
+			if (crowd_loaded)
+			{
+				rig = asset->rig;
+				crowd_bounds = asset->clip_bounds;
+
+				const AnimationBindingPtr_t binding = bindings.get(rig->skeleton, *asset->clip);
+
+				first_avatar = animation_world.get_instance_count();
+
+				for (uint32_t i = 0; i < crowd_size; i++)
+					animation_world.add_instance(rig, asset->clip, binding, i * 0.37f, PLAYBACK_SPEED);
+
+				const uint32_t instance_count = animation_world.get_instance_count();
+				simulation_view.visible.assign(instance_count, 1);
+				simulation_view.camera_distances.assign(instance_count, 0.0f);
+				avatar_posed.assign(instance_count, 0);
+
+				simulation = std::make_unique<SimulationThread>(animation_world, job_system, SIMULATION_STEP);
+				simulation->start();
+
+				background_clip = pose_cache.add(rig, *asset->clip, *binding);
+				pose_cache.upload();
+			}
+		}
+
+		if (!crowd_skinned && (texture.is_ready() || texture.is_failed()))
+		{
+			crowd_skin = skins.add(texture.is_ready() ? texture.get() : placeholder_texture);
+			crowd_skinned = true;
+		}
+
+		const bool meshes_uploaded = std::all_of(mesh_uploads.begin(), mesh_uploads.end(), [](const AssetHandle<VBO>& upload) { return upload.is_ready(); });
+		crowd_ready = meshes_uploaded && crowd_skinned && simulation && simulation->has_snapshots();
 		
 		global::gui::begin_frame();
 
-			ImGui::ShowDemoWindow();
+			profiler::draw_window();
 
-			ImGui::Render();
+			// Binds since the last frame got here that reached the driver, and those the state cache dropped.
+			ImGui::Begin("GL state");
 
-			int display_w, display_h;
-			glfwGetFramebufferSize(window.get_handle(), &display_w, &display_h);
-			glViewport(0, 0, display_w, display_h);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				const char* call_names[] = { "Program", "Vertex array", "Buffer", "Indexed buffer", "Active texture", "Texture", "Sampler" };
+
+				for (uint32_t i = 0; i < static_cast<uint32_t>(gl_state::Call::Count); i++)
+				{
+					const gl_state::Counter& counter = gl_state::get_counter(static_cast<gl_state::Call>(i));
+					ImGui::Text("%-16s issued %4u  skipped %4u", call_names[i], counter.issued, counter.skipped);
+				}
 
-			shader.bind();
-			
-				static glm::mat4 projection_matrix = glm::mat4(1);
-				projection_matrix = glm::perspective(glm::radians(70.0f), static_cast<float>(display_w) / static_cast<float>(display_h), 0.1f, 1000.0f);
+				if (simulation)
+					ImGui::Text("%u of %u avatars posed", simulation->get_posed_count(), simulation->get_instance_count());
+				ImGui::Text("%u instances in %u commands, %u multi-draws", render_queue.get_instance_count(), render_queue.get_command_count(), render_queue.get_draw_count());
 
-				static float time = 0;
-				time += 0.2f;
-				avatar.calculate_pose(time, animation);
+				const gl_stats::Stats& stats = gl_stats::get();
+				ImGui::Text("%u draws, %llu triangles, %u uploads of %.1f KB", stats.draw_calls, static_cast<unsigned long long>(stats.triangles), stats.uploads, stats.uploaded_bytes / 1024.0);
 
-                static float alpha = 0.f;
-                alpha += 0.333f;
+			ImGui::End();
 
-                model_matrix = glm::mat4(1);
-                model_matrix = glm::translate(model_matrix, glm::vec3(0, -2, -5));
-                model_matrix = glm::rotate(model_matrix, glm::radians(alpha), glm::vec3(0, 1, 0));
-                model_matrix = glm::scale(model_matrix, glm::vec3(0.01f));
+			gl_state::reset_counters();
+			gl_stats::reset();
 
-				shader.set_uniform_mat4("u_model", &model_matrix[0][0]);
-				shader.set_uniform_mat4("u_proj", &projection_matrix[0][0]);
-				shader.set_uniform_mat4("u_bones", &avatar.current_transforms[0][0][0], avatar.get_amount_of_bones());
+			// GPU passes of a frame or two ago, next to the CPU zones.
+			std::vector<profiler::GpuZone> gpu_zones;
 
-				vao.bind();
-				texture.bind();
-				vao.get_index_buffer()->bind();
-					glDrawElements(GL_TRIANGLES, vao.get_index_buffer()->get_index_count(), GL_UNSIGNED_INT, nullptr);
-				vao.unbind();
+			for (const GpuTimer::Pass& pass : gpu_timer.get_passes())
+				gpu_zones.push_back({ pass.name, pass.start_ms, pass.duration_ms, pass.depth });
+
+			profiler::set_gpu_frame(gpu_timer.get_frame_ms(), std::move(gpu_zones));
+
+			ImGui::Render();
 
-			shader.unbind();
+			int display_w, display_h;
+			glfwGetFramebufferSize(window.get_handle(), &display_w, &display_h);
+			glViewport(0, 0, display_w, display_h);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+			if (crowd_ready)
+			{
+				PROFILE_ZONE("Draw crowd");
+
+				if (benchmark.is_running())
+					view_matrix = get_benchmark_view(benchmark.get_progress(), crowd_columns * 2.0f, (crowd_rows + BACKGROUND_ROWS) * 2.0f, camera_position);
+
+				projection_matrix = glm::perspective(glm::radians(FIELD_OF_VIEW), static_cast<float>(display_w) / static_cast<float>(display_h), 0.1f, 1000.0f) * view_matrix;
+				render_queue.set_frame({ projection_matrix });
+
+				// Poses are written straight into the mapped palette rings when there are some.
+				glm::mat4* palette_storage = nullptr;
+				DualQuaternion* dual_quaternion_storage = nullptr;
+				glm::mat4* palette_output = nullptr;
+
+				if (matrix_materials)
+				{
+					palette_storage = palette_buffer.begin_frame(simulation->get_palette_count());
+
+					if (!palette_storage)
+						palettes.resize(simulation->get_palette_count());
+
+					palette_output = palette_storage ? palette_storage : palettes.data();
+				}
+
+				if (dual_quaternion_materials)
+				{
+					dual_quaternion_storage = dual_quaternion_palette_buffer.begin_dual_quaternion_frame(simulation->get_palette_count());
+
+					if (!dual_quaternion_storage)
+						dual_quaternion_palettes.resize(simulation->get_palette_count());
+
+					simulation->interpolate(palette_output, dual_quaternion_storage ? dual_quaternion_storage : dual_quaternion_palettes.data(), avatar_posed.data());
+				}
+				else
+				{
+					simulation->interpolate(palette_output, avatar_posed.data());
+				}
+
+				const float render_time = static_cast<float>(simulation->get_render_time());
+				const float alpha = render_time * CROWD_TURN_RATE;
+
+				// Rows of avatars going away from the camera, the background ones continue behind the crowd.
+				const auto place = [crowd_columns, alpha](uint32_t i, glm::mat4& model_matrix)
+				{
+					const float x = (static_cast<float>(i % crowd_columns) - (crowd_columns - 1) * 0.5f) * 2.0f;
+					const float z = -5.0f - static_cast<float>(i / crowd_columns) * 2.0f;
+
+					model_matrix = glm::mat4(1);
+					model_matrix = glm::translate(model_matrix, glm::vec3(x, -2, z));
+					model_matrix = glm::rotate(model_matrix, glm::radians(alpha), glm::vec3(0, 1, 0));
+					model_matrix = glm::scale(model_matrix, glm::vec3(0.01f));
+				};
+
+				for (uint32_t i = 0; i < crowd_size; i++)
+				{
+					place(i, crowd_models[i]);
+					crowd_boxes[i] = crowd_bounds.transformed(crowd_models[i]);
+				}
+
+				// Background rows start on a fresh row even if the last crowd row isn't full.
+				for (uint32_t i = 0; i < background_size; i++)
+				{
+					place(crowd_rows * crowd_columns + i, background_models[i]);
+					background_boxes[i] = crowd_bounds.transformed(background_models[i]);
+				}
+
+				// Avatars outside the view are neither posed nor drawn. The simulation sees the result from its next step on,
+				// so avatars coming into view only show up once they have been posed.
+				const Frustum frustum(projection_matrix);
+				frustum.cull(crowd_boxes.data(), crowd_size, crowd_visible.data());
+				frustum.cull(background_boxes.data(), background_size, background_visible.data());
+
+				for (uint32_t i = 0; i < crowd_size; i++)
+				{
+					simulation_view.visible[first_avatar + i] = crowd_visible[i];
+					simulation_view.camera_distances[first_avatar + i] = glm::distance(crowd_boxes[i].get_center(), camera_position);
+				}
+
+				simulation->submit_view(simulation_view);
+
+				const float tan_half_fov = std::tan(glm::radians(FIELD_OF_VIEW) * 0.5f);
+
+				// Level selection and instance data only read the state above, so batches run on any core.
+				job_system.parallel_for(crowd_size, DRAW_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; i++)
+					{
+						const bool drawn = crowd_visible[i] && avatar_posed[first_avatar + i];
+						crowd_levels[i] = drawn ? select_lod(crowd_boxes[i], camera_position, tan_half_fov, crowd_lods) : UINT32_MAX;
+					}
+				});
+
+				skinning_palette_offsets.clear();
+
+				if (skinning_pass)
+				{
+					for (uint32_t i = 0; i < crowd_size; i++)
+					{
+						if (crowd_levels[i] != 0)
+							continue;
+
+						skinning_slots[i] = skinning_palette_offsets.size();
+						skinning_palette_offsets.push_back(simulation->get_palette_offset(first_avatar + i));
+					}
+				}
+
+				job_system.parallel_for(crowd_size, DRAW_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+				{
+					CommandBuffer& commands = draw_commands.get();
+
+					for (uint32_t i = begin; i < end; i++)
+					{
+						if (crowd_levels[i] == UINT32_MAX)
+							continue;
+
+						const CrowdLodDraw& lod = crowd_lods[crowd_levels[i]];
+
+						InstanceData instance;
+						instance.model = crowd_models[i];
+						instance.skin = crowd_skin;
+						instance.bone_offset = simulation->get_palette_offset(first_avatar + i);
+
+						if (skinning_pass && crowd_levels[i] == 0)
+							instance.vertex_offset = skinning_slots[i] * skinning_pass->get_vertex_count();
+
+						commands.draw(lod.mesh, lod.crowd_material, instance);
+					}
+				});
+
+				job_system.parallel_for(background_size, DRAW_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+				{
+					CommandBuffer& commands = draw_commands.get();
+
+					for (uint32_t i = begin; i < end; i++)
+					{
+						if (!background_visible[i])
+							continue;
+
+						InstanceData instance;
+						instance.model = background_models[i];
+						instance.skin = crowd_skin;
+						pose_cache.sample(background_clip, render_time * PLAYBACK_SPEED + (crowd_size + i) * 0.37f, instance);
+
+						const CrowdLodDraw& lod = crowd_lods[select_lod(background_boxes[i], camera_position, tan_half_fov, crowd_lods)];
+						commands.draw(lod.mesh, lod.background_material, instance);
+					}
+				});
+
+				command_executor.execute(draw_commands);
+				draw_commands.clear();
+
+				if (matrix_materials)
+				{
+					if (!palette_storage)
+						palette_buffer.upload(palettes);
+
+					palette_buffer.bind();
+				}
+
+				if (dual_quaternion_materials)
+				{
+					if (!dual_quaternion_storage)
+						dual_quaternion_palette_buffer.upload(dual_quaternion_palettes);
+
+					dual_quaternion_palette_buffer.bind();
+				}
+				pose_cache.bind();
+
+				if (skinning_pass)
+				{
+					const GpuTimer::Scope gpu_pass(gpu_timer, "Skinning");
+
+					skinning_pass->dispatch(skinning_palette_offsets);
+					skinning_pass->bind_output();
+				}
+
+				{
+					const GpuTimer::Scope gpu_pass(gpu_timer, "Crowd");
+					render_queue.flush();
+				}
+
+				palette_buffer.end_frame();
+				dual_quaternion_palette_buffer.end_frame();
+			}
+
+			{
+				const GpuTimer::Scope gpu_pass(gpu_timer, "ImGui");
+				ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+			}
+
+			// The ImGui backend binds on its own, behind the state cache.
+			gl_state::invalidate();
 		
 		global::gui::end_frame();
 
+		gpu_timer.end_frame();
+
+		if (benchmark.is_running())
+		{
+			benchmark.add_gpu_frame(gpu_timer.get_frame_ms());
+			benchmark.end_cpu();
+		}
+
 		window.swap_buffers();
+
+		if (benchmark.is_done())
+		{
+			benchmark.write_report();
+			break;
+		}
 	}
 
 	global::gui::shutdown();
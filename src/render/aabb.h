@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cfloat>
+
+// Axis-aligned box; starts out empty (min > max) so that the first extend() sets it.
+struct Aabb
+{
+	glm::vec3 min{ FLT_MAX };
+	glm::vec3 max{ -FLT_MAX };
+
+	inline bool is_empty() const
+	{
+		return min.x > max.x;
+	}
+
+	inline void extend(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	inline void extend(const Aabb& box)
+	{
+		min = glm::min(min, box.min);
+		max = glm::max(max, box.max);
+	}
+
+	inline glm::vec3 get_center() const
+	{
+		return (min + max) * 0.5f;
+	}
+
+	inline glm::vec3 get_extent() const
+	{
+		return (max - min) * 0.5f;
+	}
+
+	// Box around this one after an affine transform, without transforming all eight corners.
+	inline Aabb transformed(const glm::mat4& transform) const
+	{
+		const glm::vec3 center = glm::vec3(transform * glm::vec4(get_center(), 1.0f));
+		const glm::mat3 axes = glm::mat3(transform);
+		const glm::vec3 extent = glm::abs(axes[0]) * get_extent().x + glm::abs(axes[1]) * get_extent().y + glm::abs(axes[2]) * get_extent().z;
+
+		Aabb box;
+		box.min = center - extent;
+		box.max = center + extent;
+		return box;
+	}
+};
@@ -0,0 +1,93 @@
+#include "command_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+static uint32_t align(uint32_t size)
+{
+	return (size + CommandBuffer::ALIGNMENT - 1) / CommandBuffer::ALIGNMENT * CommandBuffer::ALIGNMENT;
+}
+
+void CommandBuffer::set_frame(const FrameData& frame)
+{
+	const SetFrame command{ frame };
+	memcpy(push(Type::SetFrame, sizeof(command)), &command, sizeof(command));
+}
+
+void CommandBuffer::draw(uint32_t mesh, uint32_t material, const InstanceData& instance)
+{
+	const Draw command{ mesh, material, instance };
+	memcpy(push(Type::Draw, sizeof(command)), &command, sizeof(command));
+}
+
+void CommandBuffer::clear()
+{
+	data.clear();
+	command_count = 0;
+}
+
+const uint8_t* CommandBuffer::get_data() const
+{
+	return data.data();
+}
+
+size_t CommandBuffer::get_size() const
+{
+	return data.size();
+}
+
+uint32_t CommandBuffer::get_command_count() const
+{
+	return command_count;
+}
+
+uint8_t* CommandBuffer::push(Type type, uint32_t payload_size)
+{
+	const Header header{ type, align(sizeof(Header) + payload_size) };
+	const size_t start = data.size();
+
+	// Padding is zeroed, so identical recordings give identical bytes.
+	data.resize(start + header.size, 0);
+	memcpy(&data[start], &header, sizeof(header));
+
+	command_count++;
+
+	return &data[start + sizeof(header)];
+}
+
+CommandBuffer& CommandRecorder::get()
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	const std::thread::id thread = std::this_thread::get_id();
+	const auto it = std::find(threads.begin(), threads.end(), thread);
+
+	if (it != threads.end())
+		return *buffers[it - threads.begin()];
+
+	threads.push_back(thread);
+	buffers.push_back(std::make_unique<CommandBuffer>());
+
+	return *buffers.back();
+}
+
+const std::vector<std::unique_ptr<CommandBuffer>>& CommandRecorder::get_buffers() const
+{
+	return buffers;
+}
+
+uint32_t CommandRecorder::get_command_count() const
+{
+	uint32_t count = 0;
+
+	for (const std::unique_ptr<CommandBuffer>& buffer : buffers)
+		count += buffer->get_command_count();
+
+	return count;
+}
+
+void CommandRecorder::clear()
+{
+	for (const std::unique_ptr<CommandBuffer>& buffer : buffers)
+		buffer->clear();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "instance_data.h"
+
+// Rendering work recorded as plain data, on any thread, and replayed later on the one that owns the graphics
+// context, see CommandExecutor. Commands refer to resources by index only: meshes of the MeshBuffer, materials of
+// the RenderQueue, never to GL objects or names, so another backend can consume the same stream. Commands are stored
+// back to back, each a Header directly followed by its payload, the whole command padded to a multiple of ALIGNMENT
+// bytes; recording only appends to one growing block, which clear() keeps for the next frame.
+class CommandBuffer
+{
+public:
+	static constexpr uint32_t ALIGNMENT = 16;
+
+	enum class Type : uint32_t
+	{
+		SetFrame,
+		Draw,
+	};
+
+	struct Header
+	{
+		Type type;
+
+		// Of the whole command, header and padding included, so readers can skip commands they don't know.
+		uint32_t size;
+	};
+
+	struct SetFrame
+	{
+		FrameData frame;
+	};
+
+	struct Draw
+	{
+		uint32_t mesh;
+		uint32_t material;
+		InstanceData instance;
+	};
+
+	CommandBuffer() = default;
+
+	void set_frame(const FrameData& frame);
+	void draw(uint32_t mesh, uint32_t material, const InstanceData& instance);
+
+	void clear();
+
+	const uint8_t* get_data() const;
+	size_t get_size() const;
+	uint32_t get_command_count() const;
+
+private:
+	// Appends a command with payload_size bytes after its header and returns where they go.
+	uint8_t* push(Type type, uint32_t payload_size);
+
+	std::vector<uint8_t> data;
+	uint32_t command_count{0};
+
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator=(const CommandBuffer&) = delete;
+};
+
+// A CommandBuffer for every thread that records, e.g. the workers of a parallel_for building a frame's draws,
+// so recording needs no locks. get() locks to find the calling thread's buffer, so it goes once per job, not
+// per command. Nothing may record while the buffers are replayed or cleared.
+class CommandRecorder
+{
+public:
+	CommandRecorder() = default;
+
+	CommandBuffer& get();
+
+	// Every buffer recorded into so far, in no particular order.
+	const std::vector<std::unique_ptr<CommandBuffer>>& get_buffers() const;
+	uint32_t get_command_count() const;
+
+	void clear();
+
+private:
+	std::mutex mutex;
+
+	std::vector<std::thread::id> threads;
+	std::vector<std::unique_ptr<CommandBuffer>> buffers;
+
+	CommandRecorder(const CommandRecorder&) = delete;
+	CommandRecorder& operator=(const CommandRecorder&) = delete;
+};
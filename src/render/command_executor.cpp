@@ -0,0 +1,60 @@
+#include "command_executor.h"
+#include "command_buffer.h"
+#include "render_queue.h"
+
+#include "../core/profiler/profiler.h"
+
+#include <cstring>
+
+// Commands start at multiples of ALIGNMENT into the block, but the block is only as aligned as its allocation and a
+// payload follows its 8 byte header, so payloads are copied out instead of cast.
+template <typename T>
+static T read(const uint8_t* payload)
+{
+	T command;
+	memcpy(&command, payload, sizeof(T));
+
+	return command;
+}
+
+CommandExecutor::CommandExecutor(RenderQueue& queue) : queue{queue}
+{
+}
+
+void CommandExecutor::execute(const CommandBuffer& commands)
+{
+	const uint8_t* data = commands.get_data();
+
+	for (size_t offset = 0; offset < commands.get_size();)
+	{
+		const CommandBuffer::Header header = read<CommandBuffer::Header>(data + offset);
+		const uint8_t* payload = data + offset + sizeof(header);
+
+		switch (header.type)
+		{
+		case CommandBuffer::Type::SetFrame:
+			queue.set_frame(read<CommandBuffer::SetFrame>(payload).frame);
+			break;
+		case CommandBuffer::Type::Draw:
+			submit(read<CommandBuffer::Draw>(payload));
+			break;
+		default:
+			break;
+		}
+
+		offset += header.size;
+	}
+}
+
+void CommandExecutor::submit(const CommandBuffer::Draw& draw)
+{
+	queue.submit(draw.mesh, draw.material, draw.instance);
+}
+
+void CommandExecutor::execute(const CommandRecorder& recorder)
+{
+	PROFILE_ZONE("CommandExecutor::execute");
+
+	for (const std::unique_ptr<CommandBuffer>& commands : recorder.get_buffers())
+		execute(*commands);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "command_buffer.h"
+
+class CommandRecorder;
+class RenderQueue;
+
+// GL side of CommandBuffer: replays recorded commands on the thread owning the context. Draws and the frame go to
+// the RenderQueue, which still sorts and batches them by its flush().
+class CommandExecutor
+{
+public:
+	explicit CommandExecutor(RenderQueue& queue);
+
+	// Commands in recording order; a recorder's buffers one after the other.
+	void execute(const CommandBuffer& commands);
+	void execute(const CommandRecorder& recorder);
+
+private:
+	void submit(const CommandBuffer::Draw& draw);
+
+	RenderQueue& queue;
+
+	CommandExecutor(const CommandExecutor&) = delete;
+	CommandExecutor& operator=(const CommandExecutor&) = delete;
+};
@@ -0,0 +1,88 @@
+#include "frustum.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define FRUSTUM_SSE
+#	include <immintrin.h>
+#endif
+
+Frustum::Frustum(const glm::mat4& view_projection)
+{
+	// Gribb/Hartmann: each plane is the fourth row of the matrix plus or minus one of the others.
+	const glm::mat4 m = glm::transpose(view_projection);
+
+	planes[0] = m[3] + m[0];
+	planes[1] = m[3] - m[0];
+	planes[2] = m[3] + m[1];
+	planes[3] = m[3] - m[1];
+	planes[4] = m[3] + m[2];
+	planes[5] = m[3] - m[2];
+
+	for (glm::vec4& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::is_visible(const Aabb& box) const
+{
+	const glm::vec3 center = box.get_center();
+	const glm::vec3 extent = box.get_extent();
+
+	// The box is outside as soon as it lies entirely behind one plane.
+	for (const glm::vec4& plane : planes)
+	{
+		const glm::vec3 normal = glm::vec3(plane);
+
+		if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extent) + plane.w < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+void Frustum::cull(const Aabb* boxes, uint32_t count, uint8_t* visible) const
+{
+	uint32_t i = 0;
+
+#ifdef FRUSTUM_SSE
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		// Transpose four boxes into center and extent lanes.
+		__m128 min_x = _mm_setr_ps(boxes[i].min.x, boxes[i + 1].min.x, boxes[i + 2].min.x, boxes[i + 3].min.x);
+		__m128 min_y = _mm_setr_ps(boxes[i].min.y, boxes[i + 1].min.y, boxes[i + 2].min.y, boxes[i + 3].min.y);
+		__m128 min_z = _mm_setr_ps(boxes[i].min.z, boxes[i + 1].min.z, boxes[i + 2].min.z, boxes[i + 3].min.z);
+		__m128 max_x = _mm_setr_ps(boxes[i].max.x, boxes[i + 1].max.x, boxes[i + 2].max.x, boxes[i + 3].max.x);
+		__m128 max_y = _mm_setr_ps(boxes[i].max.y, boxes[i + 1].max.y, boxes[i + 2].max.y, boxes[i + 3].max.y);
+		__m128 max_z = _mm_setr_ps(boxes[i].max.z, boxes[i + 1].max.z, boxes[i + 2].max.z, boxes[i + 3].max.z);
+
+		const __m128 center_x = _mm_mul_ps(_mm_add_ps(min_x, max_x), half);
+		const __m128 center_y = _mm_mul_ps(_mm_add_ps(min_y, max_y), half);
+		const __m128 center_z = _mm_mul_ps(_mm_add_ps(min_z, max_z), half);
+		const __m128 extent_x = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+		const __m128 extent_y = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+		const __m128 extent_z = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+
+		__m128 outside = _mm_setzero_ps();
+
+		for (const glm::vec4& plane : planes)
+		{
+			const __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+
+			__m128 distance = _mm_add_ps(_mm_mul_ps(nx, center_x), _mm_add_ps(_mm_mul_ps(ny, center_y), _mm_mul_ps(nz, center_z)));
+			const __m128 radius = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, nx), extent_x), _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, ny), extent_y), _mm_mul_ps(_mm_andnot_ps(sign_mask, nz), extent_z)));
+			distance = _mm_add_ps(_mm_add_ps(distance, radius), _mm_set1_ps(plane.w));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+
+		const int mask = _mm_movemask_ps(outside);
+
+		for (uint32_t j = 0; j < 4; j++)
+			visible[i + j] = (mask >> j & 1) ? 0 : 1;
+	}
+#endif
+
+	for (; i < count; i++)
+		visible[i] = is_visible(boxes[i]) ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+#include "aabb.h"
+
+// View frustum as six planes pulled out of a view-projection matrix, for culling boxes in world space.
+class Frustum
+{
+public:
+	explicit Frustum(const glm::mat4& view_projection);
+
+	bool is_visible(const Aabb& box) const;
+
+	// Writes 1 for every box that intersects the frustum and 0 for the others. Tests four boxes at a time with SSE.
+	void cull(const Aabb* boxes, uint32_t count, uint8_t* visible) const;
+
+private:
+	// xyz is the inward normal, w the distance: a point p is inside when dot(xyz, p) + w >= 0.
+	glm::vec4 planes[6];
+};
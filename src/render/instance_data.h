@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+// One instance of a queued draw as the vertex shaders read it from the Instances storage block (std430).
+// RenderQueue fills in the fields that come from the mesh, submitters only set the rest.
+struct InstanceData
+{
+	glm::mat4 model;
+
+	// Undoes the snorm16 quantization of the mesh's positions; set by RenderQueue.
+	glm::vec4 position_offset;
+	glm::vec4 position_scale;
+
+	// Index into the SkinSet the draw is made with.
+	uint32_t skin{0};
+
+	// First palette matrix of the instance in the palette buffer, or of its current frame in the PoseCache.
+	uint32_t bone_offset{0};
+
+	// First vertex of the instance in the SkinningPass output, for meshes skinned in the compute pass.
+	uint32_t vertex_offset{0};
+
+	// Where the mesh starts in the shared vertex buffer; set by RenderQueue.
+	uint32_t base_vertex{0};
+
+	// PoseCache instances only: the frame after bone_offset's and how far to blend towards it.
+	uint32_t next_bone_offset{0};
+	float frame_blend{0.0f};
+
+	uint32_t padding[2]{};
+};
+
+static_assert(sizeof(InstanceData) == 128, "Has to match struct Instance in the skinned vertex shaders");
+
+// What every material of a frame reads, one Frame uniform block (std140, see frame.glsl) shared by all draws
+// instead of uniforms set on each program.
+struct FrameData
+{
+	glm::mat4 projection{1.0f};
+};
+
+static_assert(sizeof(FrameData) == 64, "Has to match the Frame block in frame.glsl");
@@ -0,0 +1,76 @@
+#include "mesh_buffer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <numeric>
+
+MeshBuffer::MeshBuffer(uint32_t vertex_capacity, uint32_t index_capacity, uint32_t instance_capacity) : vertex_capacity{vertex_capacity}, index_capacity{index_capacity}, instance_capacity{instance_capacity}
+{
+	std::vector<uint32_t> instance_indices(instance_capacity);
+	std::iota(instance_indices.begin(), instance_indices.end(), 0u);
+
+	vao.bind();
+		vertex_buffer = vao.add_vbo(VBO::Type::Array, VBO::Usage::Static, vertex_capacity, sizeof(PackedVertex), nullptr, PackedVertex::GetLayout());
+		instance_index_buffer = vao.add_vbo(VBO::Type::Array, VBO::Usage::Static, instance_capacity, sizeof(uint32_t), instance_indices.data(), std::vector<VertexBufferLayout>{ { 1, sizeof(uint32_t), 0, 1, VertexBufferLayout::ComponentType::UInt32 } });
+	vao.unbind();
+}
+
+uint32_t MeshBuffer::add_mesh(uint32_t mesh_vertex_count, uint32_t mesh_index_count, uint32_t index_size, const QuantizationBounds& bounds)
+{
+	if (vertex_count + mesh_vertex_count > vertex_capacity || index_count + mesh_index_count > index_capacity)
+	{
+		spdlog::error("Mesh buffer is full, can't add a mesh of {0} vertices and {1} indices", mesh_vertex_count, mesh_index_count);
+		return UINT32_MAX;
+	}
+
+	// Halves the index memory and bandwidth wherever the meshes are small enough.
+	if (!index_buffer)
+	{
+		vao.bind();
+			index_buffer = vao.add_vbo(VBO::Type::Indices, VBO::Usage::Static, index_capacity, index_size, nullptr);
+		vao.unbind();
+	}
+
+	if (index_size != get_index_size())
+	{
+		spdlog::error("Mesh buffer holds {0} byte indices, can't add a mesh with {1} byte ones", get_index_size(), index_size);
+		return UINT32_MAX;
+	}
+
+	meshes.push_back({ index_count, mesh_index_count, vertex_count, mesh_vertex_count, bounds });
+
+	vertex_count += mesh_vertex_count;
+	index_count += mesh_index_count;
+
+	return meshes.size() - 1;
+}
+
+const MeshBuffer::Mesh& MeshBuffer::get_mesh(uint32_t mesh) const
+{
+	return meshes[mesh];
+}
+
+const std::shared_ptr<VBO>& MeshBuffer::get_vertex_buffer() const
+{
+	return vertex_buffer;
+}
+
+const std::shared_ptr<VBO>& MeshBuffer::get_index_buffer() const
+{
+	return index_buffer;
+}
+
+uint32_t MeshBuffer::get_index_size() const
+{
+	return index_buffer ? index_buffer->get_size() : 0;
+}
+
+uint32_t MeshBuffer::get_instance_capacity() const
+{
+	return instance_capacity;
+}
+
+VAO& MeshBuffer::get_vao()
+{
+	return vao;
+}
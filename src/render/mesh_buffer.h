@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "xyapi/gl/vao.h"
+
+#include "../assets/packed_vertex.h"
+
+// Vertex and index megabuffers shared by every mesh that is drawn through the RenderQueue, so one
+// VAO serves all of them and a multi-draw can switch meshes without touching any GL state.
+// Ranges are handed out back to back and never freed. Indices are all of one size, set by the first mesh.
+class MeshBuffer
+{
+public:
+	struct Mesh
+	{
+		uint32_t first_index;
+		uint32_t index_count;
+
+		uint32_t base_vertex;
+		uint32_t vertex_count;
+
+		QuantizationBounds bounds;
+	};
+
+	// Must match the location of in_instance in the skinned vertex shaders.
+	static constexpr uint32_t INSTANCE_ATTRIBUTE = 5;
+
+	// The capacities are fixed; instance_capacity bounds the instances of one RenderQueue flush.
+	MeshBuffer(uint32_t vertex_capacity, uint32_t index_capacity, uint32_t instance_capacity);
+
+	// Reserves room for a mesh and returns its index; fill the ranges through get_vertex_buffer() and get_index_buffer().
+	// Indices stay relative to the mesh, index_size bytes each (see mesh_optimizer::get_index_size()). The first mesh
+	// creates the index buffer at its index_size. Returns UINT32_MAX when the buffers are full or the size differs.
+	uint32_t add_mesh(uint32_t vertex_count, uint32_t index_count, uint32_t index_size, const QuantizationBounds& bounds);
+
+	const Mesh& get_mesh(uint32_t mesh) const;
+
+	const std::shared_ptr<VBO>& get_vertex_buffer() const;
+	// Null until the first mesh is added.
+	const std::shared_ptr<VBO>& get_index_buffer() const;
+	uint32_t get_index_size() const;
+
+	uint32_t get_instance_capacity() const;
+
+	VAO& get_vao();
+
+private:
+	VAO vao;
+
+	std::shared_ptr<VBO> vertex_buffer;
+	std::shared_ptr<VBO> index_buffer;
+
+	// 0, 1, 2, ... as a per-instance attribute: with the base instance of each draw added, it is the index
+	// of the instance in the Instances block, which works without ARB_shader_draw_parameters.
+	std::shared_ptr<VBO> instance_index_buffer;
+
+	uint32_t vertex_capacity, index_capacity, instance_capacity;
+	uint32_t vertex_count{0}, index_count{0};
+
+	std::vector<Mesh> meshes;
+
+	MeshBuffer(const MeshBuffer&) = delete;
+	MeshBuffer& operator=(const MeshBuffer&) = delete;
+};
@@ -0,0 +1,98 @@
+#include "palette_buffer.h"
+
+#include "xyapi/gl/vbo.h"
+
+#include "../animation/dual_quaternion.h"
+#include "../core/profiler/profiler.h"
+
+#include <algorithm>
+
+PaletteBuffer::PaletteBuffer(Format format) : format{format}
+{
+}
+
+void PaletteBuffer::upload(const std::vector<glm::mat4>& palettes)
+{
+	if (format == Format::Matrices)
+		upload(palettes.data(), palettes.size());
+}
+
+void PaletteBuffer::upload(const std::vector<DualQuaternion>& palettes)
+{
+	if (format == Format::DualQuaternions)
+		upload(palettes.data(), palettes.size());
+}
+
+void PaletteBuffer::upload(const void* palettes, uint32_t amount)
+{
+	PROFILE_ZONE("Upload palettes");
+
+	if (amount > capacity || !buffer || persistent)
+	{
+		capacity = std::max(amount, capacity * 2);
+		buffer = std::make_shared<VBO>(-1, VBO::Type::ShaderStorage, VBO::Usage::Dynamic, capacity, get_stride(), nullptr);
+		persistent = false;
+	}
+
+	buffer->bind();
+		buffer->update(palettes, amount);
+	buffer->unbind();
+}
+
+glm::mat4* PaletteBuffer::begin_frame(uint32_t amount)
+{
+	return format == Format::Matrices ? static_cast<glm::mat4*>(map(amount)) : nullptr;
+}
+
+DualQuaternion* PaletteBuffer::begin_dual_quaternion_frame(uint32_t amount)
+{
+	return format == Format::DualQuaternions ? static_cast<DualQuaternion*>(map(amount)) : nullptr;
+}
+
+void* PaletteBuffer::map(uint32_t amount)
+{
+	if (!VBO::is_persistent_supported())
+		return nullptr;
+
+	// A new ring leaves the old one to be freed once the GPU is done with it.
+	if (amount > capacity || !persistent)
+	{
+		capacity = std::max(amount, capacity * 2);
+		buffer = std::make_shared<VBO>(-1, VBO::Type::ShaderStorage, VBO::Usage::Persistent, capacity, get_stride(), nullptr);
+		persistent = true;
+	}
+
+	return buffer->begin_frame();
+}
+
+void PaletteBuffer::end_frame()
+{
+	if (persistent)
+		buffer->end_frame();
+}
+
+void PaletteBuffer::bind() const
+{
+	bind(format == Format::Matrices ? BINDING : DUAL_QUATERNION_BINDING);
+}
+
+void PaletteBuffer::bind(uint32_t binding) const
+{
+	if (buffer)
+		buffer->bind_base(binding);
+}
+
+PaletteBuffer::Format PaletteBuffer::get_format() const
+{
+	return format;
+}
+
+uint32_t PaletteBuffer::get_capacity() const
+{
+	return capacity;
+}
+
+uint32_t PaletteBuffer::get_stride() const
+{
+	return format == Format::Matrices ? sizeof(glm::mat4) : sizeof(DualQuaternion);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+class VBO;
+
+struct DualQuaternion;
+
+// Bone palettes of all avatars in a single shader storage buffer. Draws select their
+// avatar through u_bone_offset instead of uploading a uniform array each.
+class PaletteBuffer
+{
+public:
+	// Must match the bindings of the BonePalette and DualQuaternionPalette blocks in the skinning shaders.
+	static constexpr uint32_t BINDING = 0;
+	static constexpr uint32_t DUAL_QUATERNION_BINDING = 6;
+
+	// What a palette entry is stored as. Dual quaternions are half the size, for the DUAL_QUATERNIONS variants
+	// of skinned_features; both are indexed by bone, so the offsets of an AnimationWorld apply to either.
+	enum class Format
+	{
+		Matrices,
+		DualQuaternions,
+	};
+
+	explicit PaletteBuffer(Format format = Format::Matrices);
+
+	// Grows the buffer when needed and uploads all palettes in one call, in the buffer's format.
+	void upload(const std::vector<glm::mat4>& palettes);
+	void upload(const std::vector<DualQuaternion>& palettes);
+
+	// With persistent buffers, returns mapped storage for this frame's amount palettes to be written in place
+	// (see AnimationWorld::set_palette_storage) and nullptr otherwise, in which case upload() them instead.
+	// end_frame() goes after the last draw reading them.
+	glm::mat4* begin_frame(uint32_t amount);
+	DualQuaternion* begin_dual_quaternion_frame(uint32_t amount);
+	void end_frame();
+
+	// At the binding of the format without one.
+	void bind() const;
+	void bind(uint32_t binding) const;
+
+	Format get_format() const;
+	uint32_t get_capacity() const;
+
+private:
+	void upload(const void* palettes, uint32_t amount);
+	void* map(uint32_t amount);
+
+	uint32_t get_stride() const;
+
+	std::shared_ptr<VBO> buffer;
+
+	Format format;
+
+	uint32_t capacity{0};
+	bool persistent{false};
+
+	PaletteBuffer(const PaletteBuffer&) = delete;
+	PaletteBuffer& operator=(const PaletteBuffer&) = delete;
+};
@@ -0,0 +1,79 @@
+#include "pose_cache.h"
+
+#include "instance_data.h"
+
+#include "../animation/animation.h"
+
+#include "xyapi/gl/vbo.h"
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t PoseCache::add(const RigPtr_t& rig, const BakedAnimation& animation, const AnimationBinding& binding)
+{
+	Avatar avatar;
+	avatar.init(rig);
+
+	Clip& clip = clips.emplace_back();
+	clip.first_matrix = matrices.size();
+	clip.frame_count = animation.frame_count;
+	clip.bone_count = avatar.get_amount_of_bones();
+	clip.duration = animation.duration;
+	clip.ticks_per_second = animation.ticks_per_second;
+	clip.ticks_per_frame = animation.ticks_per_frame;
+
+	matrices.reserve(matrices.size() + clip.frame_count * clip.bone_count);
+
+	// In ticks, so the last frame isn't wrapped around to the first.
+	for (uint32_t frame = 0; frame < clip.frame_count; frame++)
+	{
+		avatar.calculate_pose_ticks(frame * clip.ticks_per_frame, animation, binding);
+
+		const glm::mat4* palette = avatar.get_palette();
+		matrices.insert(matrices.end(), palette, palette + clip.bone_count);
+	}
+
+	return clips.size() - 1;
+}
+
+void PoseCache::upload()
+{
+	if (uploaded_count == matrices.size())
+		return;
+
+	// Clips are added up front, so the whole buffer is simply made again.
+	buffer = std::make_shared<VBO>(-1, VBO::Type::ShaderStorage, VBO::Usage::Static, matrices.size(), sizeof(glm::mat4), matrices.data());
+	uploaded_count = matrices.size();
+}
+
+void PoseCache::bind(uint32_t binding) const
+{
+	if (buffer)
+		buffer->bind_base(binding);
+}
+
+void PoseCache::sample(uint32_t index, float time, InstanceData& instance) const
+{
+	const Clip& clip = clips[index];
+
+	// Same frame selection as BakedAnimation::get_frames(), so baked instances match avatars playing the clip.
+	const float frame_time = std::fmod(time * clip.ticks_per_second, clip.duration) / clip.ticks_per_frame;
+	const float whole_frames = std::floor(std::max(frame_time, 0.0f));
+
+	const uint32_t frame = std::min(static_cast<uint32_t>(whole_frames), clip.frame_count - 1);
+	const uint32_t next_frame = std::min(frame + 1, clip.frame_count - 1);
+
+	instance.bone_offset = clip.first_matrix + frame * clip.bone_count;
+	instance.next_bone_offset = clip.first_matrix + next_frame * clip.bone_count;
+	instance.frame_blend = frame == next_frame ? 0.0f : std::max(frame_time, 0.0f) - whole_frames;
+}
+
+const PoseCache::Clip& PoseCache::get_clip(uint32_t clip) const
+{
+	return clips[clip];
+}
+
+uint32_t PoseCache::get_matrix_count() const
+{
+	return matrices.size();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "../animation/rig.h"
+
+class BakedAnimation;
+class AnimationBinding;
+class VBO;
+
+struct InstanceData;
+
+// Palettes of looping clips baked ahead of time, for background avatars that don't need an Avatar of their own.
+// Every frame of a clip is posed once on the CPU and stored as get_amount_of_bones() matrices; the BAKED_PALETTES
+// variant of skinned_instanced.vert reads the two frames around an instance's time straight from the buffer and blends them, so such instances
+// cost no animation work at all. Memory is frame_count * bone_count matrices per clip.
+class PoseCache
+{
+public:
+	// Must match the binding of the BakedPalettes block in skinned_instanced.vert.
+	static constexpr uint32_t BINDING = 5;
+
+	struct Clip
+	{
+		// Frame f of the clip starts at first_matrix + f * bone_count.
+		uint32_t first_matrix;
+		uint32_t frame_count;
+		uint32_t bone_count;
+
+		float duration;
+		float ticks_per_second;
+		float ticks_per_frame;
+	};
+
+	PoseCache() = default;
+
+	// Poses every frame of the clip with an avatar of the rig; the binding must resolve the clip against rig->skeleton.
+	// Returns the index of the baked clip. Baked clips reach the GPU with the next upload().
+	uint32_t add(const RigPtr_t& rig, const BakedAnimation& clip, const AnimationBinding& binding);
+
+	void upload();
+	void bind(uint32_t binding = BINDING) const;
+
+	// Points the instance at the frames of the clip around time (in seconds, looping like Avatar::calculate_pose)
+	// through bone_offset, next_bone_offset and frame_blend.
+	void sample(uint32_t clip, float time, InstanceData& instance) const;
+
+	const Clip& get_clip(uint32_t clip) const;
+	uint32_t get_matrix_count() const;
+
+private:
+	std::vector<Clip> clips;
+	std::vector<glm::mat4> matrices;
+
+	std::shared_ptr<VBO> buffer;
+	uint32_t uploaded_count{0};
+
+	PoseCache(const PoseCache&) = delete;
+	PoseCache& operator=(const PoseCache&) = delete;
+};
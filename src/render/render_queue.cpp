@@ -0,0 +1,189 @@
+#include "render_queue.h"
+
+#include "mesh_buffer.h"
+#include "skin_set.h"
+
+#include "../core/profiler/profiler.h"
+
+#include "xyapi/gl/shader.h"
+#include "xyapi/gl/vbo.h"
+#include "xyapi/gl/gl_stats.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Grows buffer to at least amount elements of size bytes; a ring of persistently mapped copies where supported.
+static void reserve(std::shared_ptr<VBO>& buffer, uint32_t& capacity, uint32_t amount, VBO::Type type, size_t size)
+{
+	if (buffer && amount <= capacity)
+		return;
+
+	capacity = std::max(amount, capacity * 2);
+
+	const VBO::Usage usage = VBO::is_persistent_supported() ? VBO::Usage::Persistent : VBO::Usage::Dynamic;
+	buffer = std::make_shared<VBO>(-1, type, usage, capacity, size, nullptr);
+}
+
+// Fills the next copy of a persistent buffer in place, or uploads to a plain one.
+template <typename T>
+static void write(VBO& buffer, const T* data, uint32_t amount)
+{
+	if (VBO::is_persistent_supported())
+	{
+		memcpy(buffer.begin_frame(), data, amount * sizeof(T));
+		return;
+	}
+
+	buffer.bind();
+		buffer.update(data, amount);
+	buffer.unbind();
+}
+
+RenderQueue::RenderQueue(MeshBuffer& meshes) : meshes{meshes}
+{
+}
+
+RenderQueue::~RenderQueue() = default;
+
+uint32_t RenderQueue::add_material(Material material)
+{
+	materials.push_back(std::move(material));
+	return materials.size() - 1;
+}
+
+void RenderQueue::set_frame(const FrameData& p_frame)
+{
+	frame = p_frame;
+}
+
+void RenderQueue::submit(uint32_t mesh, uint32_t material, const InstanceData& instance)
+{
+	if (instances.size() >= meshes.get_instance_capacity())
+	{
+		spdlog::warn("Render queue is full, dropping a draw of mesh {0}", mesh);
+		return;
+	}
+
+	packets.push_back({ static_cast<uint64_t>(material) << 32 | mesh, static_cast<uint32_t>(instances.size()) });
+	instances.push_back(instance);
+}
+
+void RenderQueue::flush()
+{
+	PROFILE_ZONE("RenderQueue::flush");
+
+	draw_count = 0;
+	command_count = 0;
+	instance_count = packets.size();
+
+	if (packets.empty())
+		return;
+
+	std::sort(packets.begin(), packets.end(), [](const Packet& a, const Packet& b) { return a.key < b.key; });
+
+	// Instances are laid out in sorted order, so every run of one mesh is one command's range of instances.
+	sorted_instances.resize(packets.size());
+	commands.clear();
+
+	for (uint32_t i = 0; i < packets.size(); i++)
+	{
+		const uint32_t mesh_index = static_cast<uint32_t>(packets[i].key);
+		const MeshBuffer::Mesh& mesh = meshes.get_mesh(mesh_index);
+
+		InstanceData& instance = sorted_instances[i];
+		instance = instances[packets[i].instance];
+		instance.position_offset = glm::vec4(mesh.bounds.offset, 0.0f);
+		instance.position_scale = glm::vec4(mesh.bounds.scale, 0.0f);
+		instance.base_vertex = mesh.base_vertex;
+
+		if (i > 0 && packets[i].key == packets[i - 1].key)
+			commands.back().instance_count++;
+		else
+			commands.push_back({ mesh.index_count, 1, mesh.first_index, static_cast<int32_t>(mesh.base_vertex), i });
+	}
+
+	reserve(instance_buffer, instance_capacity, sorted_instances.size(), VBO::Type::ShaderStorage, sizeof(InstanceData));
+	reserve(command_buffer, command_capacity, commands.size(), VBO::Type::DrawIndirect, sizeof(Command));
+	reserve(frame_buffer, frame_capacity, 1, VBO::Type::Uniform, sizeof(FrameData));
+
+	write(*instance_buffer, sorted_instances.data(), sorted_instances.size());
+	write(*command_buffer, commands.data(), commands.size());
+	write(*frame_buffer, &frame, 1);
+
+	// The driver only sees the commands through the buffer.
+	uint64_t triangles = 0;
+
+	for (const Command& command : commands)
+		triangles += static_cast<uint64_t>(command.index_count / 3) * command.instance_count;
+
+	gl_stats::add_draw(0, triangles);
+
+	VAO& vao = meshes.get_vao();
+
+	vao.bind();
+	instance_buffer->bind_base(INSTANCE_BINDING);
+	frame_buffer->bind_base(FRAME_BINDING);
+	command_buffer->bind();
+
+		// Commands are sorted by material too, so each material is one contiguous range of them.
+		for (uint32_t first = 0; first < commands.size();)
+		{
+			const uint32_t material_index = packets[commands[first].base_instance].key >> 32;
+			uint32_t last = first + 1;
+
+			while (last < commands.size() && packets[commands[last].base_instance].key >> 32 == material_index)
+				last++;
+
+			const Material& material = materials[material_index];
+
+			material.shader->bind();
+
+				if (material.setup)
+					material.setup(*material.shader);
+
+				if (material.skins)
+					material.skins->bind();
+
+				vao.draw_indirect(last - first, command_buffer->get_frame_element() * sizeof(Command) + first * sizeof(Command));
+
+				if (material.skins)
+					material.skins->unbind();
+
+			material.shader->unbind();
+
+			draw_count++;
+			first = last;
+		}
+
+	command_buffer->unbind();
+	vao.unbind();
+
+	if (VBO::is_persistent_supported())
+	{
+		instance_buffer->end_frame();
+		command_buffer->end_frame();
+		frame_buffer->end_frame();
+	}
+
+	command_count = commands.size();
+
+	packets.clear();
+	instances.clear();
+}
+
+uint32_t RenderQueue::get_draw_count() const
+{
+	return draw_count;
+}
+
+uint32_t RenderQueue::get_command_count() const
+{
+	return command_count;
+}
+
+uint32_t RenderQueue::get_instance_count() const
+{
+	return instance_count;
+}
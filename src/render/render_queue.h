@@ -0,0 +1,97 @@
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "instance_data.h"
+
+class MeshBuffer;
+class SkinSet;
+class Shader;
+class VBO;
+
+// Collects draw packets (mesh, material, instance) during a frame and draws them all in flush():
+// packets are sorted by material and mesh, instances of the same mesh become one indirect command,
+// and every material costs one shader bind and one glMultiDrawElementsIndirect, however many objects there are.
+class RenderQueue
+{
+public:
+	// Must match the binding of the Instances block in the skinned vertex shaders.
+	static constexpr uint32_t INSTANCE_BINDING = 4;
+
+	// Must match the binding of the Frame block in frame.glsl.
+	static constexpr uint32_t FRAME_BINDING = 0;
+
+	struct Material
+	{
+		Shader* shader;
+		const SkinSet* skins;
+
+		// Runs once per flush right after the shader is bound, for state beyond the FrameData.
+		std::function<void(Shader&)> setup;
+	};
+
+	explicit RenderQueue(MeshBuffer& meshes);
+	~RenderQueue();
+
+	uint32_t add_material(Material material);
+
+	// Uploaded once by the next flush, for all of its materials.
+	void set_frame(const FrameData& frame);
+
+	// mesh is an index into the MeshBuffer. Submissions past its instance capacity are dropped.
+	void submit(uint32_t mesh, uint32_t material, const InstanceData& instance);
+
+	// Once per frame: uploads instances and commands, draws, and empties the queue.
+	void flush();
+
+	// Of the last flush.
+	uint32_t get_draw_count() const;
+	uint32_t get_command_count() const;
+	uint32_t get_instance_count() const;
+
+private:
+	// Matches DrawElementsIndirectCommand.
+	struct Command
+	{
+		uint32_t index_count;
+		uint32_t instance_count;
+		uint32_t first_index;
+		int32_t base_vertex;
+		uint32_t base_instance;
+	};
+
+	struct Packet
+	{
+		uint64_t key;
+		uint32_t instance;
+	};
+
+	MeshBuffer& meshes;
+
+	std::vector<Material> materials;
+
+	FrameData frame;
+
+	std::vector<Packet> packets;
+	std::vector<InstanceData> instances;
+
+	std::vector<InstanceData> sorted_instances;
+	std::vector<Command> commands;
+
+	std::shared_ptr<VBO> instance_buffer;
+	std::shared_ptr<VBO> command_buffer;
+	std::shared_ptr<VBO> frame_buffer;
+	uint32_t instance_capacity{0};
+	uint32_t command_capacity{0};
+	uint32_t frame_capacity{0};
+
+	uint32_t draw_count{0};
+	uint32_t command_count{0};
+	uint32_t instance_count{0};
+
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+};
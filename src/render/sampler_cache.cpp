@@ -0,0 +1,16 @@
+#include "sampler_cache.h"
+
+SamplerPtr_t SamplerCache::get(const Sampler::Description& description)
+{
+	SamplerPtr_t& sampler = samplers[{ description.interpolation, description.mipmaps, description.wrap, description.anisotropy }];
+
+	if (!sampler)
+		sampler = std::make_shared<Sampler>(description);
+
+	return sampler;
+}
+
+void SamplerCache::clear()
+{
+	samplers.clear();
+}
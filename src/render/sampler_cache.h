@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <tuple>
+#include <map>
+
+#include "xyapi/gl/sampler.h"
+
+using SamplerPtr_t = std::shared_ptr<Sampler>;
+
+// One sampler object per distinct sampling state, shared by all textures that use it.
+class SamplerCache
+{
+public:
+	SamplerCache() = default;
+
+	SamplerPtr_t get(const Sampler::Description& description);
+
+	void clear();
+
+private:
+	using Key_t = std::tuple<Interpolation, bool, Sampler::Wrap, float>;
+
+	std::map<Key_t, SamplerPtr_t> samplers;
+
+	SamplerCache(const SamplerCache&) = delete;
+	SamplerCache& operator=(const SamplerCache&) = delete;
+};
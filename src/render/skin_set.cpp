@@ -0,0 +1,143 @@
+#include "skin_set.h"
+
+#include "xyapi/gl/texture_array.h"
+#include "xyapi/gl/texture.h"
+#include "xyapi/gl/vbo.h"
+
+#include <GL/glew.h>
+
+#include <spdlog/spdlog.h>
+
+bool SkinSet::is_bindless_supported()
+{
+	return GLEW_ARB_bindless_texture;
+}
+
+SkinSet::SkinSet(Mode mode, SamplerPtr_t sampler, uint32_t capacity) : mode{mode}, sampler{std::move(sampler)}, capacity{capacity}
+{
+	if (mode == Mode::Bindless)
+		handle_buffer = std::make_shared<VBO>(-1, VBO::Type::ShaderStorage, VBO::Usage::Dynamic, capacity, sizeof(uint64_t), nullptr);
+}
+
+SkinSet::~SkinSet()
+{
+	for (uint64_t handle : handles)
+		glMakeTextureHandleNonResidentARB(handle);
+
+	for (uint64_t handle : retired_handles)
+		glMakeTextureHandleNonResidentARB(handle);
+}
+
+uint32_t SkinSet::add(std::shared_ptr<Texture> texture)
+{
+	if (get_count() >= capacity)
+	{
+		spdlog::error("Skin set is full ({0} skins)", capacity);
+		return 0;
+	}
+
+	if (mode == Mode::Bindless)
+	{
+		// The handle bakes in the sampler state, the texture can't be modified from here on.
+		const uint64_t handle = glGetTextureSamplerHandleARB(texture->get_handle(), sampler->get_handle());
+		glMakeTextureHandleResidentARB(handle);
+
+		textures.push_back(std::move(texture));
+		handles.push_back(handle);
+
+		handle_buffer->bind();
+			handle_buffer->update(handles.data(), handles.size());
+		handle_buffer->unbind();
+
+		return handles.size() - 1;
+	}
+
+	if (!array)
+		array = std::make_unique<TextureArray>(TextureArray::Storage{ texture->get_width(), texture->get_height(), capacity, texture->get_levels(), texture->get_internal_format(), 0, 0 });
+
+	const TextureArray::Storage& storage = array->get_storage();
+
+	if (texture->get_width() != storage.width || texture->get_height() != storage.height || texture->get_levels() != storage.levels || texture->get_internal_format() != storage.internal_format)
+	{
+		spdlog::error("Skin of {0}x{1} doesn't match the {2}x{3} layers of the skin array", texture->get_width(), texture->get_height(), storage.width, storage.height);
+		return 0;
+	}
+
+	array->copy(*texture, layer_count);
+
+	return layer_count++;
+}
+
+bool SkinSet::replace(uint32_t index, std::shared_ptr<Texture> texture)
+{
+	if (index >= get_count())
+	{
+		spdlog::error("Skin set has no skin {0} to replace", index);
+		return false;
+	}
+
+	if (mode == Mode::Bindless)
+	{
+		const uint64_t handle = glGetTextureSamplerHandleARB(texture->get_handle(), sampler->get_handle());
+		glMakeTextureHandleResidentARB(handle);
+
+		retired_textures.push_back(std::move(textures[index]));
+		retired_handles.push_back(handles[index]);
+
+		textures[index] = std::move(texture);
+		handles[index] = handle;
+
+		handle_buffer->bind();
+			handle_buffer->update(&handles[index], 1, index);
+		handle_buffer->unbind();
+
+		return true;
+	}
+
+	const TextureArray::Storage& storage = array->get_storage();
+
+	if (texture->get_width() != storage.width || texture->get_height() != storage.height || texture->get_levels() != storage.levels || texture->get_internal_format() != storage.internal_format)
+	{
+		spdlog::error("Skin of {0}x{1} doesn't match the {2}x{3} layers of the skin array", texture->get_width(), texture->get_height(), storage.width, storage.height);
+		return false;
+	}
+
+	array->copy(*texture, index);
+
+	return true;
+}
+
+void SkinSet::bind() const
+{
+	if (mode == Mode::Bindless)
+	{
+		handle_buffer->bind_base(BINDING);
+		return;
+	}
+
+	if (array)
+		array->bind();
+
+	sampler->bind();
+}
+
+void SkinSet::unbind() const
+{
+	if (mode == Mode::Array)
+		sampler->unbind();
+}
+
+SkinSet::Mode SkinSet::get_mode() const
+{
+	return mode;
+}
+
+uint32_t SkinSet::get_count() const
+{
+	return mode == Mode::Bindless ? handles.size() : layer_count;
+}
+
+uint32_t SkinSet::get_capacity() const
+{
+	return capacity;
+}
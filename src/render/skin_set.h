@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "sampler_cache.h"
+
+class Texture;
+class TextureArray;
+class VBO;
+
+// The skins a crowd is drawn with, selected per instance (InstanceData::skin) so avatars with
+// different skins still go out in one instanced draw. Skins are either copied into the layers of
+// a texture array, which requires them to share size, format and mip count, or, with
+// ARB_bindless_texture, referenced through resident handles in a shader storage buffer.
+class SkinSet
+{
+public:
+	enum class Mode
+	{
+		Array,
+		Bindless
+	};
+
+	// Must match the binding of the SkinHandles block in skinned_bindless.frag.
+	static constexpr uint32_t BINDING = 3;
+
+	static bool is_bindless_supported();
+
+	SkinSet(Mode mode, SamplerPtr_t sampler, uint32_t capacity);
+	~SkinSet();
+
+	// Returns the index instances select the skin with. Skins that don't fit (the set is full or,
+	// in array mode, the layout differs from the first skin) are reported and fall back to skin 0.
+	uint32_t add(std::shared_ptr<Texture> texture);
+
+	// Puts texture in place of skin index, e.g. when its file was edited. In array mode it has to match the layout
+	// of the layers; returns false, leaving the skin alone, if it doesn't.
+	bool replace(uint32_t index, std::shared_ptr<Texture> texture);
+
+	// Binds the array and sampler at unit 0 or the handle buffer, for the fragment shader of get_mode().
+	void bind() const;
+	void unbind() const;
+
+	Mode get_mode() const;
+	uint32_t get_count() const;
+	uint32_t get_capacity() const;
+
+private:
+	Mode mode;
+	SamplerPtr_t sampler;
+	uint32_t capacity;
+
+	// Array mode; created with the layout of the first skin.
+	std::unique_ptr<TextureArray> array;
+	uint32_t layer_count{0};
+
+	// Bindless mode; the textures are kept alive for as long as their handles are resident.
+	std::vector<std::shared_ptr<Texture>> textures;
+	std::vector<uint64_t> handles;
+	std::shared_ptr<VBO> handle_buffer;
+
+	// Replaced skins, resident until the set goes away: frames still in flight may sample them.
+	std::vector<std::shared_ptr<Texture>> retired_textures;
+	std::vector<uint64_t> retired_handles;
+
+	SkinSet(const SkinSet&) = delete;
+	SkinSet& operator=(const SkinSet&) = delete;
+};
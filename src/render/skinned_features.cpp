@@ -0,0 +1,46 @@
+#include "skinned_features.h"
+
+#include "../assets/packed_vertex.h"
+
+#include <algorithm>
+
+namespace skinned_features
+{
+	const std::vector<std::string>& get_defines()
+	{
+		static const std::vector<std::string> defines = { "BONE_INFLUENCES 0", "BONE_INFLUENCES 1", "BONE_INFLUENCES 2", "BAKED_PALETTES", "DUAL_QUATERNIONS" };
+
+		return defines;
+	}
+
+	uint32_t from_influences(uint32_t influences)
+	{
+		switch (influences)
+		{
+		case 0: return Rigid;
+		case 1: return OneInfluence;
+		case 2: return TwoInfluences;
+		default: return 0;
+		}
+	}
+
+	uint32_t get_max_influences(const PackedVertex* vertices, uint32_t count)
+	{
+		uint32_t max_influences = 0;
+
+		for (uint32_t i = 0; i < count && max_influences < 4; i++)
+		{
+			// Up to the last weighted joint, wherever the zeros are.
+			for (uint32_t j = 4; j > max_influences; j--)
+			{
+				if (vertices[i].weights[j - 1] > 0)
+				{
+					max_influences = j;
+					break;
+				}
+			}
+		}
+
+		return max_influences;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct PackedVertex;
+
+// Feature bits of the skinned shaders (skinned_instanced.vert, skinning.comp) for ShaderVariants. The influence bits
+// exclude each other, without any of them all four joints are blended.
+namespace skinned_features
+{
+	enum : uint32_t
+	{
+		Rigid = 1 << 0,
+		OneInfluence = 1 << 1,
+		TwoInfluences = 1 << 2,
+
+		// Palettes of a PoseCache instead of the AnimationWorld's, skinned_instanced.vert only.
+		BakedPalettes = 1 << 3,
+
+		// Dual quaternion skinning from a PaletteBuffer in Format::DualQuaternions: no collapsing joints, and palettes
+		// half the size of matrices, which saves bandwidth once nothing reads the matrices. Scale in the palettes is
+		// lost. Not together with BakedPalettes.
+		DualQuaternions = 1 << 4,
+	};
+
+	// The defines of the bits above, in order.
+	const std::vector<std::string>& get_defines();
+
+	// The cheapest influence bits that still blend the given number of joints per vertex.
+	uint32_t from_influences(uint32_t influences);
+
+	// Most joints any of the vertices is weighted to, 0 if none of them is skinned.
+	uint32_t get_max_influences(const PackedVertex* vertices, uint32_t count);
+}
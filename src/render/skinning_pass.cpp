@@ -0,0 +1,94 @@
+#include "skinning_pass.h"
+#include "skinned_features.h"
+
+#include "xyapi/gl/shader_variants.h"
+#include "xyapi/gl/vbo.h"
+
+#include "../shaders/skinning.comp.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+
+// Output vertex: position, uv and normal as tightly packed floats.
+static constexpr uint32_t SKINNED_VERTEX_SIZE = sizeof(float) * 8;
+
+bool SkinningPass::is_supported()
+{
+	return Shader::is_compute_supported();
+}
+
+SkinningPass::SkinningPass(std::shared_ptr<VBO> source_vertices, uint32_t first_vertex, uint32_t vertex_count, const QuantizationBounds& bounds, uint32_t features) : features{features}, source{std::move(source_vertices)}, first_vertex{first_vertex}, vertex_count{vertex_count}, bounds{bounds}
+{
+	shader = std::make_unique<Shader>(ShaderVariants::get_source(skinning_comp, skinned_features::get_defines(), features));
+}
+
+SkinningPass::~SkinningPass() = default;
+
+void SkinningPass::dispatch(const std::vector<uint32_t>& palette_offsets)
+{
+	const uint32_t instance_count = palette_offsets.size();
+
+	if (instance_count == 0)
+		return;
+
+	if (instance_count > instance_capacity || !output)
+	{
+		instance_capacity = std::max(instance_count, instance_capacity * 2);
+		output = std::make_shared<VBO>(-1, VBO::Type::ShaderStorage, VBO::Usage::Dynamic, instance_capacity * vertex_count, SKINNED_VERTEX_SIZE, nullptr);
+		instances = std::make_shared<VBO>(-1, VBO::Type::ShaderStorage, VBO::Usage::Dynamic, instance_capacity, sizeof(uint32_t), nullptr);
+	}
+
+	instances->bind();
+		instances->update(palette_offsets.data(), instance_count);
+	instances->unbind();
+
+	if (reloaded && reloaded->is_ready())
+	{
+		if (reloaded->is_linked())
+		{
+			shader = std::move(reloaded);
+			uniforms_set = false;
+		}
+
+		reloaded.reset();
+	}
+
+	shader->bind();
+
+		// Program uniforms keep their values, only the instances change between dispatches.
+		if (!uniforms_set)
+		{
+			shader->set_uniform_int(shader->get_uniform("u_source_offset"), first_vertex);
+			shader->set_uniform_int(shader->get_uniform("u_vertex_count"), vertex_count);
+			shader->set_uniform_vec3(shader->get_uniform("u_position_offset"), &bounds.offset[0]);
+			shader->set_uniform_vec3(shader->get_uniform("u_position_scale"), &bounds.scale[0]);
+			uniforms_set = true;
+		}
+
+		source->bind_storage(SOURCE_BINDING);
+		output->bind_base(OUTPUT_BINDING);
+		instances->bind_base(INSTANCE_BINDING);
+
+		shader->dispatch((vertex_count + GROUP_SIZE - 1) / GROUP_SIZE, instance_count);
+	shader->unbind();
+
+	// Later draws read the results through storage blocks.
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void SkinningPass::bind_output(uint32_t binding) const
+{
+	if (output)
+		output->bind_base(binding);
+}
+
+void SkinningPass::reload(const std::string& code)
+{
+	reloaded = std::make_unique<Shader>(ShaderVariants::get_source(code, skinned_features::get_defines(), features));
+}
+
+uint32_t SkinningPass::get_vertex_count() const
+{
+	return vertex_count;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "xyapi/gl/shader.h"
+
+#include "../assets/packed_vertex.h"
+
+class VBO;
+
+// Optional compute pre-pass: skins the instances of a mesh that are drawn with it once per frame into a cached buffer,
+// so later passes (main view, shadows, reflections) draw it as a static mesh through skinned_vertices.vert.
+// Needs GL 4.3; without it callers keep skinning in the vertex shader.
+class SkinningPass
+{
+public:
+	// Must match the bindings in skinning.comp and skinned_vertices.vert.
+	static constexpr uint32_t SOURCE_BINDING = 1;
+	static constexpr uint32_t OUTPUT_BINDING = 2;
+	static constexpr uint32_t INSTANCE_BINDING = 7;
+
+	static constexpr uint32_t GROUP_SIZE = 64;
+
+	static bool is_supported();
+
+	// source_vertices holds PackedVertex data quantized against bounds, the mesh starts at first_vertex.
+	// Instance i of a dispatch is written at i * get_vertex_count() in the output (InstanceData::vertex_offset).
+	// features are skinned_features influence and palette bits that fit the mesh.
+	SkinningPass(std::shared_ptr<VBO> source_vertices, uint32_t first_vertex, uint32_t vertex_count, const QuantizationBounds& bounds, uint32_t features = 0);
+	~SkinningPass();
+
+	// Skins one instance per entry of palette_offsets, each where its palette starts in the bound palette buffer,
+	// e.g. only the visible instances that are drawn with this mesh. Nothing is dispatched for none.
+	void dispatch(const std::vector<uint32_t>& palette_offsets);
+
+	void bind_output(uint32_t binding = OUTPUT_BINDING) const;
+
+	// Builds skinning.comp from new source; dispatches use it once it's ready, or keep the old one if it failed.
+	void reload(const std::string& code);
+
+	uint32_t get_vertex_count() const;
+
+private:
+	std::unique_ptr<Shader> shader;
+	std::unique_ptr<Shader> reloaded;
+	uint32_t features;
+
+	// Set by the first dispatch, they stay the same for the mesh.
+	bool uniforms_set{false};
+
+	std::shared_ptr<VBO> source;
+	std::shared_ptr<VBO> output;
+
+	// Palette offset of every instance of the last dispatch, room for instance_capacity.
+	std::shared_ptr<VBO> instances;
+
+	uint32_t first_vertex;
+	uint32_t vertex_count;
+	uint32_t instance_capacity{0};
+
+	QuantizationBounds bounds;
+
+	SkinningPass(const SkinningPass&) = delete;
+	SkinningPass& operator=(const SkinningPass&) = delete;
+};
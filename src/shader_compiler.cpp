@@ -1,8 +1,14 @@
 #include "files/files.h"
 
+#include "core/jobs/job_system.h"
+
 #include "common.h"
 
-const std::vector<std::string> SHADER_FORMATS = { "vert", "frag" };
+#include <algorithm>
+#include <atomic>
+
+// Anything else, e.g. .glsl files pulled in through #include, is only compiled as part of the shaders including it.
+const std::vector<std::string> SHADER_FORMATS = { "vert", "frag", "comp" };
 
 bool is_shader(const std::string& format)
 {
@@ -13,17 +19,12 @@ bool is_shader(const std::string& format)
 	return false;
 }
 
+std::vector<std::string> shader_paths;
+
 void file_callback(const std::string& entry)
 {
-	const std::string& type = files::get_type(entry);
-
-	if (is_shader(type))
-	{
-		const std::string content = files::read(entry);
-
-		const std::string header_path = entry + ".h";
-		files::write(header_path, content);
-	}
+	if (is_shader(files::get_type(entry)))
+		shader_paths.push_back(entry);
 }
 
 void directory_callback(const std::string& entry)
@@ -31,14 +32,57 @@ void directory_callback(const std::string& entry)
 	files::recursive_loop(entry, directory_callback, file_callback);
 }
 
-void compile_shaders()
+// Every shader under src is expanded and embedded into a header next to it. Headers that would come out the same
+// aren't touched, so a change to one shader, or to an include, only rebuilds what embeds the shaders affected;
+// --force rewrites all of them.
+bool compile_shaders()
 {
 	spdlog::info("Compiling shaders..");
 
-	const std::string path = get_arguments()[0];
+	const std::vector<std::string>& args = get_arguments();
+
+	const std::string path = args[0];
 	const std::string src = path.substr(0, path.find("build")) + "src";
-	
+
+	const bool force = std::find(args.begin(), args.end(), "--force") != args.end();
+
+	shader_paths.clear();
 	files::recursive_loop(src, directory_callback, file_callback);
+
+	std::atomic<uint32_t> written{0};
+	std::atomic<uint32_t> failed{0};
+
+	JobSystem job_system;
+
+	job_system.parallel_for(shader_paths.size(), 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const std::string& shader_path = shader_paths[i];
+
+			std::string content;
+
+			if (!files::expand_includes(shader_path, content))
+			{
+				failed++;
+				continue;
+			}
+
+			const std::string header_path = shader_path + ".h";
+
+			if (force)
+				files::write(header_path, content);
+			else if (!files::write_if_changed(header_path, content))
+				continue;
+
+			spdlog::info("Wrote {0}", header_path);
+			written++;
+		}
+	});
+
+	spdlog::info("{0} of {1} shader headers written, {2} failed", written.load(), shader_paths.size(), failed.load());
+
+	return failed == 0;
 }
 
 #ifdef COMPILE_SHADERS
@@ -46,6 +90,6 @@ int main(int argc, char* argv[])
 {
 	arguments(argc, argv);
 
-	compile_shaders();
+	return compile_shaders() ? 0 : 1;
 }
-#endif
\ No newline at end of file
+#endif
@@ -13,18 +13,21 @@ out struct {
 	vec2 uv;
 } vs_out;
 
-const int MAX_BONES = 100;
+layout (std430, binding = 0) readonly buffer BonePalette
+{
+	mat4 u_bones[];
+};
 
 uniform mat4 u_model;
 uniform mat4 u_proj;
-uniform mat4 u_bones[MAX_BONES];
+uniform int u_bone_offset;
 
 void main()
 {	
-	mat4 bone_transform = u_bones[in_bone_indices[0]] * in_weights[0];
-		bone_transform += u_bones[in_bone_indices[1]] * in_weights[1];
-		bone_transform += u_bones[in_bone_indices[2]] * in_weights[2];
-		bone_transform += u_bones[in_bone_indices[3]] * in_weights[3];
+	mat4 bone_transform = u_bones[u_bone_offset + in_bone_indices[0]] * in_weights[0];
+		bone_transform += u_bones[u_bone_offset + in_bone_indices[1]] * in_weights[1];
+		bone_transform += u_bones[u_bone_offset + in_bone_indices[2]] * in_weights[2];
+		bone_transform += u_bones[u_bone_offset + in_bone_indices[3]] * in_weights[3];
 
 	gl_Position = 
 		u_proj * 
@@ -0,0 +1,27 @@
+// Matches struct DualQuaternion in dual_quaternion.h: the rotation, then half the translation times the rotation, both xyzw.
+struct DualQuaternion
+{
+	vec4 real;
+	vec4 dual;
+};
+
+// Normalises a blend of unit dual quaternions and turns it into the rigid transform it stands for.
+mat4 to_matrix(DualQuaternion dq)
+{
+	float len = length(dq.real);
+	vec4 r = dq.real / len;
+	vec4 d = dq.dual / len;
+
+	// Twice the vector part of dual * conjugate(real).
+	vec3 t = 2.0 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz));
+
+	float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+	float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+	float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+	return mat4(
+		1.0 - 2.0 * (yy + zz), 2.0 * (xy + wz), 2.0 * (xz - wy), 0.0,
+		2.0 * (xy - wz), 1.0 - 2.0 * (xx + zz), 2.0 * (yz + wx), 0.0,
+		2.0 * (xz + wy), 2.0 * (yz - wx), 1.0 - 2.0 * (xx + yy), 0.0,
+		t, 1.0);
+}
@@ -0,0 +1,5 @@
+// Matches struct FrameData in instance_data.h, uploaded once per RenderQueue flush for all of its draws.
+layout (std140, binding = 0) uniform Frame
+{
+	mat4 u_proj;
+};
\ No newline at end of file
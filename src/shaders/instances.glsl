@@ -0,0 +1,19 @@
+// Matches struct InstanceData in instance_data.h, indexed by the instance's position in the RenderQueue flush.
+struct Instance
+{
+	mat4 model;
+	vec4 position_offset;
+	vec4 position_scale;
+	uint skin;
+	uint bone_offset;
+	uint vertex_offset;
+	uint base_vertex;
+	uint next_bone_offset;
+	float frame_blend;
+	uint padding[2];
+};
+
+layout (std430, binding = 4) readonly buffer Instances
+{
+	Instance u_instances[];
+};
\ No newline at end of file
@@ -0,0 +1,22 @@
+#include <vector> 
+#include <string> 
+inline static const std::string skinned_array_frag = R""""( 
+#version 440 core
+
+in struct {
+	vec2 uv;
+} vs_out;
+
+flat in uint vs_skin;
+
+out vec4 out_color;
+
+// One layer per skin, see SkinSet.
+uniform sampler2DArray u_skins;
+
+void main()
+{
+	out_color = texture(u_skins, vec3(vs_out.uv, float(vs_skin)));
+}
+
+)"""";
\ No newline at end of file
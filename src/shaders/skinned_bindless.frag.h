@@ -0,0 +1,26 @@
+#include <vector> 
+#include <string> 
+inline static const std::string skinned_bindless_frag = R""""( 
+#version 440 core
+#extension GL_ARB_bindless_texture : require
+
+in struct {
+	vec2 uv;
+} vs_out;
+
+flat in uint vs_skin;
+
+out vec4 out_color;
+
+// Resident texture handles of the skins, see SkinSet.
+layout (std430, binding = 3) readonly buffer SkinHandles
+{
+	uvec2 u_skins[];
+};
+
+void main()
+{
+	out_color = texture(sampler2D(u_skins[vs_skin]), vs_out.uv);
+}
+
+)"""";
\ No newline at end of file
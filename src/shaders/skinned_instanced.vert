@@ -0,0 +1,94 @@
+#version 440 core
+
+// Palettes come from the AnimationWorld, or with BAKED_PALETTES from a PoseCache; see skinned_features for the variants.
+// PackedVertex: position and weights arrive normalized, the normal oct-encoded, joint indices as integers.
+layout (location = 0) in  vec3 in_position;
+layout (location = 1) in  vec2 in_uv;
+layout (location = 2) in  vec2 in_normal;
+layout (location = 3) in uvec4 in_bone_indices;
+layout (location = 4) in  vec4 in_weights;
+
+// Base instance of the draw plus gl_InstanceID, fed through an instanced 0, 1, 2, ... attribute.
+layout (location = 5) in  uint in_instance;
+
+out struct {
+	vec2 uv;
+} vs_out;
+
+flat out uint vs_skin;
+
+#include "instances.glsl"
+#include "frame.glsl"
+
+#ifdef BAKED_PALETTES
+// Every frame of the baked clips back to back, see PoseCache.
+layout (std430, binding = 5) readonly buffer BakedPalettes
+{
+	mat4 u_frames[];
+};
+
+int frame;
+int next_frame;
+float frame_blend;
+
+// Between the two frames around the instance's time.
+mat4 get_bone(int joint)
+{
+	return u_frames[frame + joint] * (1.0 - frame_blend) + u_frames[next_frame + joint] * frame_blend;
+}
+#elif defined(DUAL_QUATERNIONS)
+#include "dual_quaternion.glsl"
+
+// The AnimationWorld's palettes converted on the CPU, half the size of matrices; see PaletteBuffer.
+layout (std430, binding = 6) readonly buffer DualQuaternionPalette
+{
+	DualQuaternion u_bones[];
+};
+
+int palette;
+
+DualQuaternion get_bone(int joint)
+{
+	return u_bones[palette + joint];
+}
+#else
+layout (std430, binding = 0) readonly buffer BonePalette
+{
+	mat4 u_bones[];
+};
+
+int palette;
+
+mat4 get_bone(int joint)
+{
+	return u_bones[palette + joint];
+}
+#endif
+
+#include "skinning.glsl"
+
+void main()
+{	
+	Instance instance = u_instances[in_instance];
+
+#ifdef BAKED_PALETTES
+	frame = int(instance.bone_offset);
+	next_frame = int(instance.next_bone_offset);
+	frame_blend = instance.frame_blend;
+#else
+	palette = int(instance.bone_offset);
+#endif
+
+	mat4 bone_transform = skin(ivec4(in_bone_indices), in_weights);
+
+	// Undoes the snorm16 quantization of positions against the mesh bounds.
+	vec3 position = instance.position_offset.xyz + instance.position_scale.xyz * in_position;
+
+	gl_Position = 
+		u_proj * 
+		instance.model * 
+		bone_transform * 
+		vec4(position, 1.0);
+	vs_skin = instance.skin;
+	vs_out.uv = in_uv;
+}
\ No newline at end of file
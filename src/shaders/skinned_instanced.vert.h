@@ -0,0 +1,206 @@
+#include <vector> 
+#include <string> 
+inline static const std::string skinned_instanced_vert = R""""( 
+#version 440 core
+
+// Palettes come from the AnimationWorld, or with BAKED_PALETTES from a PoseCache; see skinned_features for the variants.
+// PackedVertex: position and weights arrive normalized, the normal oct-encoded, joint indices as integers.
+layout (location = 0) in  vec3 in_position;
+layout (location = 1) in  vec2 in_uv;
+layout (location = 2) in  vec2 in_normal;
+layout (location = 3) in uvec4 in_bone_indices;
+layout (location = 4) in  vec4 in_weights;
+
+// Base instance of the draw plus gl_InstanceID, fed through an instanced 0, 1, 2, ... attribute.
+layout (location = 5) in  uint in_instance;
+
+out struct {
+	vec2 uv;
+} vs_out;
+
+flat out uint vs_skin;
+
+// 1: instances.glsl
+#line 1 1
+// Matches struct InstanceData in instance_data.h, indexed by the instance's position in the RenderQueue flush.
+struct Instance
+{
+	mat4 model;
+	vec4 position_offset;
+	vec4 position_scale;
+	uint skin;
+	uint bone_offset;
+	uint vertex_offset;
+	uint base_vertex;
+	uint next_bone_offset;
+	float frame_blend;
+	uint padding[2];
+};
+
+layout (std430, binding = 4) readonly buffer Instances
+{
+	Instance u_instances[];
+};
+#line 21 0
+// 2: frame.glsl
+#line 1 2
+// Matches struct FrameData in instance_data.h, uploaded once per RenderQueue flush for all of its draws.
+layout (std140, binding = 0) uniform Frame
+{
+	mat4 u_proj;
+};
+#line 22 0
+
+#ifdef BAKED_PALETTES
+// Every frame of the baked clips back to back, see PoseCache.
+layout (std430, binding = 5) readonly buffer BakedPalettes
+{
+	mat4 u_frames[];
+};
+
+int frame;
+int next_frame;
+float frame_blend;
+
+// Between the two frames around the instance's time.
+mat4 get_bone(int joint)
+{
+	return u_frames[frame + joint] * (1.0 - frame_blend) + u_frames[next_frame + joint] * frame_blend;
+}
+#elif defined(DUAL_QUATERNIONS)
+// 3: dual_quaternion.glsl
+#line 1 3
+// Matches struct DualQuaternion in dual_quaternion.h: the rotation, then half the translation times the rotation, both xyzw.
+struct DualQuaternion
+{
+	vec4 real;
+	vec4 dual;
+};
+
+// Normalises a blend of unit dual quaternions and turns it into the rigid transform it stands for.
+mat4 to_matrix(DualQuaternion dq)
+{
+	float len = length(dq.real);
+	vec4 r = dq.real / len;
+	vec4 d = dq.dual / len;
+
+	// Twice the vector part of dual * conjugate(real).
+	vec3 t = 2.0 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz));
+
+	float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+	float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+	float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+	return mat4(
+		1.0 - 2.0 * (yy + zz), 2.0 * (xy + wz), 2.0 * (xz - wy), 0.0,
+		2.0 * (xy - wz), 1.0 - 2.0 * (xx + zz), 2.0 * (yz + wx), 0.0,
+		2.0 * (xz + wy), 2.0 * (yz - wx), 1.0 - 2.0 * (xx + yy), 0.0,
+		t, 1.0);
+}
+#line 41 0
+
+// The AnimationWorld's palettes converted on the CPU, half the size of matrices; see PaletteBuffer.
+layout (std430, binding = 6) readonly buffer DualQuaternionPalette
+{
+	DualQuaternion u_bones[];
+};
+
+int palette;
+
+DualQuaternion get_bone(int joint)
+{
+	return u_bones[palette + joint];
+}
+#else
+layout (std430, binding = 0) readonly buffer BonePalette
+{
+	mat4 u_bones[];
+};
+
+int palette;
+
+mat4 get_bone(int joint)
+{
+	return u_bones[palette + joint];
+}
+#endif
+
+// 4: skinning.glsl
+#line 1 4
+// Blends the joints of a vertex; the including shader declares mat4 get_bone(int joint) before it, with
+// DUAL_QUATERNIONS DualQuaternion get_bone(int joint) from dual_quaternion.glsl instead.
+// BONE_INFLUENCES is how many of the four joints are read, from the skinned_features variant: vertices keep their
+// weights sorted, so on meshes it was picked for the ones left out are zero. 0 is a rigid mesh, 1 needs no weights.
+#ifndef BONE_INFLUENCES
+#define BONE_INFLUENCES 4
+#endif
+
+#ifdef DUAL_QUATERNIONS
+// Joints on the other hemisphere than the ones before are flipped, so the blend takes the short way around.
+void add_bone(inout DualQuaternion sum, int joint, float weight)
+{
+	DualQuaternion bone = get_bone(joint);
+
+	float signed_weight = dot(sum.real, bone.real) < 0.0 ? -weight : weight;
+
+	sum.real += bone.real * signed_weight;
+	sum.dual += bone.dual * signed_weight;
+}
+#endif
+
+mat4 skin(ivec4 joints, vec4 weights)
+{
+#if BONE_INFLUENCES == 0
+	return mat4(1.0);
+#elif defined(DUAL_QUATERNIONS) && BONE_INFLUENCES == 1
+	return to_matrix(get_bone(joints[0]));
+#elif defined(DUAL_QUATERNIONS)
+	DualQuaternion sum = DualQuaternion(vec4(0.0), vec4(0.0));
+	add_bone(sum, joints[0], weights[0]);
+	add_bone(sum, joints[1], weights[1]);
+#if BONE_INFLUENCES == 4
+	add_bone(sum, joints[2], weights[2]);
+	add_bone(sum, joints[3], weights[3]);
+#endif
+	return to_matrix(sum);
+#elif BONE_INFLUENCES == 1
+	return get_bone(joints[0]);
+#else
+	mat4 transform = get_bone(joints[0]) * weights[0];
+		transform += get_bone(joints[1]) * weights[1];
+#if BONE_INFLUENCES == 4
+		transform += get_bone(joints[2]) * weights[2];
+		transform += get_bone(joints[3]) * weights[3];
+#endif
+	return transform;
+#endif
+}
+#line 69 0
+
+void main()
+{	
+	Instance instance = u_instances[in_instance];
+
+#ifdef BAKED_PALETTES
+	frame = int(instance.bone_offset);
+	next_frame = int(instance.next_bone_offset);
+	frame_blend = instance.frame_blend;
+#else
+	palette = int(instance.bone_offset);
+#endif
+
+	mat4 bone_transform = skin(ivec4(in_bone_indices), in_weights);
+
+	// Undoes the snorm16 quantization of positions against the mesh bounds.
+	vec3 position = instance.position_offset.xyz + instance.position_scale.xyz * in_position;
+
+	gl_Position = 
+		u_proj * 
+		instance.model * 
+		bone_transform * 
+		vec4(position, 1.0);
+	vs_skin = instance.skin;
+	vs_out.uv = in_uv;
+}
+
+)"""";
\ No newline at end of file
@@ -0,0 +1,40 @@
+#version 440 core
+
+// Draws vertices already skinned by skinning.comp, pulled by instance and index instead of through attributes.
+layout (location = 5) in uint in_instance;
+
+out struct {
+	vec2 uv;
+} vs_out;
+
+flat out uint vs_skin;
+
+struct SkinnedVertex
+{
+	float position[3];
+	float uv[2];
+	float normal[3];
+};
+
+layout (std430, binding = 2) readonly buffer SkinnedVertices
+{
+	SkinnedVertex u_skinned[];
+};
+
+#include "instances.glsl"
+#include "frame.glsl"
+
+void main()
+{
+	Instance instance = u_instances[in_instance];
+
+	// gl_VertexID includes the base vertex of the mesh in the shared vertex buffer.
+	SkinnedVertex vertex = u_skinned[instance.vertex_offset + uint(gl_VertexID) - instance.base_vertex];
+
+	gl_Position = 
+		u_proj * 
+		instance.model * 
+		vec4(vertex.position[0], vertex.position[1], vertex.position[2], 1.0);
+	vs_skin = instance.skin;
+	vs_out.uv = vec2(vertex.uv[0], vertex.uv[1]);
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include <vector> 
+#include <string> 
+inline static const std::string skinned_vertices_vert = R""""( 
+#version 440 core
+
+// Draws vertices already skinned by skinning.comp, pulled by instance and index instead of through attributes.
+layout (location = 5) in uint in_instance;
+
+out struct {
+	vec2 uv;
+} vs_out;
+
+flat out uint vs_skin;
+
+struct SkinnedVertex
+{
+	float position[3];
+	float uv[2];
+	float normal[3];
+};
+
+layout (std430, binding = 2) readonly buffer SkinnedVertices
+{
+	SkinnedVertex u_skinned[];
+};
+
+// 1: instances.glsl
+#line 1 1
+// Matches struct InstanceData in instance_data.h, indexed by the instance's position in the RenderQueue flush.
+struct Instance
+{
+	mat4 model;
+	vec4 position_offset;
+	vec4 position_scale;
+	uint skin;
+	uint bone_offset;
+	uint vertex_offset;
+	uint base_vertex;
+	uint next_bone_offset;
+	float frame_blend;
+	uint padding[2];
+};
+
+layout (std430, binding = 4) readonly buffer Instances
+{
+	Instance u_instances[];
+};
+#line 25 0
+// 2: frame.glsl
+#line 1 2
+// Matches struct FrameData in instance_data.h, uploaded once per RenderQueue flush for all of its draws.
+layout (std140, binding = 0) uniform Frame
+{
+	mat4 u_proj;
+};
+#line 26 0
+
+void main()
+{
+	Instance instance = u_instances[in_instance];
+
+	// gl_VertexID includes the base vertex of the mesh in the shared vertex buffer.
+	SkinnedVertex vertex = u_skinned[instance.vertex_offset + uint(gl_VertexID) - instance.base_vertex];
+
+	gl_Position = 
+		u_proj * 
+		instance.model * 
+		vec4(vertex.position[0], vertex.position[1], vertex.position[2], 1.0);
+	vs_skin = instance.skin;
+	vs_out.uv = vec2(vertex.uv[0], vertex.uv[1]);
+}
+
+)"""";
\ No newline at end of file
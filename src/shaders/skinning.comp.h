@@ -0,0 +1,194 @@
+#include <vector> 
+#include <string> 
+inline static const std::string skinning_comp = R""""( 
+#version 440 core
+
+layout (local_size_x = 64) in;
+
+// Matches struct PackedVertex in packed_vertex.h, read as six uints:
+// snorm16 position xy, position z, half uv, oct-encoded snorm16 normal, uint8 joint ids, unorm8 weights.
+const int SOURCE_STRIDE = 6;
+
+struct SkinnedVertex
+{
+	float position[3];
+	float uv[2];
+	float normal[3];
+};
+
+#ifdef DUAL_QUATERNIONS
+// 1: dual_quaternion.glsl
+#line 1 1
+// Matches struct DualQuaternion in dual_quaternion.h: the rotation, then half the translation times the rotation, both xyzw.
+struct DualQuaternion
+{
+	vec4 real;
+	vec4 dual;
+};
+
+// Normalises a blend of unit dual quaternions and turns it into the rigid transform it stands for.
+mat4 to_matrix(DualQuaternion dq)
+{
+	float len = length(dq.real);
+	vec4 r = dq.real / len;
+	vec4 d = dq.dual / len;
+
+	// Twice the vector part of dual * conjugate(real).
+	vec3 t = 2.0 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz));
+
+	float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+	float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+	float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+	return mat4(
+		1.0 - 2.0 * (yy + zz), 2.0 * (xy + wz), 2.0 * (xz - wy), 0.0,
+		2.0 * (xy - wz), 1.0 - 2.0 * (xx + zz), 2.0 * (yz + wx), 0.0,
+		2.0 * (xz + wy), 2.0 * (yz - wx), 1.0 - 2.0 * (xx + yy), 0.0,
+		t, 1.0);
+}
+#line 18 0
+
+layout (std430, binding = 6) readonly buffer DualQuaternionPalette
+{
+	DualQuaternion u_bones[];
+};
+#else
+layout (std430, binding = 0) readonly buffer BonePalette
+{
+	mat4 u_bones[];
+};
+#endif
+
+layout (std430, binding = 1) readonly buffer SourceVertices
+{
+	uint u_source[];
+};
+
+layout (std430, binding = 2) writeonly buffer SkinnedVertices
+{
+	SkinnedVertex u_skinned[];
+};
+
+// Where the palette of every dispatched instance starts.
+layout (std430, binding = 7) readonly buffer Instances
+{
+	uint u_palette_offsets[];
+};
+
+int palette;
+
+#ifdef DUAL_QUATERNIONS
+DualQuaternion get_bone(int joint)
+#else
+mat4 get_bone(int joint)
+#endif
+{
+	return u_bones[palette + joint];
+}
+
+// 2: skinning.glsl
+#line 1 2
+// Blends the joints of a vertex; the including shader declares mat4 get_bone(int joint) before it, with
+// DUAL_QUATERNIONS DualQuaternion get_bone(int joint) from dual_quaternion.glsl instead.
+// BONE_INFLUENCES is how many of the four joints are read, from the skinned_features variant: vertices keep their
+// weights sorted, so on meshes it was picked for the ones left out are zero. 0 is a rigid mesh, 1 needs no weights.
+#ifndef BONE_INFLUENCES
+#define BONE_INFLUENCES 4
+#endif
+
+#ifdef DUAL_QUATERNIONS
+// Joints on the other hemisphere than the ones before are flipped, so the blend takes the short way around.
+void add_bone(inout DualQuaternion sum, int joint, float weight)
+{
+	DualQuaternion bone = get_bone(joint);
+
+	float signed_weight = dot(sum.real, bone.real) < 0.0 ? -weight : weight;
+
+	sum.real += bone.real * signed_weight;
+	sum.dual += bone.dual * signed_weight;
+}
+#endif
+
+mat4 skin(ivec4 joints, vec4 weights)
+{
+#if BONE_INFLUENCES == 0
+	return mat4(1.0);
+#elif defined(DUAL_QUATERNIONS) && BONE_INFLUENCES == 1
+	return to_matrix(get_bone(joints[0]));
+#elif defined(DUAL_QUATERNIONS)
+	DualQuaternion sum = DualQuaternion(vec4(0.0), vec4(0.0));
+	add_bone(sum, joints[0], weights[0]);
+	add_bone(sum, joints[1], weights[1]);
+#if BONE_INFLUENCES == 4
+	add_bone(sum, joints[2], weights[2]);
+	add_bone(sum, joints[3], weights[3]);
+#endif
+	return to_matrix(sum);
+#elif BONE_INFLUENCES == 1
+	return get_bone(joints[0]);
+#else
+	mat4 transform = get_bone(joints[0]) * weights[0];
+		transform += get_bone(joints[1]) * weights[1];
+#if BONE_INFLUENCES == 4
+		transform += get_bone(joints[2]) * weights[2];
+		transform += get_bone(joints[3]) * weights[3];
+#endif
+	return transform;
+#endif
+}
+#line 58 0
+
+uniform vec3 u_position_offset;
+uniform vec3 u_position_scale;
+
+// First vertex of the mesh in the source buffer.
+uniform int u_source_offset;
+
+uniform int u_vertex_count;
+
+vec3 oct_decode(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-normal.z, 0.0);
+	normal.xy += vec2(normal.x >= 0.0 ? -t : t, normal.y >= 0.0 ? -t : t);
+	return normalize(normal);
+}
+
+void main()
+{
+	int vertex = int(gl_GlobalInvocationID.x);
+	int instance = int(gl_GlobalInvocationID.y);
+
+	if (vertex >= u_vertex_count)
+		return;
+
+	int base = (u_source_offset + vertex) * SOURCE_STRIDE;
+
+	vec3 quantized_position = vec3(unpackSnorm2x16(u_source[base + 0]), unpackSnorm2x16(u_source[base + 1]).x);
+	vec3 position = u_position_offset + u_position_scale * quantized_position;
+	vec2 uv = unpackHalf2x16(u_source[base + 2]);
+	vec3 normal = oct_decode(unpackSnorm2x16(u_source[base + 3]));
+	uint joints = u_source[base + 4];
+	ivec4 bone_indices = ivec4(joints & 0xffu, (joints >> 8) & 0xffu, (joints >> 16) & 0xffu, joints >> 24);
+	vec4 weights = unpackUnorm4x8(u_source[base + 5]);
+
+	palette = int(u_palette_offsets[instance]);
+
+	mat4 bone_transform = skin(bone_indices, weights);
+
+	vec3 skinned_position = (bone_transform * vec4(position, 1.0)).xyz;
+	vec3 skinned_normal = normalize(mat3(bone_transform) * normal);
+
+	int target = instance * u_vertex_count + vertex;
+
+	u_skinned[target].position[0] = skinned_position.x;
+	u_skinned[target].position[1] = skinned_position.y;
+	u_skinned[target].position[2] = skinned_position.z;
+	u_skinned[target].uv[0] = uv.x;
+	u_skinned[target].uv[1] = uv.y;
+	u_skinned[target].normal[0] = skinned_normal.x;
+	u_skinned[target].normal[1] = skinned_normal.y;
+	u_skinned[target].normal[2] = skinned_normal.z;
+}
+
+)"""";
\ No newline at end of file
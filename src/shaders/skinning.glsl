@@ -0,0 +1,48 @@
+// Blends the joints of a vertex; the including shader declares mat4 get_bone(int joint) before it, with
+// DUAL_QUATERNIONS DualQuaternion get_bone(int joint) from dual_quaternion.glsl instead.
+// BONE_INFLUENCES is how many of the four joints are read, from the skinned_features variant: vertices keep their
+// weights sorted, so on meshes it was picked for the ones left out are zero. 0 is a rigid mesh, 1 needs no weights.
+#ifndef BONE_INFLUENCES
+#define BONE_INFLUENCES 4
+#endif
+
+#ifdef DUAL_QUATERNIONS
+// Joints on the other hemisphere than the ones before are flipped, so the blend takes the short way around.
+void add_bone(inout DualQuaternion sum, int joint, float weight)
+{
+	DualQuaternion bone = get_bone(joint);
+
+	float signed_weight = dot(sum.real, bone.real) < 0.0 ? -weight : weight;
+
+	sum.real += bone.real * signed_weight;
+	sum.dual += bone.dual * signed_weight;
+}
+#endif
+
+mat4 skin(ivec4 joints, vec4 weights)
+{
+#if BONE_INFLUENCES == 0
+	return mat4(1.0);
+#elif defined(DUAL_QUATERNIONS) && BONE_INFLUENCES == 1
+	return to_matrix(get_bone(joints[0]));
+#elif defined(DUAL_QUATERNIONS)
+	DualQuaternion sum = DualQuaternion(vec4(0.0), vec4(0.0));
+	add_bone(sum, joints[0], weights[0]);
+	add_bone(sum, joints[1], weights[1]);
+#if BONE_INFLUENCES == 4
+	add_bone(sum, joints[2], weights[2]);
+	add_bone(sum, joints[3], weights[3]);
+#endif
+	return to_matrix(sum);
+#elif BONE_INFLUENCES == 1
+	return get_bone(joints[0]);
+#else
+	mat4 transform = get_bone(joints[0]) * weights[0];
+		transform += get_bone(joints[1]) * weights[1];
+#if BONE_INFLUENCES == 4
+		transform += get_bone(joints[2]) * weights[2];
+		transform += get_bone(joints[3]) * weights[3];
+#endif
+	return transform;
+#endif
+}
\ No newline at end of file